@@ -23,6 +23,7 @@ using namespace std;
 b2BroadPhase::b2BroadPhase()
 {
 	m_proxyCount = 0;
+	m_deferInsertion = false;
 
 	m_pairCapacity = 16;
 	m_pairCount = 0;
@@ -41,7 +42,7 @@ b2BroadPhase::~b2BroadPhase()
 
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
-	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+	int32 proxyId = m_deferInsertion ? m_tree.CreateUnlinkedProxy(aabb, userData) : m_tree.CreateProxy(aabb, userData);
 	++m_proxyCount;
 	BufferMove(proxyId);
 	return proxyId;
@@ -49,6 +50,7 @@ int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
+	b2Assert(m_deferInsertion == false);
 	UnBufferMove(proxyId);
 	--m_proxyCount;
 	m_tree.DestroyProxy(proxyId);
@@ -56,6 +58,7 @@ void b2BroadPhase::DestroyProxy(int32 proxyId)
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
+	b2Assert(m_deferInsertion == false);
 	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
 	if (buffer)
 	{
@@ -68,6 +71,31 @@ void b2BroadPhase::TouchProxy(int32 proxyId)
 	BufferMove(proxyId);
 }
 
+void b2BroadPhase::SetProxyAABB(int32 proxyId, const b2AABB& aabb)
+{
+	m_tree.SetFatAABB(proxyId, aabb);
+	BufferMove(proxyId);
+}
+
+void b2BroadPhase::RebuildTree()
+{
+	m_tree.Rebuild();
+}
+
+void b2BroadPhase::BeginDeferredInsertion()
+{
+	m_deferInsertion = true;
+}
+
+void b2BroadPhase::EndDeferredInsertion()
+{
+	if (m_deferInsertion)
+	{
+		m_deferInsertion = false;
+		m_tree.Rebuild();
+	}
+}
+
 void b2BroadPhase::BufferMove(int32 proxyId)
 {
 	if (m_moveCount == m_moveCapacity)
@@ -22,6 +22,7 @@
 #include "../Common/b2Settings.h"
 #include "b2Collision.h"
 #include "b2DynamicTree.h"
+#include "b2SimdTree.h"
 #include <algorithm>
 
 struct b2Pair
@@ -60,6 +61,23 @@ public:
 	/// Call to trigger a re-processing of it's pairs on the next call to UpdatePairs.
 	void TouchProxy(int32 proxyId);
 
+	/// Set the AABB of a proxy without updating the tree, for moving many proxies
+	/// at once. Call RebuildTree once they have all been set, the tree must not
+	/// be queried in between. Pairs are reported by the next UpdatePairs.
+	void SetProxyAABB(int32 proxyId, const b2AABB& aabb);
+
+	/// Rebuild the tree from the AABBs of all the proxies.
+	void RebuildTree();
+
+	/// Create proxies without inserting them into the tree, for adding many
+	/// proxies at once. Call EndDeferredInsertion once they have all been
+	/// created, no proxy may be moved or destroyed and the tree must not be
+	/// queried in between.
+	void BeginDeferredInsertion();
+
+	/// Build the tree over the proxies created since BeginDeferredInsertion.
+	void EndDeferredInsertion();
+
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
@@ -103,15 +121,21 @@ public:
 private:
 
 	friend class b2DynamicTree;
+	friend class b2SimdTree;
 
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
 
 	bool QueryCallback(int32 proxyId);
 
+#if B2_SIMD_BROADPHASE
+	b2SimdTree m_tree;
+#else
 	b2DynamicTree m_tree;
+#endif
 
 	int32 m_proxyCount;
+	bool m_deferInsertion;
 
 	int32* m_moveBuffer;
 	int32 m_moveCapacity;
@@ -19,6 +19,7 @@
 #include "b2DynamicTree.h"
 #include <cstring>
 #include <cfloat>
+#include <algorithm>
 using namespace std;
 
 
@@ -121,6 +122,20 @@ int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 	return proxyId;
 }
 
+int32 b2DynamicTree::CreateUnlinkedProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = AllocateNode();
+
+	// Fatten the aabb. The leaf has no parent until the tree is rebuilt.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	m_nodes[proxyId].aabb.lowerBound = aabb.lowerBound - r;
+	m_nodes[proxyId].aabb.upperBound = aabb.upperBound + r;
+	m_nodes[proxyId].userData = userData;
+	m_nodes[proxyId].height = 0;
+
+	return proxyId;
+}
+
 void b2DynamicTree::DestroyProxy(int32 proxyId)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -769,3 +784,114 @@ void b2DynamicTree::RebuildBottomUp()
 
 	Validate();
 }
+
+void b2DynamicTree::SetFatAABB(int32 proxyId, const b2AABB& aabb)
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	b2Assert(m_nodes[proxyId].IsLeaf());
+
+	// Extend AABB.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	m_nodes[proxyId].aabb.lowerBound = aabb.lowerBound - r;
+	m_nodes[proxyId].aabb.upperBound = aabb.upperBound + r;
+}
+
+// A leaf with the center of its AABB, kept together so that splitting the
+// leaves does not have to go back to the node pool.
+struct b2TreeLeaf
+{
+	b2Vec2 center;
+	int32 id;
+};
+
+// Orders leaves by their center along one axis.
+struct b2TreeCenterLess
+{
+	bool operator()(const b2TreeLeaf& a, const b2TreeLeaf& b) const
+	{
+		return a.center(axis) < b.center(axis);
+	}
+
+	int32 axis;
+};
+
+void b2DynamicTree::Rebuild()
+{
+	// Unlinked proxies are leaves outside the tree, so the root may be null.
+	if (m_nodeCount == 0)
+	{
+		return;
+	}
+
+	b2TreeLeaf* leaves = (b2TreeLeaf*)b2Alloc(m_nodeCount * sizeof(b2TreeLeaf));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count].center = m_nodes[i].aabb.GetCenter();
+			leaves[count].id = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	m_root = count > 0 ? BuildTopDown(leaves, count) : b2_nullNode;
+	b2Free(leaves);
+
+	Validate();
+}
+
+int32 b2DynamicTree::BuildTopDown(b2TreeLeaf* leaves, int32 count)
+{
+	if (count == 1)
+	{
+		return leaves[0].id;
+	}
+
+	b2Vec2 lower = leaves[0].center;
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		lower = b2Min(lower, leaves[i].center);
+		upper = b2Max(upper, leaves[i].center);
+	}
+
+	b2TreeCenterLess less;
+	less.axis = (upper.x - lower.x) >= (upper.y - lower.y) ? 0 : 1;
+
+	int32 mid = count / 2;
+	std::nth_element(leaves, leaves + mid, leaves + count, less);
+
+	// Children are built first, allocating the parent may move the node pool.
+	int32 index1 = BuildTopDown(leaves, mid);
+	int32 index2 = BuildTopDown(leaves + mid, count - mid);
+
+	int32 parentIndex = AllocateNode();
+	b2TreeNode* parent = m_nodes + parentIndex;
+	b2TreeNode* child1 = m_nodes + index1;
+	b2TreeNode* child2 = m_nodes + index2;
+
+	parent->child1 = index1;
+	parent->child2 = index2;
+	parent->height = 1 + b2Max(child1->height, child2->height);
+	parent->aabb.Combine(child1->aabb, child2->aabb);
+	parent->parent = b2_nullNode;
+
+	child1->parent = parentIndex;
+	child2->parent = parentIndex;
+
+	return parentIndex;
+}
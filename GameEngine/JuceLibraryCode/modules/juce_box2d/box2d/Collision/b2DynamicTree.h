@@ -58,6 +58,8 @@ struct b2TreeNode
 /// object to move by small amounts without triggering a tree update.
 ///
 /// Nodes are pooled and relocatable, so we use node indices rather than pointers.
+struct b2TreeLeaf;
+
 class b2DynamicTree
 {
 public:
@@ -70,6 +72,10 @@ public:
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create a proxy without inserting it, for adding many proxies at once.
+	/// Rebuild must be called before the tree is used again.
+	int32 CreateUnlinkedProxy(const b2AABB& aabb, void* userData);
+
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
@@ -86,6 +92,10 @@ public:
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
+	/// Set the AABB of a proxy without updating the tree, for moving many proxies
+	/// at once. Rebuild must be called before the tree is used again.
+	void SetFatAABB(int32 proxyId, const b2AABB& aabb);
+
 	/// Query an AABB for overlapping proxies. The callback class
 	/// is called for each proxy that overlaps the supplied AABB.
 	template <typename T>
@@ -118,6 +128,10 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Rebuild the whole tree top-down, splitting each set of leaves at the
+	/// median of the longest axis of their centers. This is O(N log N).
+	void Rebuild();
+
 private:
 
 	int32 AllocateNode();
@@ -128,6 +142,8 @@ private:
 
 	int32 Balance(int32 index);
 
+	int32 BuildTopDown(b2TreeLeaf* leaves, int32 count);
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
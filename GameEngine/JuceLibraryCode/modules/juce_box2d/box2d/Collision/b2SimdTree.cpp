@@ -0,0 +1,915 @@
+#include "b2SimdTree.h"
+#include <cstring>
+#include <cfloat>
+using namespace std;
+
+/// Number of bins used to find a split with the surface area heuristic.
+#define b2_simdTreeBinCount 16
+
+/// The tree is rebuilt when its area ratio grows past the ratio it had after
+/// the last rebuild by this factor.
+#define b2_simdTreeRebuildFactor 1.5f
+
+b2SimdTree::b2SimdTree()
+{
+	m_root = b2_nullNode;
+
+	m_nodeCapacity = 16;
+	m_nodeCount = 0;
+	m_nodes = (b2SimdTreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2SimdTreeNode));
+
+	for (int32 i = 0; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].count = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+	m_nodes[m_nodeCapacity-1].count = -1;
+	m_nodeFreeList = 0;
+
+	m_proxyCapacity = 16;
+	m_proxyCount = 0;
+	m_proxies = (b2SimdTreeProxy*)b2Alloc(m_proxyCapacity * sizeof(b2SimdTreeProxy));
+
+	for (int32 i = 0; i < m_proxyCapacity - 1; ++i)
+	{
+		m_proxies[i].next = i + 1;
+		m_proxies[i].slot = -1;
+	}
+	m_proxies[m_proxyCapacity-1].next = b2_nullNode;
+	m_proxies[m_proxyCapacity-1].slot = -1;
+	m_proxyFreeList = 0;
+
+	m_refitCount = 0;
+	m_builtAreaRatio = 0.0f;
+}
+
+b2SimdTree::~b2SimdTree()
+{
+	b2Free(m_nodes);
+	b2Free(m_proxies);
+}
+
+// Allocate a node from the pool. Grow the pool if necessary.
+int32 b2SimdTree::AllocateNode()
+{
+	if (m_nodeFreeList == b2_nullNode)
+	{
+		b2Assert(m_nodeCount == m_nodeCapacity);
+
+		b2SimdTreeNode* oldNodes = m_nodes;
+		m_nodeCapacity *= 2;
+		m_nodes = (b2SimdTreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2SimdTreeNode));
+		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2SimdTreeNode));
+		b2Free(oldNodes);
+
+		for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
+		{
+			m_nodes[i].next = i + 1;
+			m_nodes[i].count = -1;
+		}
+		m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+		m_nodes[m_nodeCapacity-1].count = -1;
+		m_nodeFreeList = m_nodeCount;
+	}
+
+	int32 nodeId = m_nodeFreeList;
+	b2SimdTreeNode* node = m_nodes + nodeId;
+	m_nodeFreeList = node->next;
+
+	node->parent = b2_nullNode;
+	node->parentSlot = 0;
+	node->count = 0;
+	for (int32 i = 0; i < b2_simdTreeWidth; ++i)
+	{
+		ClearSlot(nodeId, i);
+	}
+
+	++m_nodeCount;
+	return nodeId;
+}
+
+void b2SimdTree::FreeNode(int32 nodeId)
+{
+	b2Assert(0 <= nodeId && nodeId < m_nodeCapacity);
+	b2Assert(0 < m_nodeCount);
+	m_nodes[nodeId].next = m_nodeFreeList;
+	m_nodes[nodeId].count = -1;
+	m_nodeFreeList = nodeId;
+	--m_nodeCount;
+}
+
+int32 b2SimdTree::AllocateProxy()
+{
+	if (m_proxyFreeList == b2_nullNode)
+	{
+		b2Assert(m_proxyCount == m_proxyCapacity);
+
+		b2SimdTreeProxy* oldProxies = m_proxies;
+		m_proxyCapacity *= 2;
+		m_proxies = (b2SimdTreeProxy*)b2Alloc(m_proxyCapacity * sizeof(b2SimdTreeProxy));
+		memcpy(m_proxies, oldProxies, m_proxyCount * sizeof(b2SimdTreeProxy));
+		b2Free(oldProxies);
+
+		for (int32 i = m_proxyCount; i < m_proxyCapacity - 1; ++i)
+		{
+			m_proxies[i].next = i + 1;
+			m_proxies[i].slot = -1;
+		}
+		m_proxies[m_proxyCapacity-1].next = b2_nullNode;
+		m_proxies[m_proxyCapacity-1].slot = -1;
+		m_proxyFreeList = m_proxyCount;
+	}
+
+	int32 proxyId = m_proxyFreeList;
+	m_proxyFreeList = m_proxies[proxyId].next;
+	++m_proxyCount;
+	return proxyId;
+}
+
+void b2SimdTree::FreeProxy(int32 proxyId)
+{
+	b2Assert(0 < m_proxyCount);
+	m_proxies[proxyId].next = m_proxyFreeList;
+	m_proxies[proxyId].slot = -1;
+	m_proxyFreeList = proxyId;
+	--m_proxyCount;
+}
+
+int32 b2SimdTree::CreateProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = AllocateProxy();
+
+	// Fatten the aabb.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	m_proxies[proxyId].aabb.lowerBound = aabb.lowerBound - r;
+	m_proxies[proxyId].aabb.upperBound = aabb.upperBound + r;
+	m_proxies[proxyId].userData = userData;
+
+	InsertLeaf(proxyId);
+	CheckQuality();
+
+	return proxyId;
+}
+
+int32 b2SimdTree::CreateUnlinkedProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = AllocateProxy();
+
+	// Fatten the aabb.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	m_proxies[proxyId].aabb.lowerBound = aabb.lowerBound - r;
+	m_proxies[proxyId].aabb.upperBound = aabb.upperBound + r;
+	m_proxies[proxyId].userData = userData;
+	m_proxies[proxyId].slot = -2;
+
+	return proxyId;
+}
+
+void b2SimdTree::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].slot >= 0);
+
+	RemoveLeaf(proxyId);
+	FreeProxy(proxyId);
+}
+
+bool b2SimdTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].slot >= 0);
+
+	b2SimdTreeProxy* proxy = m_proxies + proxyId;
+
+	if (proxy->aabb.Contains(aabb))
+	{
+		return false;
+	}
+
+	// Extend AABB.
+	b2AABB b = aabb;
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	b.lowerBound = b.lowerBound - r;
+	b.upperBound = b.upperBound + r;
+
+	// Predict AABB displacement.
+	b2Vec2 d = b2_aabbMultiplier * displacement;
+
+	if (d.x < 0.0f)
+	{
+		b.lowerBound.x += d.x;
+	}
+	else
+	{
+		b.upperBound.x += d.x;
+	}
+
+	if (d.y < 0.0f)
+	{
+		b.lowerBound.y += d.y;
+	}
+	else
+	{
+		b.upperBound.y += d.y;
+	}
+
+	proxy->aabb = b;
+
+	// Refit the proxy where it is rather than reinserting it.
+	SetChild(proxy->node, proxy->slot, LeafChild(proxyId), b);
+	Refit(proxy->node);
+
+	CheckQuality();
+
+	return true;
+}
+
+// Inserting and refitting degrade the tree over time, check it every so often.
+void b2SimdTree::CheckQuality()
+{
+	++m_refitCount;
+	if (m_refitCount >= b2Max(m_proxyCount, 64))
+	{
+		m_refitCount = 0;
+
+		if (GetAreaRatio() > b2_simdTreeRebuildFactor * m_builtAreaRatio)
+		{
+			Rebuild();
+		}
+	}
+}
+
+void b2SimdTree::SetChild(int32 nodeId, int32 slot, int32 child, const b2AABB& aabb)
+{
+	b2SimdTreeNode* node = m_nodes + nodeId;
+	node->lowerX[slot] = aabb.lowerBound.x;
+	node->lowerY[slot] = aabb.lowerBound.y;
+	node->upperX[slot] = aabb.upperBound.x;
+	node->upperY[slot] = aabb.upperBound.y;
+	node->child[slot] = child;
+
+	if (IsLeafChild(child))
+	{
+		b2SimdTreeProxy* proxy = m_proxies + ProxyOfChild(child);
+		proxy->node = nodeId;
+		proxy->slot = slot;
+	}
+	else
+	{
+		m_nodes[child].parent = nodeId;
+		m_nodes[child].parentSlot = slot;
+	}
+}
+
+void b2SimdTree::ClearSlot(int32 nodeId, int32 slot)
+{
+	// Inverted bounds never overlap anything.
+	b2SimdTreeNode* node = m_nodes + nodeId;
+	node->lowerX[slot] = FLT_MAX;
+	node->lowerY[slot] = FLT_MAX;
+	node->upperX[slot] = -FLT_MAX;
+	node->upperY[slot] = -FLT_MAX;
+	node->child[slot] = b2_nullNode;
+}
+
+// Removes a child, moving the last child into its slot to keep them packed.
+void b2SimdTree::RemoveSlot(int32 nodeId, int32 slot)
+{
+	b2SimdTreeNode* node = m_nodes + nodeId;
+	b2Assert(0 <= slot && slot < node->count);
+
+	int32 last = node->count - 1;
+	if (slot != last)
+	{
+		SetChild(nodeId, slot, node->child[last], GetSlotAABB(nodeId, last));
+	}
+
+	ClearSlot(nodeId, last);
+	--node->count;
+}
+
+b2AABB b2SimdTree::GetSlotAABB(int32 nodeId, int32 slot) const
+{
+	const b2SimdTreeNode* node = m_nodes + nodeId;
+	b2AABB aabb;
+	aabb.lowerBound.Set(node->lowerX[slot], node->lowerY[slot]);
+	aabb.upperBound.Set(node->upperX[slot], node->upperY[slot]);
+	return aabb;
+}
+
+b2AABB b2SimdTree::ComputeNodeAABB(int32 nodeId) const
+{
+	const b2SimdTreeNode* node = m_nodes + nodeId;
+	b2Assert(node->count > 0);
+
+	b2AABB aabb = GetSlotAABB(nodeId, 0);
+	for (int32 i = 1; i < node->count; ++i)
+	{
+		aabb.Combine(GetSlotAABB(nodeId, i));
+	}
+	return aabb;
+}
+
+// Walk back up the tree, updating the bounds each parent holds for its child.
+void b2SimdTree::Refit(int32 nodeId)
+{
+	while (m_nodes[nodeId].parent != b2_nullNode)
+	{
+		int32 parent = m_nodes[nodeId].parent;
+		int32 slot = m_nodes[nodeId].parentSlot;
+		b2AABB aabb = ComputeNodeAABB(nodeId);
+
+		b2SimdTreeNode* parentNode = m_nodes + parent;
+		if (parentNode->lowerX[slot] == aabb.lowerBound.x && parentNode->lowerY[slot] == aabb.lowerBound.y &&
+			parentNode->upperX[slot] == aabb.upperBound.x && parentNode->upperY[slot] == aabb.upperBound.y)
+		{
+			// Nothing above this node changes.
+			return;
+		}
+
+		SetChild(parent, slot, nodeId, aabb);
+		nodeId = parent;
+	}
+}
+
+void b2SimdTree::InsertLeaf(int32 proxyId)
+{
+	const b2AABB leafAABB = m_proxies[proxyId].aabb;
+
+	if (m_root == b2_nullNode)
+	{
+		m_root = AllocateNode();
+		InsertChild(m_root, LeafChild(proxyId), leafAABB);
+		return;
+	}
+
+	// Descend by the child whose perimeter grows the least (the increase in
+	// surface area cost) until that child is a leaf, then add the new leaf
+	// beside it. Full nodes are split on the way back up, so the tree only
+	// grows in height at the root and stays balanced whatever the order the
+	// proxies are inserted in.
+	int32 nodeId = m_root;
+	for (;;)
+	{
+		const b2SimdTreeNode* node = m_nodes + nodeId;
+
+		int32 best = 0;
+		float32 bestCost = FLT_MAX;
+		float32 bestPerimeter = FLT_MAX;
+		for (int32 i = 0; i < node->count; ++i)
+		{
+			b2AABB childAABB = GetSlotAABB(nodeId, i);
+			float32 perimeter = childAABB.GetPerimeter();
+
+			b2AABB combined;
+			combined.Combine(childAABB, leafAABB);
+			float32 cost = combined.GetPerimeter() - perimeter;
+
+			if (cost < bestCost || (cost == bestCost && perimeter < bestPerimeter))
+			{
+				best = i;
+				bestCost = cost;
+				bestPerimeter = perimeter;
+			}
+		}
+
+		int32 child = node->child[best];
+		if (IsLeafChild(child))
+		{
+			break;
+		}
+
+		nodeId = child;
+	}
+
+	InsertChild(nodeId, LeafChild(proxyId), leafAABB);
+}
+
+// Adds a child to a node, splitting the node in two when it is full and
+// adding the new half to the parent in turn.
+void b2SimdTree::InsertChild(int32 nodeId, int32 child, b2AABB aabb)
+{
+	for (;;)
+	{
+		b2SimdTreeNode* node = m_nodes + nodeId;
+
+		if (node->count < b2_simdTreeWidth)
+		{
+			SetChild(nodeId, node->count, child, aabb);
+			++node->count;
+			Refit(nodeId);
+			return;
+		}
+
+		const int32 entryCount = b2_simdTreeWidth + 1;
+		int32 children[entryCount];
+		b2AABB aabbs[entryCount];
+		for (int32 i = 0; i < b2_simdTreeWidth; ++i)
+		{
+			children[i] = node->child[i];
+			aabbs[i] = GetSlotAABB(nodeId, i);
+		}
+		children[b2_simdTreeWidth] = child;
+		aabbs[b2_simdTreeWidth] = aabb;
+
+		// Try every way of moving two of the children to a new node, keeping
+		// the one with the least perimeter over both nodes.
+		int32 bestFirst = 0;
+		int32 bestSecond = 1;
+		float32 bestCost = FLT_MAX;
+		for (int32 first = 0; first < entryCount - 1; ++first)
+		{
+			for (int32 second = first + 1; second < entryCount; ++second)
+			{
+				b2AABB moved;
+				moved.Combine(aabbs[first], aabbs[second]);
+
+				// Start from the first child that is not moved.
+				int32 keptFirst = first > 0 ? 0 : (second > 1 ? 1 : 2);
+				b2AABB kept = aabbs[keptFirst];
+				for (int32 i = keptFirst + 1; i < entryCount; ++i)
+				{
+					if (i != first && i != second)
+					{
+						kept.Combine(aabbs[i]);
+					}
+				}
+
+				float32 cost = moved.GetPerimeter() + kept.GetPerimeter();
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestFirst = first;
+					bestSecond = second;
+				}
+			}
+		}
+
+		// AllocateNode may move the node pool.
+		int32 sibling = AllocateNode();
+		node = m_nodes + nodeId;
+
+		for (int32 i = 0; i < b2_simdTreeWidth; ++i)
+		{
+			ClearSlot(nodeId, i);
+		}
+		node->count = 0;
+
+		for (int32 i = 0; i < entryCount; ++i)
+		{
+			int32 target = (i == bestFirst || i == bestSecond) ? sibling : nodeId;
+			SetChild(target, m_nodes[target].count, children[i], aabbs[i]);
+			++m_nodes[target].count;
+		}
+
+		if (nodeId == m_root)
+		{
+			int32 newRoot = AllocateNode();
+			SetChild(newRoot, 0, nodeId, ComputeNodeAABB(nodeId));
+			SetChild(newRoot, 1, sibling, ComputeNodeAABB(sibling));
+			m_nodes[newRoot].count = 2;
+			m_root = newRoot;
+			return;
+		}
+
+		// The split node has shrunk, update it in its parent then add the
+		// new node there.
+		int32 parent = m_nodes[nodeId].parent;
+		SetChild(parent, m_nodes[nodeId].parentSlot, nodeId, ComputeNodeAABB(nodeId));
+
+		nodeId = parent;
+		child = sibling;
+		aabb = ComputeNodeAABB(sibling);
+	}
+}
+
+void b2SimdTree::RemoveLeaf(int32 proxyId)
+{
+	int32 nodeId = m_proxies[proxyId].node;
+	RemoveSlot(nodeId, m_proxies[proxyId].slot);
+
+	// Collapse nodes left empty or with a single child.
+	while (nodeId != m_root)
+	{
+		b2SimdTreeNode* node = m_nodes + nodeId;
+		int32 parent = node->parent;
+
+		if (node->count == 0)
+		{
+			RemoveSlot(parent, node->parentSlot);
+			FreeNode(nodeId);
+			nodeId = parent;
+		}
+		else if (node->count == 1)
+		{
+			SetChild(parent, node->parentSlot, node->child[0], GetSlotAABB(nodeId, 0));
+			FreeNode(nodeId);
+			nodeId = parent;
+			break;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	b2SimdTreeNode* root = m_nodes + m_root;
+	if (root->count == 0)
+	{
+		FreeNode(m_root);
+		m_root = b2_nullNode;
+		return;
+	}
+
+	if (nodeId == m_root && root->count == 1 && IsLeafChild(root->child[0]) == false)
+	{
+		// The root only holds another node, make that node the root.
+		int32 oldRoot = m_root;
+		m_root = root->child[0];
+		m_nodes[m_root].parent = b2_nullNode;
+		m_nodes[m_root].parentSlot = 0;
+		FreeNode(oldRoot);
+		return;
+	}
+
+	Refit(nodeId);
+}
+
+void b2SimdTree::SetFatAABB(int32 proxyId, const b2AABB& aabb)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].slot >= 0);
+
+	// Extend AABB.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	m_proxies[proxyId].aabb.lowerBound = aabb.lowerBound - r;
+	m_proxies[proxyId].aabb.upperBound = aabb.upperBound + r;
+}
+
+void b2SimdTree::Rebuild()
+{
+	m_refitCount = 0;
+
+	// Free every node, keeping the proxies.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].count >= 0)
+		{
+			FreeNode(i);
+		}
+	}
+	m_root = b2_nullNode;
+
+	if (m_proxyCount == 0)
+	{
+		m_builtAreaRatio = 0.0f;
+		return;
+	}
+
+	int32* proxyIds = (int32*)b2Alloc(m_proxyCount * sizeof(int32));
+	int32 count = 0;
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		if (m_proxies[i].slot != -1)
+		{
+			proxyIds[count++] = i;
+		}
+	}
+	b2Assert(count == m_proxyCount);
+
+	b2AABB bounds;
+	m_root = BuildNode(proxyIds, count, b2_nullNode, 0, &bounds);
+
+	b2Free(proxyIds);
+
+	m_builtAreaRatio = GetAreaRatio();
+}
+
+// Builds a node over a set of proxies. Sets larger than the node width are split
+// in two with the SAH, and each half split again, giving up to four children.
+int32 b2SimdTree::BuildNode(int32* proxyIds, int32 count, int32 parent, int32 parentSlot, b2AABB* bounds)
+{
+	int32 nodeId = AllocateNode();
+	m_nodes[nodeId].parent = parent;
+	m_nodes[nodeId].parentSlot = parentSlot;
+
+	if (count <= b2_simdTreeWidth)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			SetChild(nodeId, i, LeafChild(proxyIds[i]), m_proxies[proxyIds[i]].aabb);
+		}
+		m_nodes[nodeId].count = count;
+		*bounds = ComputeNodeAABB(nodeId);
+		return nodeId;
+	}
+
+	int32 mid = Split(proxyIds, count);
+	int32 lowMid = Split(proxyIds, mid);
+	int32 highMid = mid + Split(proxyIds + mid, count - mid);
+
+	int32 starts[b2_simdTreeWidth] = { 0, lowMid, mid, highMid };
+	int32 ends[b2_simdTreeWidth] = { lowMid, mid, highMid, count };
+
+	int32 slot = 0;
+	for (int32 i = 0; i < b2_simdTreeWidth; ++i)
+	{
+		int32 groupCount = ends[i] - starts[i];
+		if (groupCount == 0)
+		{
+			continue;
+		}
+
+		if (groupCount == 1)
+		{
+			int32 proxyId = proxyIds[starts[i]];
+			SetChild(nodeId, slot, LeafChild(proxyId), m_proxies[proxyId].aabb);
+		}
+		else
+		{
+			b2AABB childBounds;
+			int32 child = BuildNode(proxyIds + starts[i], groupCount, nodeId, slot, &childBounds);
+			SetChild(nodeId, slot, child, childBounds);
+		}
+
+		++slot;
+	}
+
+	m_nodes[nodeId].count = slot;
+	*bounds = ComputeNodeAABB(nodeId);
+	return nodeId;
+}
+
+// Partitions the proxies about the binned SAH split of their centroids along
+// the longest axis, returning the size of the first partition.
+int32 b2SimdTree::Split(int32* proxyIds, int32 count) const
+{
+	if (count < 2)
+	{
+		return count;
+	}
+
+	b2AABB centroidBounds;
+	centroidBounds.lowerBound = m_proxies[proxyIds[0]].aabb.GetCenter();
+	centroidBounds.upperBound = centroidBounds.lowerBound;
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = m_proxies[proxyIds[i]].aabb.GetCenter();
+		centroidBounds.lowerBound = b2Min(centroidBounds.lowerBound, c);
+		centroidBounds.upperBound = b2Max(centroidBounds.upperBound, c);
+	}
+
+	b2Vec2 extents = centroidBounds.upperBound - centroidBounds.lowerBound;
+	int32 axis = extents.x >= extents.y ? 0 : 1;
+	float32 axisMin = axis == 0 ? centroidBounds.lowerBound.x : centroidBounds.lowerBound.y;
+	float32 axisExtent = axis == 0 ? extents.x : extents.y;
+
+	if (axisExtent <= 0.0f)
+	{
+		// Every centroid is in the same place, split down the middle.
+		return count / 2;
+	}
+
+	int32 binCounts[b2_simdTreeBinCount];
+	b2AABB binBounds[b2_simdTreeBinCount];
+	for (int32 i = 0; i < b2_simdTreeBinCount; ++i)
+	{
+		binCounts[i] = 0;
+	}
+
+	float32 scale = b2_simdTreeBinCount / axisExtent;
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2AABB& aabb = m_proxies[proxyIds[i]].aabb;
+		b2Vec2 c = aabb.GetCenter();
+		int32 bin = b2Min((int32)(((axis == 0 ? c.x : c.y) - axisMin) * scale), b2_simdTreeBinCount - 1);
+
+		if (binCounts[bin] == 0)
+		{
+			binBounds[bin] = aabb;
+		}
+		else
+		{
+			binBounds[bin].Combine(aabb);
+		}
+		++binCounts[bin];
+	}
+
+	// Sweep from the right to get the cost of every right hand side.
+	float32 rightCosts[b2_simdTreeBinCount];
+	{
+		b2AABB rightBounds = binBounds[0];
+		int32 rightCount = 0;
+		for (int32 i = b2_simdTreeBinCount - 1; i > 0; --i)
+		{
+			if (binCounts[i] > 0)
+			{
+				if (rightCount == 0)
+				{
+					rightBounds = binBounds[i];
+				}
+				else
+				{
+					rightBounds.Combine(binBounds[i]);
+				}
+				rightCount += binCounts[i];
+			}
+			rightCosts[i] = rightCount > 0 ? rightBounds.GetPerimeter() * rightCount : 0.0f;
+		}
+	}
+
+	// Sweep from the left, splitting before the bin with the lowest total cost.
+	int32 bestSplit = 1;
+	float32 bestCost = FLT_MAX;
+	{
+		b2AABB leftBounds = binBounds[0];
+		int32 leftCount = 0;
+		for (int32 i = 1; i < b2_simdTreeBinCount; ++i)
+		{
+			if (binCounts[i - 1] > 0)
+			{
+				if (leftCount == 0)
+				{
+					leftBounds = binBounds[i - 1];
+				}
+				else
+				{
+					leftBounds.Combine(binBounds[i - 1]);
+				}
+				leftCount += binCounts[i - 1];
+			}
+
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+
+			float32 cost = leftBounds.GetPerimeter() * leftCount + rightCosts[i];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+	}
+
+	// Partition the proxies by bin.
+	int32 left = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 c = m_proxies[proxyIds[i]].aabb.GetCenter();
+		int32 bin = b2Min((int32)(((axis == 0 ? c.x : c.y) - axisMin) * scale), b2_simdTreeBinCount - 1);
+		if (bin < bestSplit)
+		{
+			b2Swap(proxyIds[i], proxyIds[left]);
+			++left;
+		}
+	}
+
+	if (left == 0 || left == count)
+	{
+		return count / 2;
+	}
+
+	return left;
+}
+
+// Computes the height of the tree and the largest height difference between
+// the children of any node, without recursing. Every node is listed top down,
+// then the heights are worked out bottom up from the end of the list.
+int32 b2SimdTree::ComputeHeight(int32* maxBalance) const
+{
+	*maxBalance = 0;
+
+	if (m_root == b2_nullNode)
+	{
+		return 0;
+	}
+
+	int32* order = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32* heights = (int32*)b2Alloc(m_nodeCapacity * sizeof(int32));
+
+	int32 count = 0;
+	order[count++] = m_root;
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2SimdTreeNode* node = m_nodes + order[i];
+		for (int32 j = 0; j < node->count; ++j)
+		{
+			if (IsLeafChild(node->child[j]) == false)
+			{
+				order[count++] = node->child[j];
+			}
+		}
+	}
+
+	for (int32 i = count - 1; i >= 0; --i)
+	{
+		const b2SimdTreeNode* node = m_nodes + order[i];
+
+		int32 minChildHeight = 0x7fffffff;
+		int32 maxChildHeight = 0;
+		for (int32 j = 0; j < node->count; ++j)
+		{
+			int32 childHeight = IsLeafChild(node->child[j]) ? 0 : heights[node->child[j]];
+			minChildHeight = b2Min(minChildHeight, childHeight);
+			maxChildHeight = b2Max(maxChildHeight, childHeight);
+		}
+
+		heights[order[i]] = maxChildHeight + 1;
+		if (node->count > 0)
+		{
+			*maxBalance = b2Max(*maxBalance, maxChildHeight - minChildHeight);
+		}
+	}
+
+	int32 height = heights[m_root];
+
+	b2Free(heights);
+	b2Free(order);
+
+	return height;
+}
+
+int32 b2SimdTree::GetHeight() const
+{
+	int32 maxBalance;
+	return ComputeHeight(&maxBalance);
+}
+
+int32 b2SimdTree::GetMaxBalance() const
+{
+	int32 maxBalance;
+	ComputeHeight(&maxBalance);
+	return maxBalance;
+}
+
+float32 b2SimdTree::GetAreaRatio() const
+{
+	if (m_root == b2_nullNode)
+	{
+		return 0.0f;
+	}
+
+	float32 rootArea = ComputeNodeAABB(m_root).GetPerimeter();
+	if (rootArea <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	float32 totalArea = rootArea;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		const b2SimdTreeNode* node = m_nodes + i;
+		for (int32 j = 0; j < node->count; ++j)
+		{
+			totalArea += GetSlotAABB(i, j).GetPerimeter();
+		}
+	}
+
+	return totalArea / rootArea;
+}
+
+void b2SimdTree::Validate() const
+{
+	int32 nodeCount = 0;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		const b2SimdTreeNode* node = m_nodes + i;
+		if (node->count < 0)
+		{
+			continue;
+		}
+
+		++nodeCount;
+		b2Assert(i == m_root || node->count > 0);
+
+		for (int32 j = 0; j < b2_simdTreeWidth; ++j)
+		{
+			int32 child = node->child[j];
+			if (j >= node->count)
+			{
+				b2Assert(child == b2_nullNode);
+				continue;
+			}
+
+			if (IsLeafChild(child))
+			{
+				const b2SimdTreeProxy* proxy = m_proxies + ProxyOfChild(child);
+				B2_NOT_USED(proxy);
+				b2Assert(proxy->node == i && proxy->slot == j);
+			}
+			else
+			{
+				b2Assert(m_nodes[child].parent == i && m_nodes[child].parentSlot == j);
+				b2AABB childAABB = ComputeNodeAABB(child);
+				B2_NOT_USED(childAABB);
+				b2Assert(GetSlotAABB(i, j).Contains(childAABB));
+			}
+		}
+	}
+
+	b2Assert(nodeCount == m_nodeCount);
+	B2_NOT_USED(nodeCount);
+}
@@ -0,0 +1,341 @@
+#ifndef B2_SIMD_TREE_H
+#define B2_SIMD_TREE_H
+
+#include "b2Collision.h"
+#include "b2DynamicTree.h"
+#include "../Common/b2GrowableStack.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define B2_SIMD_TREE_SSE 1
+#include <xmmintrin.h>
+#else
+#define B2_SIMD_TREE_SSE 0
+#endif
+
+/// The number of children held by each node of a b2SimdTree.
+#define b2_simdTreeWidth 4
+
+/// A b2SimdTree node. The bounds of the (up to) four children are stored as
+/// structure-of-arrays lanes so one SIMD compare tests all four children.
+/// Children are packed into slots [0, count). A child is either the index
+/// of another node (>= 0) or a proxy encoded by b2SimdTree::LeafChild.
+struct b2SimdTreeNode
+{
+	float32 lowerX[b2_simdTreeWidth];
+	float32 lowerY[b2_simdTreeWidth];
+	float32 upperX[b2_simdTreeWidth];
+	float32 upperY[b2_simdTreeWidth];
+
+	int32 child[b2_simdTreeWidth];
+
+	union
+	{
+		int32 parent;
+		int32 next;
+	};
+
+	/// Slot of this node in its parent
+	int32 parentSlot;
+
+	/// Number of children, -1 if the node is free
+	int32 count;
+};
+
+/// A proxy stored in a b2SimdTree, with the node and slot holding it.
+struct b2SimdTreeProxy
+{
+	b2AABB aabb;
+	void* userData;
+
+	union
+	{
+		int32 node;
+		int32 next;
+	};
+
+	/// Slot of the proxy in its node, -1 if the proxy is free and -2 if it
+	/// has not been inserted yet
+	int32 slot;
+};
+
+/// A 4-wide bounding volume hierarchy with the same interface as b2DynamicTree,
+/// used by b2BroadPhase when B2_SIMD_BROADPHASE is enabled.
+/// Proxies are inserted incrementally, splitting full nodes so the tree stays
+/// balanced, and moved proxies are refit in place rather than removed and
+/// reinserted. When the quality of the tree degrades
+/// (see GetAreaRatio) it is rebuilt top-down with the surface area heuristic.
+class b2SimdTree
+{
+public:
+	b2SimdTree();
+
+	~b2SimdTree();
+
+	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+
+	/// Create a proxy without inserting it, for adding many proxies at once.
+	/// Rebuild must be called before the tree is used again.
+	int32 CreateUnlinkedProxy(const b2AABB& aabb, void* userData);
+
+	/// Destroy a proxy. This asserts if the id is invalid.
+	void DestroyProxy(int32 proxyId);
+
+	/// Move a proxy with a swepted AABB. If the proxy has moved outside of its fattened AABB,
+	/// then the proxy bounds are refit in the tree and the function returns true.
+	bool MoveProxy(int32 proxyId, const b2AABB& aabb1, const b2Vec2& displacement);
+
+	/// Get proxy user data.
+	void* GetUserData(int32 proxyId) const;
+
+	/// Get the fat AABB for a proxy.
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+
+	/// Set the AABB of a proxy without updating the tree, for moving many proxies
+	/// at once. Rebuild must be called before the tree is used again.
+	void SetFatAABB(int32 proxyId, const b2AABB& aabb);
+
+	/// Query an AABB for overlapping proxies. The callback class
+	/// is called for each proxy that overlaps the supplied AABB.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Ray-cast against the proxies in the tree, see b2DynamicTree::RayCast.
+	template <typename T>
+	void RayCast(T* callback, const b2RayCastInput& input) const;
+
+	/// Validate this tree. For testing.
+	void Validate() const;
+
+	/// Compute the height of the tree. This is O(N).
+	int32 GetHeight() const;
+
+	/// Get the maximum height difference between the children of any node.
+	int32 GetMaxBalance() const;
+
+	/// Get the ratio of the sum of the node perimeters to the root perimeter.
+	float32 GetAreaRatio() const;
+
+	/// Rebuild the whole tree top-down using the surface area heuristic.
+	void Rebuild();
+
+private:
+
+	static bool IsLeafChild(int32 child) { return child <= -2; }
+	static int32 LeafChild(int32 proxyId) { return -proxyId - 2; }
+	static int32 ProxyOfChild(int32 child) { return -child - 2; }
+
+	int32 AllocateNode();
+	void FreeNode(int32 nodeId);
+
+	int32 AllocateProxy();
+	void FreeProxy(int32 proxyId);
+
+	void InsertLeaf(int32 proxyId);
+	void InsertChild(int32 nodeId, int32 child, b2AABB aabb);
+	void RemoveLeaf(int32 proxyId);
+	void CheckQuality();
+
+	void SetChild(int32 nodeId, int32 slot, int32 child, const b2AABB& aabb);
+	void ClearSlot(int32 nodeId, int32 slot);
+	void RemoveSlot(int32 nodeId, int32 slot);
+	b2AABB GetSlotAABB(int32 nodeId, int32 slot) const;
+	b2AABB ComputeNodeAABB(int32 nodeId) const;
+	void Refit(int32 nodeId);
+
+	int32 BuildNode(int32* proxyIds, int32 count, int32 parent, int32 parentSlot, b2AABB* bounds);
+	int32 Split(int32* proxyIds, int32 count) const;
+
+	int32 ComputeHeight(int32* maxBalance) const;
+
+	/// Returns a lane mask of the children of a node overlapping an AABB.
+	int32 OverlapMask(const b2SimdTreeNode* node, const b2AABB& aabb) const;
+
+	int32 m_root;
+
+	b2SimdTreeNode* m_nodes;
+	int32 m_nodeCount;
+	int32 m_nodeCapacity;
+	int32 m_nodeFreeList;
+
+	b2SimdTreeProxy* m_proxies;
+	int32 m_proxyCount;
+	int32 m_proxyCapacity;
+	int32 m_proxyFreeList;
+
+	/// Number of inserts and refits since the quality of the tree was last checked
+	int32 m_refitCount;
+
+	/// Area ratio of the tree right after the last rebuild
+	float32 m_builtAreaRatio;
+};
+
+inline void* b2SimdTree::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].userData;
+}
+
+inline const b2AABB& b2SimdTree::GetFatAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].aabb;
+}
+
+inline int32 b2SimdTree::OverlapMask(const b2SimdTreeNode* node, const b2AABB& aabb) const
+{
+#if B2_SIMD_TREE_SSE
+	__m128 lowerX = _mm_loadu_ps(node->lowerX);
+	__m128 lowerY = _mm_loadu_ps(node->lowerY);
+	__m128 upperX = _mm_loadu_ps(node->upperX);
+	__m128 upperY = _mm_loadu_ps(node->upperY);
+
+	__m128 overlapX = _mm_and_ps(_mm_cmple_ps(lowerX, _mm_set1_ps(aabb.upperBound.x)),
+								 _mm_cmple_ps(_mm_set1_ps(aabb.lowerBound.x), upperX));
+	__m128 overlapY = _mm_and_ps(_mm_cmple_ps(lowerY, _mm_set1_ps(aabb.upperBound.y)),
+								 _mm_cmple_ps(_mm_set1_ps(aabb.lowerBound.y), upperY));
+
+	return _mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+#else
+	int32 mask = 0;
+	for (int32 i = 0; i < b2_simdTreeWidth; ++i)
+	{
+		if (node->lowerX[i] <= aabb.upperBound.x && aabb.lowerBound.x <= node->upperX[i] &&
+			node->lowerY[i] <= aabb.upperBound.y && aabb.lowerBound.y <= node->upperY[i])
+		{
+			mask |= 1 << i;
+		}
+	}
+	return mask;
+#endif
+}
+
+template <typename T>
+inline void b2SimdTree::Query(T* callback, const b2AABB& aabb) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2SimdTreeNode* node = m_nodes + stack.Pop();
+
+		// Empty slots hold inverted bounds, so they never overlap.
+		int32 mask = OverlapMask(node, aabb);
+
+		for (int32 i = 0; i < node->count; ++i)
+		{
+			if ((mask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			int32 child = node->child[i];
+			if (IsLeafChild(child))
+			{
+				bool proceed = callback->QueryCallback(ProxyOfChild(child));
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack.Push(child);
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2SimdTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2SimdTreeNode* node = m_nodes + stack.Pop();
+
+		int32 mask = OverlapMask(node, segmentAABB);
+
+		for (int32 i = 0; i < node->count; ++i)
+		{
+			if ((mask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			// Separating axis for segment (Gino, p80).
+			// |dot(v, p1 - c)| > dot(|v|, h)
+			b2Vec2 c(0.5f * (node->lowerX[i] + node->upperX[i]), 0.5f * (node->lowerY[i] + node->upperY[i]));
+			b2Vec2 h(0.5f * (node->upperX[i] - node->lowerX[i]), 0.5f * (node->upperY[i] - node->lowerY[i]));
+			float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+			if (separation > 0.0f)
+			{
+				continue;
+			}
+
+			int32 child = node->child[i];
+			if (IsLeafChild(child) == false)
+			{
+				stack.Push(child);
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float32 value = callback->RayCastCallback(subInput, ProxyOfChild(child));
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+			}
+		}
+	}
+}
+
+#endif
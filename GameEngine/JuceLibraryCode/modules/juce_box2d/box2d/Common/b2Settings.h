@@ -62,6 +62,12 @@ typedef double float64;
 /// This is a dimensionless multiplier.
 #define b2_aabbMultiplier		2.0f
 
+/// Set to 1 to have b2BroadPhase use the 4-wide SIMD tree (b2SimdTree)
+/// instead of the binary b2DynamicTree.
+#ifndef B2_SIMD_BROADPHASE
+#define B2_SIMD_BROADPHASE		0
+#endif
+
 /// A small length used as a collision and constraint tolerance. Usually it is
 /// chosen to be numerically significant, but visually insignificant.
 #define b2_linearSlop			0.005f
@@ -971,6 +971,96 @@ void b2World::ClearForces()
 	}
 }
 
+void b2World::SetTransforms(b2Body* const* bodies, const b2Vec2* positions, const float32* angles, int32 count)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() == true)
+	{
+		return;
+	}
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+
+	int32 movedProxyCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		for (b2Fixture* f = bodies[i]->m_fixtureList; f; f = f->m_next)
+		{
+			movedProxyCount += f->m_proxyCount;
+		}
+	}
+
+	// A rebuild costs about as much as re-inserting every proxy, so it is
+	// only worth it when a good part of the proxies move.
+	bool rebuild = 4 * movedProxyCount >= broadPhase->GetProxyCount();
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+
+		b->m_xf.q.Set(angles[i]);
+		b->m_xf.p = positions[i];
+
+		b->m_sweep.c = b2Mul(b->m_xf, b->m_sweep.localCenter);
+		b->m_sweep.a = angles[i];
+
+		b->m_sweep.c0 = b->m_sweep.c;
+		b->m_sweep.a0 = angles[i];
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			if (rebuild == false)
+			{
+				f->Synchronize(broadPhase, b->m_xf, b->m_xf);
+				continue;
+			}
+
+			for (int32 j = 0; j < f->m_proxyCount; ++j)
+			{
+				b2FixtureProxy* proxy = f->m_proxies + j;
+				f->m_shape->ComputeAABB(&proxy->aabb, b->m_xf, proxy->childIndex);
+
+				// Proxies still inside their fat AABB keep it, as in MoveProxy.
+				if (broadPhase->GetFatAABB(proxy->proxyId).Contains(proxy->aabb))
+				{
+					continue;
+				}
+
+				broadPhase->SetProxyAABB(proxy->proxyId, proxy->aabb);
+			}
+		}
+	}
+
+	if (rebuild)
+	{
+		broadPhase->RebuildTree();
+	}
+
+	m_contactManager.FindNewContacts();
+}
+
+void b2World::BeginProxyBatch()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() == true)
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase.BeginDeferredInsertion();
+}
+
+void b2World::EndProxyBatch()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() == true)
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase.EndDeferredInsertion();
+}
+
 struct b2WorldQueryWrapper
 {
 	bool QueryCallback(int32 proxyId)
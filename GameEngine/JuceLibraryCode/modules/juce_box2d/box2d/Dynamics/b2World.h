@@ -104,6 +104,31 @@ public:
 	/// @see SetAutoClearForces
 	void ClearForces();
 
+	/// Set the position and angle of many bodies at once, such as when restoring
+	/// a saved state. When a good part of the broad-phase proxies move, they are
+	/// placed without updating the tree, which is then rebuilt in one pass,
+	/// rather than each being removed and re-inserted as b2Body::SetTransform does.
+	/// New contacts are found once all the bodies have been placed.
+	/// @param bodies the bodies to move.
+	/// @param positions the world position of each body's origin.
+	/// @param angles the world rotation of each body in radians.
+	/// @param count the number of bodies.
+	/// @warning this function is locked during callbacks.
+	void SetTransforms(b2Body* const* bodies, const b2Vec2* positions, const float32* angles, int32 count);
+
+	/// Start adding many bodies at once, such as when loading a level. Until
+	/// EndProxyBatch is called the broad-phase proxies of new or activated
+	/// fixtures are created without being inserted into the tree, which is then
+	/// built in one pass. No body may be moved, deactivated or destroyed and the
+	/// world must not be stepped or queried in between.
+	/// @warning this function is locked during callbacks.
+	void BeginProxyBatch();
+
+	/// Build the broad-phase tree over the proxies created since BeginProxyBatch.
+	/// New contacts are found by the next step.
+	/// @warning this function is locked during callbacks.
+	void EndProxyBatch();
+
 	/// Call this to draw shapes and other debug draw data.
 	void DrawDebugData();
 
@@ -48,6 +48,7 @@
 #include "box2d/Collision/b2Collision.cpp"
 #include "box2d/Collision/b2Distance.cpp"
 #include "box2d/Collision/b2DynamicTree.cpp"
+#include "box2d/Collision/b2SimdTree.cpp"
 #include "box2d/Collision/b2TimeOfImpact.cpp"
 #include "box2d/Collision/Shapes/b2ChainShape.cpp"
 #include "box2d/Collision/Shapes/b2CircleShape.cpp"
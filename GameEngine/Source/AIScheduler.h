@@ -0,0 +1,300 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "EntityStore.h"
+#include "FlowField.h"
+#include "PlayerObject.h"
+#include <algorithm>
+#include <vector>
+
+/** Decides which enemies of a level run their AI on a tick, so the cost of
+    the AI follows what is around the players rather than the size of the
+    level.
+
+    Each enemy is put in a tier by its distance to the nearest player, which
+    the camera follows:
+
+        full        within the near distance, about what is in view: runs
+                    every tick
+        reduced     within the active distance: runs once every reduced
+                    interval, with the time since it last ran
+        frozen      further away: does not run, and stops moving across so
+                    it does not wander off while nobody is there to see
+
+    The enemies in the active region are found with the level's spatial
+    hash, so the frozen enemies cost nothing until a player comes near.
+    Chasing enemies that have detected a player follow that player's
+    FlowField.
+
+    The reduced tier is run round-robin under a time budget per tick. When
+    the budget is spent the rest wait for the next tick, which starts where
+    this one stopped, so every enemy gets its turn. The time an enemy waited
+    is passed to it when it runs, so its patrol keeps time at any rate.
+
+    What is kept per enemy is kept by its EntityHandle, so it carries on
+    when the store's enemy list changes, such as when an enemy is stomped
+    or a coin is picked up.
+ */
+class AIScheduler
+{
+public:
+    enum Tier
+    {
+        full = 0,
+        reduced,
+        frozen
+    };
+
+    AIScheduler()
+    {
+        setTierDistances (20.0f, 60.0f);
+        found.resize (256);
+        reducedInterval = 0.25;
+        nextReduced = 0;
+    }
+
+    /** Sets how far from the nearest player enemies leave the full tier
+        and the reduced tier, in world units
+     */
+    void setTierDistances (float nearDistance, float activeDistance)
+    {
+        nearDistanceSquared = nearDistance * nearDistance;
+        activeDistanceSquared = activeDistance * activeDistance;
+        this->activeDistance = activeDistance;
+    }
+
+    /** Sets how often, in seconds, the enemies of the reduced tier run */
+    void setReducedInterval (double seconds)
+    {
+        reducedInterval = seconds;
+    }
+
+    /** Forgets the time the enemies have waited and starts the round-robin
+        from the first enemy, for when the level starts over
+     */
+    void reset()
+    {
+        waited.clear();
+        tiers.clear();
+        isActive.clear();
+        generations.clear();
+        active.clear();
+        activeEnemies.clear();
+        lastActive.clear();
+        lastActiveEnemies.clear();
+        nextReduced = 0;
+    }
+
+    /** Runs the AI of the enemies that are due for a tick.
+
+        @param flowFields   a field to each player, by player index
+        @param elapsed      seconds since the last tick
+        @param budgetMs     time the reduced tier may take, or 0 to run every
+                            enemy that is due, which keeps the decisions the
+                            same from run to run
+     */
+    void update (EntityStore & entities, const Array<PlayerObject *> & players,
+                 const OwnedArray<FlowField> & flowFields, double elapsed, double budgetMs)
+    {
+        this->flowFields = &flowFields;
+
+        const int numEnemies = entities.getNumEnemies();
+
+        if (numEnemies == 0)
+            return;
+
+        findActiveEnemies (entities, players);
+        entities.updateEnemyProximity (players, activeEnemies.data(), (int) activeEnemies.size());
+
+        // Enemies that have left the active region stop where they are
+        for (auto handle : lastActive)
+        {
+            if (isActive[(size_t) handle.index])
+                continue;
+
+            tiers[(size_t) handle.index] = (uint8) frozen;
+            waited[(size_t) handle.index] = 0.0;
+
+            // It may have been stomped or removed since
+            const int enemy = entities.getEnemyIndex (handle);
+
+            if (enemy < 0)
+                continue;
+
+            PhysicsProperties & physics = entities.getEnemy (enemy)->getPhysicsProperties();
+            b2Vec2 velocity = physics.getLinearVel();
+            physics.setLinearVelocity (0, velocity.y);
+        }
+
+        for (size_t n = 0; n < active.size(); n++)
+        {
+            const int i = active[n].index;
+            const int enemy = activeEnemies[n];
+            const Tier tier = entities.getEnemyDistance (enemy) < nearDistanceSquared ? full : reduced;
+
+            tiers[(size_t) i] = (uint8) tier;
+            waited[(size_t) i] += elapsed;
+
+            if (tier == full)
+                run (entities, enemy, i);
+        }
+
+        for (auto handle : active)
+            isActive[(size_t) handle.index] = 0;
+
+        lastActive.swap (active);
+        lastActiveEnemies.swap (activeEnemies);
+
+        // The reduced tier, round-robin from where the last tick stopped
+        const double startMs = Time::getMillisecondCounterHiRes();
+        const int numActive = (int) lastActive.size();
+        const int first = (int) (std::lower_bound (lastActive.begin(), lastActive.end(), nextReduced,
+                                                   [] (const EntityHandle & handle, int index) { return handle.index < index; })
+                                 - lastActive.begin());
+        int numRun = 0;
+
+        for (int n = 0; n < numActive; n++)
+        {
+            const int k = (first + n) % numActive;
+            const int i = lastActive[(size_t) k].index;
+
+            if (tiers[(size_t) i] != reduced || waited[(size_t) i] < reducedInterval)
+                continue;
+
+            // The clock is only read every few enemies, it costs about as
+            // much as running one
+            if (budgetMs > 0.0 && (numRun % 16) == 0 && numRun > 0
+                && Time::getMillisecondCounterHiRes() - startMs >= budgetMs)
+            {
+                nextReduced = i;
+                return;
+            }
+
+            run (entities, lastActiveEnemies[(size_t) k], i);
+            numRun++;
+        }
+    }
+
+    /** The tier an enemy was put in on the last update, see
+        EntityStore::getEnemyHandle()
+     */
+    Tier getTier (EntityHandle enemy) const
+    {
+        return enemy.index >= 0 && enemy.index < (int) tiers.size() && generations[(size_t) enemy.index] == enemy.generation
+            ? (Tier) tiers[(size_t) enemy.index] : frozen;
+    }
+
+private:
+    /** Lists the enemies within the active distance of a player, in order */
+    void findActiveEnemies (EntityStore & entities, const Array<PlayerObject *> & players)
+    {
+        active.clear();
+
+        for (auto player : players)
+        {
+            const float x = player->getPosition().x;
+            const float y = player->getPosition().y;
+
+            int numFound = entities.findInRadius (x, y, activeDistance, found.data(), (int) found.size());
+
+            if (numFound > (int) found.size())
+            {
+                found.resize (numFound);
+                numFound = entities.findInRadius (x, y, activeDistance, found.data(), (int) found.size());
+            }
+
+            for (int i = 0; i < numFound; i++)
+            {
+                const EntityHandle handle = found[i];
+
+                if (entities.getEnemyIndex (handle) < 0)
+                    continue;
+
+                track (handle);
+
+                if (!isActive[(size_t) handle.index])
+                {
+                    isActive[(size_t) handle.index] = 1;
+                    active.push_back (handle);
+                }
+            }
+        }
+
+        std::sort (active.begin(), active.end(), [] (const EntityHandle & a, const EntityHandle & b)
+        {
+            return a.index < b.index;
+        });
+
+        activeEnemies.clear();
+
+        for (auto handle : active)
+            activeEnemies.push_back (entities.getEnemyIndex (handle));
+    }
+
+    /** Makes room for the state of an enemy, and starts it over if its
+        handle's index now belongs to another object
+     */
+    void track (EntityHandle handle)
+    {
+        const size_t i = (size_t) handle.index;
+
+        if (i >= waited.size())
+        {
+            waited.resize (i + 1, 0.0);
+            tiers.resize (i + 1, (uint8) frozen);
+            isActive.resize (i + 1, 0);
+            generations.resize (i + 1, handle.generation);
+        }
+
+        if (generations[i] != handle.generation)
+        {
+            generations[i] = handle.generation;
+            waited[i] = 0.0;
+            tiers[i] = (uint8) frozen;
+        }
+    }
+
+    void run (EntityStore & entities, int enemy, int entity)
+    {
+        EnemyObject * enemyObject = entities.getEnemy (enemy);
+        const bool detected = entities.isPlayerDetected (enemy);
+        const int player = entities.getEnemyNearestPlayer (enemy);
+        NavStep route;
+
+        if (detected && enemyObject->getAIState() == EnemyObject::CHASE && player < flowFields->size())
+            route = (*flowFields)[player]->getStep (enemyObject->getPosition().x, enemyObject->getPosition().y);
+
+        enemyObject->decide (detected, entities.getEnemyNearestPlayerX (enemy), waited[(size_t) entity], route);
+        waited[(size_t) entity] = 0.0;
+    }
+
+    float nearDistanceSquared;
+    float activeDistanceSquared;
+    float activeDistance;
+    double reducedInterval;
+
+    // By the index of the enemy's EntityHandle, with the generation it
+    // was kept for
+    std::vector<double> waited;
+    std::vector<uint8> tiers;
+    std::vector<uint8> isActive;
+    std::vector<uint32> generations;
+
+    // Enemies in the active region this tick and the last, in order of
+    // their handles, with their index in the store's enemies
+    std::vector<EntityHandle> active;
+    std::vector<int> activeEnemies;
+    std::vector<EntityHandle> lastActive;
+    std::vector<int> lastActiveEnemies;
+
+    /** The fields of the update being run */
+    const OwnedArray<FlowField> * flowFields = nullptr;
+
+    /** Results of the spatial hash queries, grown as needed */
+    std::vector<EntityHandle> found;
+
+    /** The handle index of the enemy the reduced tier carries on from */
+    int nextReduced;
+
+    JUCE_LEAK_DETECTOR(AIScheduler)
+};
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <map>
+#include <vector>
+
+/** Gives every texture file an id, so that anything drawing a texture can
+    find it by index rather than by comparing paths. A file keeps its id for
+    as long as the game runs.
+ */
+class TextureRegistry
+{
+public:
+    static TextureRegistry & getInstance()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    /** Gets the id of a texture file, giving it one if it has none yet */
+    int getId (const File & texture)
+    {
+        const ScopedLock lock (registryLock);
+
+        const String path = texture.getFullPathName();
+        auto id = ids.find (path);
+
+        if (id != ids.end())
+            return id->second;
+
+        files.push_back (texture);
+        ids[path] = (int) files.size() - 1;
+        return (int) files.size() - 1;
+    }
+
+    /** Gets the file of an id, or File() if there is no such id */
+    File getFile (int id)
+    {
+        const ScopedLock lock (registryLock);
+        return isPositiveAndBelow (id, (int) files.size()) ? files[(size_t) id] : File();
+    }
+
+    /** The texture drawn for an animating object that has no frames */
+    const File & getDefaultTexture() const
+    {
+        return defaultTexture;
+    }
+
+    int getDefaultId() const
+    {
+        return defaultId;
+    }
+
+private:
+    TextureRegistry()
+        : defaultTexture (File::getCurrentWorkingDirectory().getFullPathName() + "/textures/default.png")
+    {
+        defaultId = getId (defaultTexture);
+    }
+
+    CriticalSection registryLock;
+    std::map<String, int> ids;
+    std::vector<File> files;
+
+    const File defaultTexture;
+    int defaultId;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextureRegistry)
+};
+
+/** The frames of an animation, each with the id of its texture and how long
+    it is shown for, shared by every object that plays it.
+
+    A clip never changes once made, objects given other frames are given
+    another clip. Finding the frame for a time is a search of the clip's
+    frame times, with no locking and nothing allocated, so it can be done
+    for every object drawn.
+ */
+class AnimationClip : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<AnimationClip> Ptr;
+
+    struct Frame
+    {
+        File texture;
+        int textureId;
+        int durationMs;
+
+        /** When the frame ends, from the start of the clip */
+        int endMs;
+    };
+
+    /** Makes a clip of frames shown for the same time each */
+    AnimationClip (const File & directory, const Array<File> & textures, int frameDurationMs = 100)
+        : directory (directory)
+    {
+        frames.reserve ((size_t) textures.size());
+
+        for (auto & texture : textures)
+            addFrame (texture, frameDurationMs);
+    }
+
+    /** The directory the frames were found in */
+    const File & getDirectory() const
+    {
+        return directory;
+    }
+
+    int size() const
+    {
+        return (int) frames.size();
+    }
+
+    const Frame & getFrame (int index) const
+    {
+        return frames[(size_t) index];
+    }
+
+    /** The length of the clip, the durations of its frames added up */
+    int getDurationMs() const
+    {
+        return frames.empty() ? 0 : frames.back().endMs;
+    }
+
+    /** Gets the index of the frame shown at a time from the start of the
+        clip, which must be less than its duration
+     */
+    int getFrameIndexAt (int64 timeMs) const
+    {
+        int first = 0;
+        int last = size() - 1;
+
+        while (first < last)
+        {
+            const int middle = (first + last) / 2;
+
+            if (frames[(size_t) middle].endMs <= timeMs)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+
+        return first;
+    }
+
+    /** Makes a new clip of these frames followed by another one */
+    Ptr withFrame (const File & texture, int durationMs = 100) const
+    {
+        AnimationClip * clip = new AnimationClip (directory, Array<File>());
+        clip->frames = frames;
+        clip->addFrame (texture, durationMs);
+        return clip;
+    }
+
+private:
+    void addFrame (const File & texture, int durationMs)
+    {
+        Frame frame;
+        frame.texture = texture;
+        frame.textureId = TextureRegistry::getInstance().getId (texture);
+        frame.durationMs = jmax (1, durationMs);
+        frame.endMs = getDurationMs() + frame.durationMs;
+
+        frames.push_back (frame);
+    }
+
+    const File directory;
+    std::vector<Frame> frames;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnimationClip)
+};
+
+/** The AnimationClip of every animation directory used so far, so that a
+    directory is only scanned the first time any object uses it rather than
+    for every object made or loaded with it.
+
+    There is one cache for all levels, safe to use from any thread. It is
+    emptied by clear() when the application shuts down, after the levels
+    are deleted.
+ */
+class AnimationClipCache
+{
+public:
+    static AnimationClipCache & getInstance()
+    {
+        static AnimationClipCache cache;
+        return cache;
+    }
+
+    /** Gets the clip of the frames in a directory, scanning it only the
+        first time it is asked for
+     */
+    AnimationClip::Ptr getClip (const File & directory)
+    {
+        const ScopedLock lock (cacheLock);
+
+        auto clip = clips.find (directory.getFullPathName());
+
+        if (clip != clips.end())
+            return clip->second;
+
+        return scan (directory);
+    }
+
+    /** Scans a directory again, for when its files have changed. Objects
+        given its clip before keep the old one.
+     */
+    AnimationClip::Ptr rescan (const File & directory)
+    {
+        const ScopedLock lock (cacheLock);
+        return scan (directory);
+    }
+
+    /** Lets go of every clip. Called at shutdown, before the leak detectors
+        are checked, once nothing using the clips is left.
+     */
+    void clear()
+    {
+        const ScopedLock lock (cacheLock);
+        clips.clear();
+    }
+
+private:
+    AnimationClipCache()
+    {
+    }
+
+    AnimationClip::Ptr scan (const File & directory)
+    {
+        Array<File> textures;
+
+        DirectoryIterator iter (directory, false, "*.jpg;*.JPG;*.jpeg;*.JPEG;*.PNG;*.png");
+        while (iter.next())
+            textures.add (iter.getFile());
+
+        AnimationClip::Ptr clip = new AnimationClip (directory, textures);
+        clips[directory.getFullPathName()] = clip;
+        return clip;
+    }
+
+    CriticalSection cacheLock;
+    std::map<String, AnimationClip::Ptr> clips;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnimationClipCache)
+};
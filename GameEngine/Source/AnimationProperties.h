@@ -2,6 +2,7 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "Speed.h"
+#include "AnimationClip.h"
 
 class AnimationProperties {
 public:
@@ -12,6 +13,7 @@ public:
 		leftAnimation = false;
 		animationTotalTime = 450;
 		animationSpeed = MED;
+		idleTextureId = unresolvedTextureId;
 	}
 
 	~AnimationProperties() {
@@ -66,85 +68,91 @@ public:
 	}
 
 	File getAnimationTextureDirectory() {
-		return animationDirectory;
+		return clip != nullptr ? clip->getDirectory() : File();
 	}
 
 	File getTexture() {
 
-		if (!canimate) {
-			return idleTexture;
-		}
-
-		if (!isAnimating) {
-
-			return idleTexture;
-		}
+		const int index = getFrameIndex();
 
-		if (animationTextureFiles.size() == 0) {
-			return File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/default.png");
+		if (index < 0) {
+			return index == noFrame ? TextureRegistry::getInstance().getDefaultTexture() : idleTexture;
 		}
 
-		int computedAnimSpeed = animationTotalTime;
-
-		switch (animationSpeed) {
-		case FAST:
-			computedAnimSpeed /= 2;
-			break;
-
-		case SLOW:
-			computedAnimSpeed *= 2;
-			break;
-		}
+		return clip->getFrame(index).texture;
+	}
 
-		int size = animationTextureFiles.size();
+	/*
+	* Gets the TextureRegistry id of the texture to draw now. Unlike getTexture()
+	* this copies nothing, it is what the renderer uses for every object
+	*/
+	int getTextureId() {
 
-		double currentTime = (((animationCurrentTime - animationStartTime) % computedAnimSpeed)) / 1000.0;
+		const int index = getFrameIndex();
 
-		int index = currentTime / ((computedAnimSpeed / 1000.0) / (double)size);
+		if (index < 0) {
+			// An object never given an idle texture draws the default one
+			if (index == noFrame || idleTextureId == unresolvedTextureId) {
+				return TextureRegistry::getInstance().getDefaultId();
+			}
 
+			return idleTextureId;
+		}
 
-		return animationTextureFiles[index];
+		return clip->getFrame(index).textureId;
 	}
 
 	/*
-	* Sets the animationDirectory and loads in its files to animationTextureFiles
+	* Sets the animation directory and uses its files as the animation textures.
+	* The directory is only scanned the first time any object uses it, see
+	* AnimationClipCache
 	*/
 	void setAnimationTextures(File directory) {
-		animationDirectory = directory;
-
-		animationTextureFiles.clear();
+		clip = AnimationClipCache::getInstance().getClip(directory);
+	}
 
-		DirectoryIterator iter(animationDirectory, false, "*.jpg;*.JPG;*.jpeg;*.JPEG;*.PNG;*.png");
-		while (iter.next())
-		{
-			File theFileItFound(iter.getFile());
-			animationTextureFiles.add(theFileItFound);
-		}
+	/*
+	* Shares an existing clip, such as an Archetype's
+	*/
+	void setAnimationClip(AnimationClip * newClip) {
+		clip = newClip;
 	}
 
 	/*
-	* Manually add files to the list of animationTextureFiles
+	* Manually add files to the list of animation textures. The object is given
+	* its own copy of the clip, others sharing it are left as they are
 	*/
 	void addAnimationTexture(File tex) {
-		animationTextureFiles.add(tex);
+		if (clip == nullptr)
+			clip = new AnimationClip(File(), Array<File>());
+
+		clip = clip->withFrame(tex);
 	}
 
 	/*
 	* Sets the idleTexture of the object
 	*/
 	void setIdleTexture(File tex) {
-		idleTexture = tex;
+		setIdleTexture(tex, TextureRegistry::getInstance().getId(tex));
+	}
 
+	/*
+	* Sets the idleTexture of the object with its TextureRegistry id already
+	* looked up, such as an Archetype's, so nothing is locked
+	*/
+	void setIdleTexture(File tex, int textureId) {
+		idleTexture = tex;
+		idleTextureId = textureId;
 	}
 
 	/*
 	* Gets an animation texture at a specific index
 	*/
 	File getTextureAt(int index) {
-		if (index > animationTextureFiles.size()) {
-			return File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/default.png");
+		if (!isPositiveAndBelow(index, getNumTextures())) {
+			return TextureRegistry::getInstance().getDefaultTexture();
 		}
-		return animationTextureFiles[index];
+		return clip->getFrame(index).texture;
 
 	}
 
@@ -153,7 +161,7 @@ public:
 	*/
 	int getNumTextures() {
 
-		return animationTextureFiles.size();
+		return clip != nullptr ? clip->size() : 0;
 
 
 	}
@@ -211,7 +219,7 @@ public:
 
 		//Serialize animation directory
 		ValueTree animationDirectoryValueTree = ValueTree("AnimationDirectory");
-		animationDirectoryValueTree.setProperty(Identifier("value"), var(animationDirectory.getRelativePathFrom(File::getCurrentWorkingDirectory())), nullptr);
+		animationDirectoryValueTree.setProperty(Identifier("value"), var(getAnimationTextureDirectory().getRelativePathFrom(File::getCurrentWorkingDirectory())), nullptr);
 		animationPropertiesSerialization.addChild(animationDirectoryValueTree, -1, nullptr);
 
 		return animationPropertiesSerialization;
@@ -252,19 +260,62 @@ public:
 		}
 
 		ValueTree animationDirectoryTree = valueTree.getChildWithName(Identifier("AnimationDirectory"));
-		animationDirectory = File(File::getCurrentWorkingDirectory().getFullPathName() + "/" + animationDirectoryTree.getProperty(Identifier("value")).toString());
+		File animationDirectory = File(File::getCurrentWorkingDirectory().getFullPathName() + "/" + animationDirectoryTree.getProperty(Identifier("value")).toString());
 
 		ValueTree idleTextureTree = valueTree.getChildWithName(Identifier("IdleTexture"));
-		idleTexture = File(File::getCurrentWorkingDirectory().getFullPathName() + "/" + idleTextureTree.getProperty(Identifier("value")).toString());
+		setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/" + idleTextureTree.getProperty(Identifier("value")).toString()));
 
 		setAnimationTextures(animationDirectory);
 	}
 
 private:
 
-	Array<File> animationTextureFiles;
+	enum { idleFrame = -1, noFrame = -2 };
+
+	/** The idleTextureId until an idle texture is set, see getTextureId() */
+	enum { unresolvedTextureId = -1 };
+
+	/*
+	* Gets the index of the clip's frame to draw now, or idleFrame when the
+	* object is not animating, or noFrame when it is but has no frames
+	*/
+	int getFrameIndex() {
+
+		if (!canimate || !isAnimating) {
+			return idleFrame;
+		}
+
+		if (getNumTextures() == 0) {
+			return noFrame;
+		}
+
+		int64 computedAnimSpeed = animationTotalTime;
+
+		switch (animationSpeed) {
+		case FAST:
+			computedAnimSpeed /= 2;
+			break;
+
+		case SLOW:
+			computedAnimSpeed *= 2;
+			break;
+		}
+
+		if (computedAnimSpeed <= 0) {
+			return 0;
+		}
+
+		// Time into the animation, scaled from its length at this speed to
+		// the length of the clip's frames
+		const int64 elapsed = jmax((int64)0, animationCurrentTime - animationStartTime) % computedAnimSpeed;
+
+		return clip->getFrameIndexAt(elapsed * clip->getDurationMs() / computedAnimSpeed);
+	}
+
+	/** Shared with every object playing the same animation */
+	AnimationClip::Ptr clip;
 	File idleTexture;
-	File animationDirectory;
+	int idleTextureId;
 
 	bool canimate;
 	bool isAnimating;
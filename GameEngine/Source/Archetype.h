@@ -0,0 +1,312 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObjectType.h"
+#include "PhysicalAction.h"
+#include "Speed.h"
+#include "AnimationClip.h"
+#include <map>
+#include <vector>
+
+/** The audio files an object plays for each PhysicalAction, shared by every
+    object that plays the same ones. Like an AnimationClip it never changes
+    once made.
+ */
+class SoundSet : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<SoundSet> Ptr;
+    typedef std::map<PhysicalAction, File> Map;
+
+    SoundSet (const Map & sounds) : sounds (sounds)
+    {
+    }
+
+    /** The file for an action, or nullptr if there is none */
+    const File * find (PhysicalAction action) const
+    {
+        auto sound = sounds.find (action);
+        return sound != sounds.end() ? &sound->second : nullptr;
+    }
+
+    const Map & getMap() const
+    {
+        return sounds;
+    }
+
+private:
+    const Map sounds;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundSet)
+};
+
+/** A kind of object a level is made of, such as a brick or the blue enemy:
+    what its objects look like, sound like and how they move and slide.
+
+    An Archetype never changes once made, and is shared by every object made
+    from it, which keep a reference to it. Its clip and sounds are shared
+    with the objects too, an object only gets its own when it is given
+    different ones in the editor.
+ */
+class Archetype : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<Archetype> Ptr;
+
+    /** What the objects of an Archetype start with */
+    struct Definition
+    {
+        String name;
+        GameObjectType type = Generic;
+
+        File idleTexture;
+
+        /** The directory of the animation frames, or File() for none */
+        File animationDirectory;
+        bool canimate = false;
+        Speed animationSpeed = MED;
+
+        Speed moveSpeed = SLOW, jumpSpeed = SLOW;
+        int score = 0;
+
+        /** The physics material of the collision box */
+        float friction = 0.5f, restitution = 0.0f, density = 1.0f;
+
+        SoundSet::Map sounds;
+    };
+
+    /** Made by the ArchetypeLibrary, which finds the clip and sounds of the
+        definition so they are shared with any other archetype using them
+     */
+    Archetype (const Definition & definition, AnimationClip::Ptr clip, SoundSet::Ptr sounds)
+        : definition (definition), clip (clip), sounds (sounds),
+          idleTextureId (TextureRegistry::getInstance().getId (definition.idleTexture))
+    {
+    }
+
+    const Definition & getDefinition() const
+    {
+        return definition;
+    }
+
+    /** The animation, nullptr if there is none */
+    AnimationClip * getClip() const
+    {
+        return clip;
+    }
+
+    /** The sounds, nullptr if there are none */
+    SoundSet * getSounds() const
+    {
+        return sounds;
+    }
+
+    /** The TextureRegistry id of the idle texture, looked up once for every
+        object made from the archetype
+     */
+    int getIdleTextureId() const
+    {
+        return idleTextureId;
+    }
+
+private:
+    const Definition definition;
+    const AnimationClip::Ptr clip;
+    const SoundSet::Ptr sounds;
+    const int idleTextureId;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Archetype)
+};
+
+/** Every Archetype and SoundSet in use, so that objects using the same
+    ones share them. Their animation clips come from the AnimationClipCache.
+
+    There is one library for all levels, safe to use from any thread. It is
+    emptied by clear() when the application shuts down, after the levels
+    are deleted.
+ */
+class ArchetypeLibrary
+{
+public:
+    /** The archetypes every level has */
+    enum BuiltIn
+    {
+        block = 0,
+        enemy,
+        collectable,
+        checkpoint,
+        player,
+        killingFloor
+    };
+
+    static ArchetypeLibrary & getInstance()
+    {
+        static ArchetypeLibrary library;
+        return library;
+    }
+
+    /** Gets a built in archetype, made the first time it is asked for */
+    Archetype::Ptr getBuiltIn (BuiltIn builtIn)
+    {
+        const ScopedLock lock (libraryLock);
+
+        auto archetype = archetypes.find (getBuiltInName (builtIn));
+
+        if (archetype != archetypes.end())
+            return archetype->second;
+
+        return addLocked (getBuiltInDefinition (builtIn));
+    }
+
+    /** Gets an archetype by name, making it if it is a built in one, or
+        nullptr if there is none
+     */
+    Archetype::Ptr get (const String & name)
+    {
+        const ScopedLock lock (libraryLock);
+
+        auto archetype = archetypes.find (name);
+
+        if (archetype != archetypes.end())
+            return archetype->second;
+
+        for (int builtIn = block; builtIn <= killingFloor; builtIn++)
+        {
+            if (name == getBuiltInName ((BuiltIn) builtIn))
+                return addLocked (getBuiltInDefinition ((BuiltIn) builtIn));
+        }
+
+        return nullptr;
+    }
+
+    /** Makes an archetype and keeps it under its name, in place of any
+        archetype of that name before. Objects already made from the one it
+        replaces keep it.
+     */
+    Archetype::Ptr add (const Archetype::Definition & definition)
+    {
+        const ScopedLock lock (libraryLock);
+        return addLocked (definition);
+    }
+
+    /** Gets the shared SoundSet holding a set of sounds, or nullptr if there
+        are none
+     */
+    SoundSet::Ptr getSounds (const SoundSet::Map & sounds)
+    {
+        if (sounds.empty())
+            return nullptr;
+
+        const ScopedLock lock (libraryLock);
+
+        for (auto & soundSet : soundSets)
+        {
+            if (soundSet->getMap() == sounds)
+                return soundSet;
+        }
+
+        SoundSet::Ptr soundSet = new SoundSet (sounds);
+        soundSets.push_back (soundSet);
+        return soundSet;
+    }
+
+    /** Lets go of every archetype and sound set. Called at shutdown, before
+        the leak detectors are checked, so must only be called once nothing
+        made from them is left.
+     */
+    void clear()
+    {
+        const ScopedLock lock (libraryLock);
+
+        archetypes.clear();
+        soundSets.clear();
+    }
+
+    /** A file of the game's assets, by its path from the working directory */
+    static File getAssetFile (const String & relativePath)
+    {
+        return File (File::getCurrentWorkingDirectory().getFullPathName() + "/" + relativePath);
+    }
+
+private:
+    ArchetypeLibrary()
+    {
+    }
+
+    static const char * getBuiltInName (BuiltIn builtIn)
+    {
+        switch (builtIn)
+        {
+            case block:         return "Block";
+            case enemy:         return "Enemy";
+            case collectable:   return "Collectable";
+            case checkpoint:    return "Goal";
+            case player:        return "Player";
+            case killingFloor:  return "Killing Floor";
+        }
+
+        return "";
+    }
+
+    static Archetype::Definition getBuiltInDefinition (BuiltIn builtIn)
+    {
+        Archetype::Definition definition;
+        definition.name = getBuiltInName (builtIn);
+
+        switch (builtIn)
+        {
+            case block:
+                definition.idleTexture = getAssetFile ("textures/brick.png");
+                definition.score = 10;
+                break;
+            case enemy:
+                definition.type = Enemy;
+                definition.idleTexture = getAssetFile ("textures/blue_alien/p2_stand.png");
+                definition.animationDirectory = getAssetFile ("textures/blue_alien/walk/");
+                definition.canimate = true;
+                break;
+            case collectable:
+                definition.type = Collectable;
+                definition.idleTexture = getAssetFile ("textures/coin.png");
+                definition.score = 5;
+                break;
+            case checkpoint:
+                definition.type = Checkpoint;
+                definition.idleTexture = getAssetFile ("textures/checkpoint.png");
+                break;
+            case player:
+                definition.type = Player;
+                definition.idleTexture = getAssetFile ("textures/alien/p1_stand.png");
+                definition.animationDirectory = getAssetFile ("textures/alien/walk/");
+                definition.canimate = true;
+                break;
+            case killingFloor:
+                definition.type = Bounds;
+                definition.idleTexture = getAssetFile ("textures/death.png");
+                definition.score = 10;
+                definition.friction = 0.0f;
+                break;
+        }
+
+        return definition;
+    }
+
+    Archetype::Ptr addLocked (const Archetype::Definition & definition)
+    {
+        AnimationClip::Ptr clip;
+
+        if (definition.animationDirectory != File())
+            clip = AnimationClipCache::getInstance().getClip (definition.animationDirectory);
+
+        Archetype::Ptr archetype = new Archetype (definition, clip, getSounds (definition.sounds));
+        archetypes[definition.name] = archetype;
+        return archetype;
+    }
+
+    CriticalSection libraryLock;
+
+    std::map<String, Archetype::Ptr> archetypes;
+    std::vector<SoundSet::Ptr> soundSets;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ArchetypeLibrary)
+};
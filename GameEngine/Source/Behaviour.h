@@ -0,0 +1,174 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameEvents.h"
+#include <functional>
+#include <vector>
+
+class GameObject;
+
+/** A script for an enemy or any other object of a level to act out, as a
+    list of steps that run one after the other. Steps that wait, such as
+    waitSeconds() and waitUntilPlayerInRange(), suspend the script until
+    what they wait for happens, and the script carries on from there.
+
+    A Behaviour only holds the steps. It is started on as many objects as
+    needed with a BehaviourScheduler, which keeps where each of them is in
+    the script, so one Behaviour drives any number of objects. It must not
+    be changed or deleted while it is running on any of them.
+
+    @code
+    Behaviour guard;
+    guard.waitUntilPlayerInRange (8.0f)
+         .patrolTo (4.0f)
+         .waitSeconds (1.0)
+         .patrolTo (0.0f)
+         .repeat();
+    @endcode
+ */
+class Behaviour
+{
+public:
+    struct Step
+    {
+        enum Type
+        {
+            waitSeconds = 0,
+            waitUntilPlayerInRange,
+            waitForEvent,
+            patrolTo,
+            jump,
+            stop,
+            call,
+            repeat
+        };
+
+        Type type;
+
+        /** Seconds, radius or offset across, depending on the type */
+        float value;
+
+        GameEvent::Type event;
+
+        std::function<void (GameObject &)> function;
+    };
+
+    Behaviour()
+    {
+    }
+
+    /** Waits for a time, in seconds */
+    Behaviour & waitSeconds (double seconds)
+    {
+        return add (Step::waitSeconds, (float) seconds);
+    }
+
+    /** Waits until a player is within a distance of the object */
+    Behaviour & waitUntilPlayerInRange (float radius)
+    {
+        return add (Step::waitUntilPlayerInRange, radius);
+    }
+
+    /** Waits until the GameLogic publishes an event of a type, for things
+        the whole level reacts to, such as a checkpoint being reached
+     */
+    Behaviour & waitForEvent (GameEvent::Type type)
+    {
+        Step & step = addStep (Step::waitForEvent, 0.0f);
+        step.event = type;
+        return *this;
+    }
+
+    /** Walks across at the object's run speed to an offset from where it
+        was when the behaviour started, and waits until it gets there
+     */
+    Behaviour & patrolTo (float offsetX)
+    {
+        return add (Step::patrolTo, offsetX);
+    }
+
+    /** Jumps at the object's jump speed, if it is standing */
+    Behaviour & jump()
+    {
+        return add (Step::jump, 0.0f);
+    }
+
+    /** Stops moving across */
+    Behaviour & stop()
+    {
+        return add (Step::stop, 0.0f);
+    }
+
+    /** Calls a function with the object, for anything the other steps do
+        not do, such as showing an object or opening a way
+     */
+    Behaviour & call (std::function<void (GameObject &)> function)
+    {
+        Step & step = addStep (Step::call, 0.0f);
+        step.function = function;
+        return *this;
+    }
+
+    /** Goes back to the first step. Steps after this are never reached. */
+    Behaviour & repeat()
+    {
+        return add (Step::repeat, 0.0f);
+    }
+
+    /** Makes one of the behaviours a saved level can give its objects by
+        name, see GameObject::setBehaviourName(). A name it does not know
+        makes a behaviour with no steps.
+
+        Guard   paces across and back once a player comes near
+        Hopper  jumps every second and a half
+     */
+    static Behaviour createBuiltIn (const String & name)
+    {
+        Behaviour behaviour;
+
+        if (name == "Guard")
+            behaviour.waitUntilPlayerInRange (8.0f)
+                     .patrolTo (4.0f)
+                     .waitSeconds (1.0)
+                     .patrolTo (0.0f)
+                     .repeat();
+        else if (name == "Hopper")
+            behaviour.waitSeconds (1.5)
+                     .jump()
+                     .repeat();
+
+        return behaviour;
+    }
+
+    int getNumSteps() const
+    {
+        return (int) steps.size();
+    }
+
+    const Step & getStep (int index) const
+    {
+        return steps[(size_t) index];
+    }
+
+private:
+    Behaviour & add (Step::Type type, float value)
+    {
+        addStep (type, value);
+        return *this;
+    }
+
+    Step & addStep (Step::Type type, float value)
+    {
+        Step step;
+        step.type = type;
+        step.value = value;
+        step.event = GameEvent::collision;
+
+        steps.push_back (step);
+        return steps.back();
+    }
+
+    std::vector<Step> steps;
+
+    JUCE_LEAK_DETECTOR(Behaviour)
+};
@@ -0,0 +1,591 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Behaviour.h"
+#include "EntityStore.h"
+#include "GameObject.h"
+#include "PlayerObject.h"
+#include "SpatialHash.h"
+#include <algorithm>
+#include <vector>
+
+/** Refers to a Behaviour started on an object by a BehaviourScheduler */
+struct BehaviourHandle
+{
+    int frame = -1;
+    uint32 generation = 0;
+};
+
+/** Runs the Behaviours started on the objects of a level.
+
+    Each running behaviour has a frame, which keeps the object, the step it
+    is at and what it waits for. Frames come from a pool that only grows,
+    so starting and stopping behaviours during play does not allocate once
+    the pool is big enough.
+
+    A behaviour that waits is not looked at again until what it waits for
+    happens, however many there are:
+
+        waitSeconds             a queue ordered by the time to wake
+        waitUntilPlayerInRange  a list per entity, found by querying the
+                                level's EntityStore around each player
+        waitForEvent            a list per type of GameEvent
+
+    The EntityStore keeps the positions of the objects that can move up to
+    date, so an object waiting for a player is found where it is now, even
+    if it was pushed or fell while waiting. Objects the store does not hash,
+    such as static blocks, cannot move and are kept in a spatial hash here.
+
+    Only the behaviours that wake on a tick run, so the cost of thousands
+    of scripted objects follows how many of them are doing something. The
+    objects walking a patrolTo() are the exception, they are steered every
+    tick until they arrive.
+
+    Behaviours run on the GameLogic thread, in the order they wake, so a
+    replay runs them the same way.
+ */
+class BehaviourScheduler
+{
+public:
+    BehaviourScheduler()
+    {
+        now = 0.0;
+        sequence = 0;
+        maxRange = 0.0f;
+        numWaitingRange = 0;
+        found.resize (256);
+        fixedRangeWaiters.setCellLength (16.0f);
+    }
+
+    /** Starts a behaviour on an object, from its first step on the next
+        update. The behaviour must outlive the frame.
+
+        An enemy driven by a behaviour should have no AIType, or both will
+        steer it.
+     */
+    BehaviourHandle start (GameObject & actor, const Behaviour & behaviour)
+    {
+        int index;
+
+        if (freeFrames.empty())
+        {
+            index = (int) frames.size();
+            frames.push_back (Frame());
+        }
+        else
+        {
+            index = freeFrames.back();
+            freeFrames.pop_back();
+        }
+
+        Frame & frame = frames[(size_t) index];
+        frame.actor = &actor;
+        frame.behaviour = &behaviour;
+        frame.generation++;
+        begin (index);
+
+        BehaviourHandle handle;
+        handle.frame = index;
+        handle.generation = frame.generation;
+        return handle;
+    }
+
+    /** Stops a behaviour and gives its frame back to the pool */
+    void stop (BehaviourHandle handle)
+    {
+        if (isRunning (handle))
+            release (handle.frame);
+    }
+
+    /** Whether a behaviour has been started and not stopped. A behaviour
+        that ran to its end stays running, doing nothing, until it is
+        started over by restart().
+     */
+    bool isRunning (BehaviourHandle handle) const
+    {
+        return handle.frame >= 0 && handle.frame < (int) frames.size()
+            && frames[(size_t) handle.frame].generation == handle.generation
+            && frames[(size_t) handle.frame].state != unused;
+    }
+
+    /** Stops the behaviours of an object, called before it is deleted */
+    void objectRemoved (GameObject * object)
+    {
+        for (int i = 0; i < (int) frames.size(); i++)
+        {
+            if (frames[(size_t) i].state != unused && frames[(size_t) i].actor == object)
+                release (i);
+        }
+    }
+
+    /** Starts every behaviour over from its first step, from where its
+        object is now, for when the level is reset
+     */
+    void restart()
+    {
+        clearWaiting();
+        now = 0.0;
+
+        for (int i = 0; i < (int) frames.size(); i++)
+        {
+            if (frames[(size_t) i].state != unused)
+                begin (i);
+        }
+    }
+
+    /** Wakes the behaviours waiting for the types of the events of a tick,
+        they run on the next update
+     */
+    void handleEvents (const std::vector<GameEvent> & events)
+    {
+        for (auto & event : events)
+        {
+            std::vector<Waiter> & waiters = eventWaiters[event.type];
+
+            for (auto & waiter : waiters)
+            {
+                if (isWaiting (waiter, waitingEvent))
+                    wake (waiter.frame);
+            }
+
+            waiters.clear();
+        }
+    }
+
+    /** Advances the time by elapsed seconds and runs the behaviours that
+        wake: the ones whose time is up, the ones a player has come in
+        range of and the ones woken by events since the last update.
+        entities must be up to date with the objects of the level.
+     */
+    void update (EntityStore & entities, const Array<PlayerObject *> & players, double elapsed)
+    {
+        this->entities = &entities;
+        now += elapsed;
+
+        while (!timers.empty() && timers.front().time <= now)
+        {
+            std::pop_heap (timers.begin(), timers.end(), Wake::later);
+            const Wake timer = timers.back();
+            timers.pop_back();
+
+            if (isWaiting (timer.waiter, waitingTime))
+                wake (timer.waiter.frame);
+        }
+
+        if (numWaitingRange > 0)
+            findPlayersInRange (players);
+
+        steerWalkers();
+
+        // Behaviours woken while these run wait for the next update
+        running.swap (ready);
+
+        for (auto & waiter : running)
+        {
+            if (isWaiting (waiter, readyToRun))
+                resume (waiter.frame);
+        }
+
+        running.clear();
+    }
+
+    /** The number of behaviours started and not stopped */
+    int getNumRunning() const
+    {
+        return (int) (frames.size() - freeFrames.size());
+    }
+
+private:
+    enum State
+    {
+        unused = 0,
+        readyToRun,
+        waitingTime,
+        waitingRange,
+        waitingEvent,
+        walking,
+        finished
+    };
+
+    struct Frame
+    {
+        GameObject * actor = nullptr;
+        const Behaviour * behaviour = nullptr;
+        int step = 0;
+        uint32 generation = 0;
+        State state = unused;
+
+        /** Where the object was across when the behaviour started */
+        float originX = 0.0f;
+
+        /** The position across being walked to, or the radius waited for */
+        float target = 0.0f;
+
+        /** The entity whose list it waits in for a player, or -1 if it
+            waits in fixedRangeWaiters
+         */
+        int rangeEntity = -1;
+    };
+
+    /** A frame in a queue or list, which is skipped if the frame has been
+        stopped or started over since it was added
+     */
+    struct Waiter
+    {
+        int frame;
+        uint32 generation;
+    };
+
+    struct Wake
+    {
+        double time;
+        uint32 sequence;
+        Waiter waiter;
+
+        /** Orders the heap so the earliest is at the front, and timers due
+            at the same time in the order they were set
+         */
+        static bool later (const Wake & a, const Wake & b)
+        {
+            return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+        }
+    };
+
+    /** Steps a behaviour runs at most before it is made to wait for the
+        next update, so a repeat() with no waits in it cannot hang the game
+     */
+    static const int maxStepsPerRun = 64;
+
+    Waiter getWaiter (int index) const
+    {
+        Waiter waiter;
+        waiter.frame = index;
+        waiter.generation = frames[(size_t) index].generation;
+        return waiter;
+    }
+
+    bool isWaiting (const Waiter & waiter, State state) const
+    {
+        const Frame & frame = frames[(size_t) waiter.frame];
+        return frame.generation == waiter.generation && frame.state == state;
+    }
+
+    void begin (int index)
+    {
+        Frame & frame = frames[(size_t) index];
+        frame.step = 0;
+        frame.originX = frame.actor->getPosition().x;
+        wake (index);
+    }
+
+    void wake (int index)
+    {
+        frames[(size_t) index].state = readyToRun;
+        ready.push_back (getWaiter (index));
+    }
+
+    void release (int index)
+    {
+        Frame & frame = frames[(size_t) index];
+
+        if (frame.state == waitingRange)
+            stopWaitingForRange (index);
+
+        frame.state = unused;
+        frame.actor = nullptr;
+        frame.behaviour = nullptr;
+        frame.generation++;
+        freeFrames.push_back (index);
+    }
+
+    void clearWaiting()
+    {
+        timers.clear();
+        ready.clear();
+        walkers.clear();
+        fixedRangeWaiters.clear();
+        numWaitingRange = 0;
+        maxRange = 0.0f;
+
+        // The lists are kept for reuse
+        for (auto & waiters : rangeWaiters)
+            waiters.clear();
+
+        for (auto & waiters : eventWaiters)
+            waiters.clear();
+    }
+
+    void startWaitingForRange (int index)
+    {
+        Frame & frame = frames[(size_t) index];
+        const EntityHandle handle = entities->getHandle (frame.actor);
+
+        maxRange = jmax (maxRange, frame.target);
+        numWaitingRange++;
+
+        if (entities->isFindable (handle))
+        {
+            if (handle.index >= (int) rangeWaiters.size())
+                rangeWaiters.resize ((size_t) handle.index + 1);
+
+            frame.rangeEntity = handle.index;
+            rangeWaiters[(size_t) handle.index].push_back (getWaiter (index));
+        }
+        else
+        {
+            frame.rangeEntity = -1;
+            fixedRangeWaiters.insert (index, frame.actor->getPosition().x, frame.actor->getPosition().y);
+        }
+    }
+
+    void stopWaitingForRange (int index)
+    {
+        const Frame & frame = frames[(size_t) index];
+
+        if (frame.rangeEntity >= 0)
+        {
+            std::vector<Waiter> & waiters = rangeWaiters[(size_t) frame.rangeEntity];
+
+            for (size_t i = 0; i < waiters.size(); i++)
+            {
+                if (waiters[i].frame == index)
+                {
+                    waiters[i] = waiters.back();
+                    waiters.pop_back();
+                    break;
+                }
+            }
+        }
+        else
+        {
+            fixedRangeWaiters.remove (index);
+        }
+
+        if (--numWaitingRange == 0)
+            maxRange = 0.0f;
+    }
+
+    /** Runs the steps of a behaviour from where it is until one of them
+        waits or it comes to the end
+     */
+    void resume (int index)
+    {
+        GameObject & actor = *frames[(size_t) index].actor;
+        const Behaviour & behaviour = *frames[(size_t) index].behaviour;
+        const uint32 generation = frames[(size_t) index].generation;
+
+        for (int n = 0; n < maxStepsPerRun; n++)
+        {
+            // Looked up every step, a call() may start behaviours and grow
+            // the pool
+            Frame & frame = frames[(size_t) index];
+
+            // A behaviour ends when its object is switched off, such as an
+            // enemy that was stomped, and begins again when the level resets
+            if (frame.step >= behaviour.getNumSteps() || !actor.getIsActive())
+            {
+                frame.state = finished;
+                return;
+            }
+
+            const Behaviour::Step & step = behaviour.getStep (frame.step++);
+
+            switch (step.type)
+            {
+                case Behaviour::Step::waitSeconds:
+                    waitUntil (index, now + step.value);
+                    return;
+
+                case Behaviour::Step::waitUntilPlayerInRange:
+                    frame.state = waitingRange;
+                    frame.target = step.value;
+                    startWaitingForRange (index);
+                    return;
+
+                case Behaviour::Step::waitForEvent:
+                    frame.state = waitingEvent;
+                    eventWaiters[step.event].push_back (getWaiter (index));
+                    return;
+
+                case Behaviour::Step::patrolTo:
+                    frame.state = walking;
+                    frame.target = frame.originX + step.value;
+                    walkers.push_back (getWaiter (index));
+                    return;
+
+                case Behaviour::Step::jump:
+                {
+                    b2Vec2 velocity = actor.getPhysicsProperties().getLinearVel();
+
+                    if (velocity.y == 0)
+                        actor.getPhysicsProperties().setLinearVelocity (velocity.x, actor.getJumpSpeedVelocity());
+                    break;
+                }
+
+                case Behaviour::Step::stop:
+                    stopAcross (actor);
+                    break;
+
+                case Behaviour::Step::call:
+                    step.function (actor);
+
+                    // It may have stopped this behaviour
+                    if (frames[(size_t) index].generation != generation)
+                        return;
+                    break;
+
+                case Behaviour::Step::repeat:
+                    frame.step = 0;
+                    break;
+            }
+        }
+
+        // Too many steps without a wait, carry on at the next update
+        waitUntil (index, now);
+    }
+
+    void waitUntil (int index, double time)
+    {
+        frames[(size_t) index].state = waitingTime;
+
+        Wake timer;
+        timer.time = time;
+        timer.sequence = sequence++;
+        timer.waiter = getWaiter (index);
+
+        timers.push_back (timer);
+        std::push_heap (timers.begin(), timers.end(), Wake::later);
+    }
+
+    /** Wakes the behaviours waiting for a player that has come in range.
+        Only the objects near a player are looked at, each measured from
+        where it is now.
+     */
+    void findPlayersInRange (const Array<PlayerObject *> & players)
+    {
+        inRange.clear();
+
+        for (auto player : players)
+        {
+            const float x = player->getPosition().x;
+            const float y = player->getPosition().y;
+
+            int numFound = entities->findInRadius (x, y, maxRange, found.data(), (int) found.size());
+
+            if (numFound > (int) found.size())
+            {
+                found.resize ((size_t) numFound);
+                numFound = entities->findInRadius (x, y, maxRange, found.data(), (int) found.size());
+            }
+
+            for (int i = 0; i < numFound; i++)
+            {
+                if (found[(size_t) i].index >= (int) rangeWaiters.size())
+                    continue;
+
+                for (auto & waiter : rangeWaiters[(size_t) found[(size_t) i].index])
+                {
+                    if (isWaiting (waiter, waitingRange) && isInRange (frames[(size_t) waiter.frame], x, y))
+                        inRange.push_back (waiter.frame);
+                }
+            }
+
+            fixedRangeWaiters.forEachInBox (x - maxRange, y - maxRange, x + maxRange, y + maxRange, [&] (int index)
+            {
+                if (isInRange (frames[(size_t) index], x, y))
+                    inRange.push_back (index);
+            });
+        }
+
+        for (auto index : inRange)
+        {
+            if (frames[(size_t) index].state != waitingRange)
+                continue;   // in range of more than one player
+
+            stopWaitingForRange (index);
+            wake (index);
+        }
+    }
+
+    static bool isInRange (const Frame & frame, float x, float y)
+    {
+        const float dx = frame.actor->getPosition().x - x;
+        const float dy = frame.actor->getPosition().y - y;
+
+        return dx * dx + dy * dy <= frame.target * frame.target;
+    }
+
+    /** Keeps the walking objects going towards where they are walking to,
+        and wakes the ones that have got there
+     */
+    void steerWalkers()
+    {
+        for (size_t i = 0; i < walkers.size();)
+        {
+            const Waiter waiter = walkers[i];
+
+            if (!isWaiting (waiter, walking))
+            {
+                walkers[i] = walkers.back();
+                walkers.pop_back();
+                continue;
+            }
+
+            Frame & frame = frames[(size_t) waiter.frame];
+            GameObject & actor = *frame.actor;
+            const float offset = frame.target - actor.getPosition().x;
+
+            // Near enough, a step at full speed moves a fraction of this
+            if (std::abs (offset) <= 0.25f || !actor.getIsActive())
+            {
+                stopAcross (actor);
+                wake (waiter.frame);
+
+                walkers[i] = walkers.back();
+                walkers.pop_back();
+                continue;
+            }
+
+            b2Vec2 velocity = actor.getPhysicsProperties().getLinearVel();
+            const float speed = jmax (actor.getRunSpeedVelocity(), 1.0f);
+
+            actor.getPhysicsProperties().setLinearVelocity (offset > 0 ? speed : -speed, velocity.y);
+            i++;
+        }
+    }
+
+    static void stopAcross (GameObject & actor)
+    {
+        b2Vec2 velocity = actor.getPhysicsProperties().getLinearVel();
+        actor.getPhysicsProperties().setLinearVelocity (0, velocity.y);
+    }
+
+    /** The pool of frames, and the ones that are free */
+    std::vector<Frame> frames;
+    std::vector<int> freeFrames;
+
+    /** Seconds since the level started */
+    double now;
+
+    std::vector<Wake> timers;
+    uint32 sequence;
+
+    /** The store of the update being run */
+    EntityStore * entities = nullptr;
+
+    /** The behaviours waiting for a player, by entity index */
+    std::vector<std::vector<Waiter>> rangeWaiters;
+    SpatialHash fixedRangeWaiters;
+    float maxRange;
+    int numWaitingRange;
+    std::vector<EntityHandle> found;
+    std::vector<int> inRange;
+
+    std::vector<Waiter> eventWaiters[GameEvent::numTypes];
+    std::vector<Waiter> walkers;
+
+    std::vector<Waiter> ready;
+    std::vector<Waiter> running;
+
+    JUCE_LEAK_DETECTOR(BehaviourScheduler)
+};
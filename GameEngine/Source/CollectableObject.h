@@ -8,16 +8,18 @@ class CollectableObject : public GameObject {
 public:
 	CollectableObject(WorldPhysics & worldPhysics, Model* model) : GameObject(worldPhysics, model)
 	{
-		objType = GameObjectType::Collectable;
+		setObjType(GameObjectType::Collectable);
 		setName("Collectable");
         getPhysicsProperties().setIsStatic(true);
 		radius = 1.5;
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 
 	CollectableObject(WorldPhysics & worldPhysics, Model* model, ValueTree valueTree) : GameObject(worldPhysics, model, valueTree)
 	{
 		getPhysicsProperties().setIsStatic(true);
 		radius = 1.5;
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 
 	/** Copy Constructor - Used to easily make a copy of an existing GameObject
@@ -26,31 +28,22 @@ public:
 	CollectableObject(CollectableObject & objectToCopy, WorldPhysics & worldPhysics) : GameObject( objectToCopy, worldPhysics)
 	{
 		radius = objectToCopy.radius;
-
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 	~CollectableObject() {}
 
-	bool collision(PlayerObject& player, GameAudio& audio) {
+	/** Called when the player enters the collectable's trigger sensor.
+		Returns true if the collectable was picked up, the GameLogic posts
+		the event that plays its sound.
+	*/
+	bool collision(PlayerObject& player) {
 		bool collected = false;
-		radius = 1.5;
 		if (getIsActive()) {
-			b2Vec2 dist = (player.getPosition() - getPhysicsProperties().GetPosition());
-			float leng = sqrt(dist.x * dist.x + dist.y*dist.y);
-			if (leng < radius) {
-				collected = true;
-
-				setActive(false);
-				getPhysicsProperties().setActiveStatus(false);
-				setRenderable(false);
-
-				File * audioFile = getAudioFileForAction(PhysicalAction::death);
+			collected = true;
 
-				// If audio file was not in the map, do nothing
-				if (audioFile != nullptr)
-				{
-					audio.playAudioFile(*audioFile, false);
-				}
-			}
+			setActive(false);
+			getPhysicsProperties().setActiveStatus(false);
+			setRenderable(false);
 		}
 		return collected;
 	}
@@ -1,9 +1,65 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObjectType.h"
 
 enum CollisionFiltering {
 	WORLD  =		0x0001,
 	PLAYER =		0x0002,
-	AI	   =		0x0004
-};
\ No newline at end of file
+	AI	   =		0x0004,
+	TRIGGER =		0x0008,
+	COLLECTABLE =	0x0010,
+	GOAL   =		0x0020
+};
+
+/** The category bits of a collision box and the categories it collides with.
+	Two fixtures only collide when each one's mask contains the other's
+	category, pairs that fail the test are dropped by the contact manager
+	before they reach the narrow phase.
+*/
+struct CollisionFilter {
+	uint16 categoryBits;
+	uint16 maskBits;
+};
+
+/** The filter a GameObject of a given type starts with:
+	- blocks collide with everything
+	- the player collides with blocks, enemies, collectables, goal points
+	  and the trigger sensors
+	- enemies collide with blocks, the player and other enemies
+	- collectables and goal points only collide with the player
+	- the bounds marker collides with nothing
+*/
+inline CollisionFilter getDefaultCollisionFilter(GameObjectType type) {
+	CollisionFilter filter;
+
+	switch (type) {
+	case Player:
+		filter.categoryBits = PLAYER;
+		filter.maskBits = WORLD | AI | TRIGGER | COLLECTABLE | GOAL;
+		break;
+	case Enemy:
+		filter.categoryBits = AI;
+		filter.maskBits = WORLD | PLAYER | AI;
+		break;
+	case Collectable:
+		filter.categoryBits = COLLECTABLE;
+		filter.maskBits = PLAYER;
+		break;
+	case Checkpoint:
+		filter.categoryBits = GOAL;
+		filter.maskBits = PLAYER;
+		break;
+	case Bounds:
+		filter.categoryBits = WORLD;
+		filter.maskBits = 0;
+		break;
+	case Generic:
+	default:
+		filter.categoryBits = WORLD;
+		filter.maskBits = 0xFFFF;
+		break;
+	}
+
+	return filter;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+class GameObject;
+
+/** A contact between two fixtures starting or ending, as reported by Box2D.
+    The GameObjects are taken from the user data of the bodies and are
+    nullptr for bodies that do not belong to a GameObject (such as the
+    merged StaticGeometry). Events are dropped when their fixtures are
+    destroyed, so the pointers are always safe to use.
+ */
+struct ContactEvent
+{
+    enum Type
+    {
+        begin = 0,
+        end
+    };
+
+    Type type;
+
+    b2Fixture * fixtureA;
+    b2Fixture * fixtureB;
+    GameObject * objectA;
+    GameObject * objectB;
+
+    /** Largest normal impulse applied by the contact in the step it began,
+        zero for end events and sensors */
+    float32 impulse;
+
+    /** World position of the contact */
+    b2Vec2 point;
+
+    /** True if either fixture is a sensor, sensor contacts never collide */
+    bool isSensor() const
+    {
+        return fixtureA->IsSensor() || fixtureB->IsSensor();
+    }
+
+    /** True if the event involves the given GameObject */
+    bool involves (const GameObject * object) const
+    {
+        return objectA == object || objectB == object;
+    }
+
+    /** The GameObject owning the sensor, for sensor events */
+    GameObject * getSensorObject() const
+    {
+        return fixtureA->IsSensor() ? objectA : objectB;
+    }
+
+    /** The GameObject on the other side of the contact from the given one */
+    GameObject * getOther (const GameObject * object) const
+    {
+        return objectA == object ? objectB : objectA;
+    }
+};
+
+/** Records the contacts that begin and end in a b2World.
+
+    Registered as the world's contact listener by WorldPhysics, it is filled
+    while the world is stepped (and when bodies are destroyed or deactivated,
+    which ends their contacts) and read once per frame by the GameLogic,
+    which then clears it. Nothing has to walk the contact lists of every body
+    to find out what happened.
+
+    It is also the world's destruction listener, so events are dropped along
+    with the fixtures they refer to.
+ */
+class ContactEventBuffer : public b2ContactListener,
+                           public b2DestructionListener
+{
+public:
+    ContactEventBuffer()
+    {
+    }
+
+    void BeginContact (b2Contact * contact) override
+    {
+        ContactEvent event = makeEvent (ContactEvent::begin, contact);
+
+        b2WorldManifold worldManifold;
+        contact->GetWorldManifold (&worldManifold);
+
+        const int pointCount = contact->GetManifold()->pointCount;
+
+        if (pointCount > 0)
+        {
+            event.point.SetZero();
+
+            for (int i = 0; i < pointCount; i++)
+                event.point += worldManifold.points[i];
+
+            event.point *= 1.0f / pointCount;
+        }
+
+        beganThisStep.push_back (std::make_pair (contact, events.size()));
+        events.push_back (event);
+    }
+
+    void EndContact (b2Contact * contact) override
+    {
+        for (size_t i = 0; i < beganThisStep.size(); i++)
+        {
+            if (beganThisStep[i].first == contact)
+            {
+                beganThisStep[i] = beganThisStep.back();
+                beganThisStep.pop_back();
+                break;
+            }
+        }
+
+        events.push_back (makeEvent (ContactEvent::end, contact));
+    }
+
+    void PostSolve (b2Contact * contact, const b2ContactImpulse * impulse) override
+    {
+        // Only the impulse of the step a contact began in is reported
+        auto began = std::find_if (beganThisStep.begin(), beganThisStep.end(),
+                                   [contact] (const std::pair<b2Contact *, size_t> & entry) { return entry.first == contact; });
+
+        if (began == beganThisStep.end())
+            return;
+
+        ContactEvent & event = events[began->second];
+
+        for (int i = 0; i < impulse->count; i++)
+            event.impulse = jmax (event.impulse, impulse->normalImpulses[i]);
+    }
+
+    /** Called by WorldPhysics after every step */
+    void stepFinished()
+    {
+        beganThisStep.clear();
+    }
+
+    /** The events recorded since the buffer was last cleared, in the order
+        they happened
+     */
+    const std::vector<ContactEvent> & getEvents() const
+    {
+        return events;
+    }
+
+    void clear()
+    {
+        events.clear();
+        beganThisStep.clear();
+    }
+
+    /** Called by the world for every fixture of a body being destroyed */
+    void SayGoodbye (b2Fixture * fixture) override
+    {
+        removeEventsFor (fixture);
+    }
+
+    void SayGoodbye (b2Joint *) override
+    {
+    }
+
+    /** Drops every event involving a fixture. Must be called before a
+        fixture is destroyed on its own with b2Body::DestroyFixture, which
+        does not notify the destruction listener
+     */
+    void removeEventsFor (b2Fixture * fixture)
+    {
+        beganThisStep.clear();
+
+        events.erase (std::remove_if (events.begin(), events.end(), [fixture] (const ContactEvent & event)
+        {
+            return event.fixtureA == fixture || event.fixtureB == fixture;
+        }), events.end());
+    }
+
+private:
+    static ContactEvent makeEvent (ContactEvent::Type type, b2Contact * contact)
+    {
+        ContactEvent event;
+        event.type = type;
+        event.fixtureA = contact->GetFixtureA();
+        event.fixtureB = contact->GetFixtureB();
+        event.objectA = static_cast<GameObject *> (event.fixtureA->GetBody()->GetUserData());
+        event.objectB = static_cast<GameObject *> (event.fixtureB->GetBody()->GetUserData());
+        event.impulse = 0.0f;
+
+        // Sensors and ending contacts have no manifold, use the point midway
+        // between the two bodies
+        event.point = 0.5f * (event.fixtureA->GetBody()->GetPosition() + event.fixtureB->GetBody()->GetPosition());
+
+        return event;
+    }
+
+    std::vector<ContactEvent> events;
+
+    /** Index of the begin event of each contact that began in this step.
+        Few contacts begin in a step, so a list that keeps its storage is
+        searched rather than a map that allocates for every contact.
+     */
+    std::vector<std::pair<b2Contact *, size_t>> beganThisStep;
+
+    JUCE_LEAK_DETECTOR(ContactEventBuffer)
+};
@@ -10,7 +10,7 @@
 
 
 //==============================================================================
-CoreEngine::CoreEngine() : Thread("CoreEngine"), gameLogic(gameAudio, &objectDeletionLock)
+CoreEngine::CoreEngine() : Thread("CoreEngine"), gameLogic(&objectDeletionLock)
 {
 
     // Setup JUCE Components & Windowing
@@ -43,6 +43,9 @@ CoreEngine::CoreEngine() : Thread("CoreEngine"), gameLogic(gameAudio, &objectDel
 		}
 	}
 	gameModelCurrentFrame->setIsGameOver(false);
+
+	// Started with --record, every play session is recorded for replay
+	recordSessions = JUCEApplicationBase::getCommandLineParameterArray().contains("--record");
     
 	renderSwapFrameA = new RenderSwapFrame();
 	renderSwapFrameB = new RenderSwapFrame();
@@ -59,6 +62,13 @@ CoreEngine::CoreEngine() : Thread("CoreEngine"), gameLogic(gameAudio, &objectDel
 	gameLogic.setRenderSwapFrame(renderSwapFrameA);
 	gameView.setRenderSwapFrame(renderSwapFrameB);
 
+	// Audio, the HUD and analytics react to the gameplay through its events
+	gameLogic.getEvents().subscribe(gameAudio.getEvents());
+	gameLogic.getEvents().subscribe(gameView.getHUDEvents());
+	gameLogic.getEvents().subscribe(gameAnalytics.getEvents());
+	gameAnalytics.setReportFile(File::getCurrentWorkingDirectory().getChildFile("analytics.log"));
+	gameAnalytics.startThread();
+
 	// !FIX! MOVE LATER TO AN INPUT MAP AS THE DEFAULT INPUT MAP
 	KeyPress aKey('w');
 
@@ -265,11 +275,21 @@ void CoreEngine::addCheckpoint()
 void CoreEngine::toggleGamePause()
 {
 	if (gameLogic.isPaused()) {
+		// Blocks may have been moved, added or removed while editing
+		gameModelCurrentFrame->getCurrentLevel()->markStaticGeometryDirty();
+		gameModelCurrentFrame->getCurrentLevel()->captureResetState();
+
+		if (recordSessions)
+			gameLogic.startRecording();
+
 		gameLogic.setPaused(false);
         // When game is playing, grab keyboard focus
         grabKeyboardFocus();
 	} else {
 		gameLogic.setPaused(true);
+
+		if (recordSessions)
+			saveRecording();
 	}
 }
 
@@ -308,3 +328,18 @@ void CoreEngine::saveGame() {
 
 	delete element;
 }
+
+void CoreEngine::saveRecording() {
+	ScopedPointer<InputLog> log = gameLogic.stopRecording();
+
+	if (log == nullptr)
+		return;
+
+	File recordingDirectory = File(File::getCurrentWorkingDirectory().getFullPathName() + "/Recordings");
+	recordingDirectory.createDirectory();
+
+	String fileName = "session-" + Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".gamelog";
+	log->saveToFile(File(recordingDirectory.getFullPathName() + "/" + fileName));
+
+	DBG("Recorded " + String(log->getNumTicks()) + " ticks to " + fileName);
+}
@@ -7,6 +7,7 @@
 #include "GameModel.h"
 #include "GameLogic.h"
 #include "GameAudio.h"
+#include "GameAnalytics.h"
 #include "InputManager.h"
 #include "GameCommand.h"
 
@@ -62,6 +63,11 @@ public:
    
 	void saveGame();
 
+	/** Saves the session recorded since play started to the Recordings
+		folder, when the engine was started with --record
+	*/
+	void saveRecording();
+
 	bool isPaused();
 
 
@@ -98,6 +104,9 @@ private:
     /** Audio produced by the game */
     GameAudio gameAudio;
 
+    /** Reports what happened in each play session */
+    GameAnalytics gameAnalytics;
+
     // Thread Synchronization between CoreEngine, GameView, and GameLogic
     WaitableEvent logicWaitable;
     WaitableEvent renderWaitable;
@@ -105,6 +114,9 @@ private:
     
     // Game Model Synchronization
     CriticalSection objectDeletionLock;
+
+	/** Whether play sessions are recorded for replay, see InputLog */
+	bool recordSessions;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoreEngine)
 };
@@ -2,6 +2,7 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "GameObject.h"
 #include "PlayerObject.h"
+#include "FlowField.h"
 
 /** Represents an Object that holds vertices that can be rendered by OpenGL.
 */
@@ -9,7 +10,7 @@ class EnemyObject : public GameObject {
 public:
 	EnemyObject(WorldPhysics & worldPhysics, Model* model) : GameObject(worldPhysics, model)
 	{
-		objType = GameObjectType::Enemy;
+		setObjType(GameObjectType::Enemy);
 
 		aiState = NONE;
 
@@ -18,11 +19,12 @@ public:
 		detection_radius = 7;
 		setName("Enemy");
 		direction = 1;
-		timeToSwap = 100;	//value that deltaTime will sum to for us to determine we need to switch directions
+		timeToSwap = 100.0 / 60.0;	//seconds of patrol before turning, the 100 frames it took at 60 fps
 		timeElapsed = 0;
 
 		radius = 1.5;
         getPhysicsProperties().setIsStatic(false);
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 
 	/** Copy Constructor - Used to easily make a copy of an existing GameObject
@@ -30,22 +32,24 @@ public:
 	*/
 	EnemyObject(EnemyObject & objectToCopy, WorldPhysics & worldPhysics) : GameObject(objectToCopy, worldPhysics)
 	{
-		aiState = objectToCopy.aiState;
+		changeAI(objectToCopy.aiState);
 		detection_radius = 7;
 		direction = 1;
-		timeToSwap = 100;	//value that deltaTime will sum to for us to determine we need to switch directions
+		timeToSwap = 100.0 / 60.0;	//seconds of patrol before turning, the 100 frames it took at 60 fps
 		timeElapsed = 0;
 
 		radius = 1.5;
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 
 	EnemyObject(WorldPhysics & worldPhysics, Model* model, ValueTree valueTree) : GameObject(worldPhysics, model, valueTree)
 	{
 		detection_radius = 7;
 		direction = 1;
-		timeToSwap = 100;	//value that deltaTime will sum to for us to determine we need to switch directions
+		timeToSwap = 100.0 / 60.0;	//seconds of patrol before turning, the 100 frames it took at 60 fps
 		timeElapsed = 0;
 		radius = 1.5;
+		getPhysicsProperties().setSensorRadius(radius);
 
 		parseFrom(valueTree);
 	}
@@ -59,41 +63,63 @@ public:
 		SCAREDAF,
 		CHASE
 	};
+	/** Sets the AI behaviour. An enemy driven by an AI sets its velocity
+		every frame so it opts out of sleeping, an enemy that does nothing
+		is allowed to sleep once it comes to rest.
+	*/
 	void changeAI(AIType type) {
 		aiState = type;
+		getPhysicsProperties().setSleepingAllowed(type == NONE);
 	}
 
 	AIType getAIState() {
 		return aiState;
 	}
-	bool collision(PlayerObject& player, GameAudio &audio, int points) {
+	/** Puts the patrol back to where it starts, heading right with the full
+		time to the next turn ahead
+	*/
+	void resetPatrol() {
+		direction = 1;
+		timeElapsed = 0;
+	}
+	/** Called when the player enters the enemy's trigger sensor. The enemy
+		is stomped if the player came from above, otherwise the player is
+		damaged and true is returned.
+	*/
+	bool collision(PlayerObject& player, int points) {
 		bool damage = false;
-			b2Vec2 dist = (player.getPosition() - getPhysicsProperties().GetPosition());
-			float leng = sqrt(dist.x * dist.x + dist.y*dist.y);
-			if (leng < radius) {	//check if collided
-				if (player.getPosition().y > this->getPhysicsProperties().GetPosition().y+.3) {	//if player kills enemy
-					setActive(false);
-					getPhysicsProperties().setActiveStatus(false);
-					setRenderable(false);
-
-					File * audioFile = getAudioFileForAction(PhysicalAction::death);
-
-					// If audio file was not in the map, do nothing
-					if (audioFile != nullptr)
-					{
-						audio.playAudioFile(*audioFile, false);
-					}
-					player.addCurrScore(points);
-				}
-				else
-				{
-					damage = true;
-				}
+			if (player.getPosition().y > this->getPhysicsProperties().GetPosition().y+.3) {	//if player kills enemy
+				setActive(false);
+				getPhysicsProperties().setActiveStatus(false);
+				setRenderable(false);
+				player.addCurrScore(points);
+			}
+			else
+			{
+				damage = true;
 			}
 
 		return damage;
 	}
+	float getDetectionRadius() {
+		return detection_radius;
+	}
+	/** Runs the AI for a frame against a player. The level's AIScheduler
+		does the same for all its enemies at once.
+	*/
 	void decision(PlayerObject& player, double elapsed) {
+		b2Vec2 offset = b2Vec2(getRenderableObject().position.x, getRenderableObject().position.y) -
+			b2Vec2(player.getRenderableObject().position.x, player.getRenderableObject().position.y);
+
+		decide(offset.LengthSquared() < detection_radius * detection_radius, player.getRenderableObject().position.x, elapsed);
+	}
+	/** Runs the AI, given whether a player is within the detection radius
+		and, if so, where the nearest one is across. elapsed is the time in
+		seconds since it last ran, which the patrols turn around by. A
+		chasing enemy follows route, the step of the flow field to the
+		player, when there is one.
+	*/
+	void decide(bool playerDetected, float playerX, double elapsed, NavStep route = NavStep()) {
 		
 		switch (aiState) {
 		case GROUNDPATROL:
@@ -105,7 +131,7 @@ public:
 			}
 			else
 			{
-				timeElapsed += 1;
+				timeElapsed += elapsed;
 			}
 			moveLateral();
 			break;
@@ -118,35 +144,44 @@ public:
 			}
 			else
 			{
-				timeElapsed += 1;
+				timeElapsed += elapsed;
 			}
 			jumpLateral();
 			break;
 		case CHASE:
-			if ((b2Vec2(getRenderableObject().position.x, getRenderableObject().position.y) - 
-					b2Vec2(player.getRenderableObject().position.x, player.getRenderableObject().position.y)).Length() < detection_radius)	//detected
+			if (playerDetected && route.across != 0)
 			{
-				b2Vec2 myPos = b2Vec2(getRenderableObject().position.x, getRenderableObject().position.y);
-				b2Vec2 theirPos = b2Vec2(player.getRenderableObject().position.x, player.getRenderableObject().position.y);
-				if (myPos.x < theirPos.x) {
+				// Around the blocks in the way
+				if (route.across > 0) {
 					moveRight();
 				}
-				else if (myPos.x > theirPos.x)
+				else
+				{
+					moveLeft();
+				}
+
+				if (route.climb) {
+					climb();
+				}
+			}
+			else if (playerDetected)
+			{
+				if (getRenderableObject().position.x < playerX) {
+					moveRight();
+				}
+				else if (getRenderableObject().position.x > playerX)
 				{
 					moveLeft();
 				}
 			}
 			break;
 		case SCAREDAF:
-			if ((b2Vec2(getRenderableObject().position.x, getRenderableObject().position.y) - 
-					b2Vec2(player.getRenderableObject().position.x, player.getRenderableObject().position.y)).Length() < detection_radius)	//detected
+			if (playerDetected)
 			{
-				b2Vec2 myPos = b2Vec2(getRenderableObject().position.x, getRenderableObject().position.y);
-				b2Vec2 theirPos = b2Vec2(player.getRenderableObject().position.x, player.getRenderableObject().position.y);
-				if (myPos.x > theirPos.x) {
+				if (getRenderableObject().position.x > playerX) {
 					moveRight();
 				}
-				else if (myPos.x < theirPos.x)
+				else if (getRenderableObject().position.x < playerX)
 				{
 					moveLeft();
 				}
@@ -195,6 +230,13 @@ public:
 		}
 		getPhysicsProperties().setLinearVelocity(store.x, store.y);
 	}
+	/** Jumps if standing, to get over a block */
+	void climb() {
+		b2Vec2 store = getPhysicsProperties().getLinearVel();
+		if (store.y == 0) {
+			getPhysicsProperties().setLinearVelocity(store.x, getJumpSpeedVelocity());
+		}
+	}
 	void moveLateral() {
 		b2Vec2 store = getPhysicsProperties().getLinearVel();
 		store.x = getRunSpeedVelocity() * direction;
@@ -0,0 +1,829 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObject.h"
+#include "EnemyObject.h"
+#include "CollectableObject.h"
+#include "GoalPointObject.h"
+#include "SpatialHash.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/** A stable reference to a GameObject in an EntityStore. It stays valid for
+    as long as the object is in the level, and never refers to another
+    object once that one has been removed.
+ */
+struct EntityHandle
+{
+    int index;
+    uint32 generation;
+
+    bool operator== (const EntityHandle & other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!= (const EntityHandle & other) const
+    {
+        return !(*this == other);
+    }
+
+    static EntityHandle invalid()
+    {
+        EntityHandle handle;
+        handle.index = -1;
+        handle.generation = 0;
+        return handle;
+    }
+};
+
+/** Struct-of-arrays storage of the data the gameplay systems of a Level go
+    through every frame, kept alongside its GameObjects.
+
+    Each object is an entity, with its position in the transform arrays. The
+    components are dense arrays, holding only the entities that have them:
+
+        bodies      objects with a dynamic body, the only ones a step moves
+        enemies     EnemyObjects, for the AI
+        pickups     CollectableObjects
+        checkpoints GoalPointObjects
+        animated    objects with animation textures, for the animation pass
+        renderables objects that are drawn, in the order of the level
+
+    So the physics sync goes through the bodies that can move instead of
+    every block of the level, the AI and animation through the objects they
+    apply to instead of every object with a check of its type, and the render
+    list leaves out the hidden and pooled objects.
+
+    Every entity gameplay can look for, which is all but the static blocks,
+    is also kept in a SpatialHash for the queries of what is near a point.
+    The dynamic bodies are moved in it as they are synced.
+
+    A component holds the handle indices of its entities and their data,
+    not pointers to the objects. The body component keeps the Box2D body
+    and the velocity and angle it was last synced with, so a step's results
+    are read from the bodies and only the objects of the bodies that moved
+    are touched.
+
+    Only active objects are in the components and the hash. Objects tell the
+    store when they are deactivated (picked up, stomped, despawned) or
+    activated again, and the store takes them out of or puts them back into
+    just those arrays the next time the level uses it, from whichever thread
+    the change was made on. The renderables are kept the same way as objects
+    are shown and hidden, whether or not they are active. Objects also tell
+    the store when their type or whether their body is static changes, which
+    rebuilds the components.
+
+    The Level updates the store before it is used, whenever objects have
+    been added, removed or edited since. Objects keep their handle across
+    updates, only the component arrays are rebuilt.
+ */
+class EntityStore : public GameObject::ActivityListener
+{
+public:
+    EntityStore()
+    {
+    }
+
+    ~EntityStore()
+    {
+        for (auto object : objects)
+        {
+            if (object != nullptr)
+                object->setActivityListener (nullptr);
+        }
+    }
+
+    /** Gives the objects the store has not seen a handle and rebuilds the
+        component arrays from the objects' current type and body
+     */
+    void update (const OwnedArray<GameObject> & gameObjects)
+    {
+        for (auto object : gameObjects)
+        {
+            if (indices.find (object) == indices.end())
+                add (object);
+        }
+
+        clearComponents();
+        spatialHash.clear();
+        enemyIndices.assign (objects.size(), -1);
+        listed.assign (objects.size(), 0);
+        drawn.assign (objects.size(), 0);
+        stale = false;
+        componentsChanged = false;
+        revision++;
+
+        {
+            // Changes made before the rebuild are part of it
+            const ScopedLock lock (activityLock);
+            activityChanges.clear();
+        }
+
+        int order = 0;
+
+        for (auto object : gameObjects)
+        {
+            const int index = indices[object];
+
+            positionsX[index] = object->getPosition().x;
+            positionsY[index] = object->getPosition().y;
+            drawOrders[index] = order++;
+
+            if (object->isRenderable())
+            {
+                drawn[index] = 1;
+                renderables.push_back (index);
+            }
+
+            // The goal points are only listed for the editor, so they stay
+            // listed while inactive
+            if (object->getObjType() == Checkpoint)
+                checkpoints.push_back (static_cast<GoalPointObject *> (object));
+
+            if (object->getIsActive())
+                addComponents (object, index);
+        }
+    }
+
+    /** Called by the objects as they are activated and deactivated, or
+        shown and hidden
+     */
+    void objectActivityChanged (GameObject * object) override
+    {
+        const ScopedLock lock (activityLock);
+        activityChanges.push_back (object);
+    }
+
+    /** Called by the objects when their type changes or their body is
+        switched between static and dynamic, from whichever thread made the
+        edit. The components are rebuilt on the next update.
+     */
+    void objectComponentsChanged (GameObject *) override
+    {
+        componentsChanged = true;
+    }
+
+    /** Puts the objects activated since the last call into the components,
+        and takes the ones deactivated out, and the same for the shown and
+        hidden ones and the renderables. The Level calls this before the
+        store is used, on the thread that uses it.
+     */
+    void applyActivityChanges()
+    {
+        {
+            const ScopedLock lock (activityLock);
+
+            if (activityChanges.empty())
+                return;
+
+            appliedChanges.swap (activityChanges);
+        }
+
+        for (auto object : appliedChanges)
+        {
+            auto entry = indices.find (object);
+
+            // An object the store has not seen is added on the next update
+            if (entry == indices.end())
+                continue;
+
+            const int index = entry->second;
+            const bool isListed = listed[index] != 0;
+
+            if (object->getIsActive() && !isListed)
+            {
+                positionsX[index] = object->getPosition().x;
+                positionsY[index] = object->getPosition().y;
+                addComponents (object, index);
+            }
+            else if (!object->getIsActive() && isListed)
+            {
+                removeComponents (object, index);
+            }
+
+            if (object->isRenderable() != (drawn[index] != 0))
+                updateRenderable (object->isRenderable(), index);
+        }
+
+        appliedChanges.clear();
+        revision++;
+    }
+
+    /** Retires the handle of an object, must be called before the object is
+        deleted from the level. The components are rebuilt on the next update.
+     */
+    void objectRemoved (GameObject * object)
+    {
+        auto entry = indices.find (object);
+
+        if (entry == indices.end())
+            return;
+
+        const int index = entry->second;
+        indices.erase (entry);
+
+        objects[index] = nullptr;
+        generations[index]++;
+        freeIndices.push_back (index);
+        spatialHash.remove (index);
+        object->setActivityListener (nullptr);
+
+        {
+            const ScopedLock lock (activityLock);
+            activityChanges.erase (std::remove (activityChanges.begin(), activityChanges.end(), object),
+                                   activityChanges.end());
+        }
+
+        // Until the next update nothing may reach the deleted object
+        stale = true;
+        clearComponents();
+        revision++;
+    }
+
+    /** Returns true if objects have been added, removed or moved between
+        components since the last update
+     */
+    bool needsUpdate (int numObjects) const
+    {
+        return stale || componentsChanged || numObjects != (int) indices.size();
+    }
+
+    /** The number of objects the store holds a handle for */
+    int getNumEntities() const
+    {
+        return (int) indices.size();
+    }
+
+    EntityHandle getHandle (GameObject * object) const
+    {
+        auto entry = indices.find (object);
+
+        if (entry == indices.end())
+            return EntityHandle::invalid();
+
+        EntityHandle handle;
+        handle.index = entry->second;
+        handle.generation = generations[entry->second];
+        return handle;
+    }
+
+    /** Returns the object of a handle, or nullptr if it has been removed */
+    GameObject * getObject (EntityHandle handle) const
+    {
+        if (handle.index < 0 || handle.index >= (int) objects.size()
+            || generations[handle.index] != handle.generation)
+            return nullptr;
+
+        return objects[handle.index];
+    }
+
+    float getPositionX (EntityHandle handle) const
+    {
+        return positionsX[handle.index];
+    }
+
+    float getPositionY (EntityHandle handle) const
+    {
+        return positionsY[handle.index];
+    }
+
+    /** Takes the results of a step for every dynamic body. The body's
+        transform and velocity are compared with the ones it was last synced
+        with, and only if they changed are the body's snapshot and object
+        and the entity's transform moved to them. Bodies at rest, asleep
+        ones included, cost a read of the body.
+     */
+    void syncBodies()
+    {
+        const size_t numBodies = bodies.size();
+
+        for (size_t i = 0; i < numBodies; i++)
+        {
+            const b2Body * body = bodies[i];
+            const b2Vec2 & position = body->GetPosition();
+            const b2Vec2 & velocity = body->GetLinearVelocity();
+            const float32 angle = body->GetAngle();
+            const int index = bodyEntities[i];
+
+            if (position.x == positionsX[index] && position.y == positionsY[index]
+                && angle == bodyAngles[i]
+                && velocity.x == bodyVelocitiesX[i] && velocity.y == bodyVelocitiesY[i])
+                continue;
+
+            positionsX[index] = position.x;
+            positionsY[index] = position.y;
+            bodyAngles[i] = angle;
+            bodyVelocitiesX[i] = velocity.x;
+            bodyVelocitiesY[i] = velocity.y;
+
+            GameObject * object = objects[index];
+            object->getPhysicsProperties().updateSnapshot();
+            object->setPosition (position.x, position.y);
+            spatialHash.move (index, position.x, position.y);
+        }
+    }
+
+    /** Moves the transforms of the dynamic bodies to their objects, for
+        when the objects have been moved other than by a step. The bodies
+        are synced in full on the next syncBodies().
+     */
+    void updateTransforms()
+    {
+        const size_t numBodies = bodies.size();
+
+        for (size_t i = 0; i < numBodies; i++)
+        {
+            const int index = bodyEntities[i];
+            positionsX[index] = objects[index]->getPosition().x;
+            positionsY[index] = objects[index]->getPosition().y;
+            bodyAngles[i] = std::numeric_limits<float>::quiet_NaN();
+            spatialHash.move (index, positionsX[index], positionsY[index]);
+        }
+    }
+
+    int getNumBodies() const
+    {
+        return (int) bodies.size();
+    }
+
+    /** The object of a dynamic body, by its index in the bodies */
+    GameObject * getBodyObject (int body) const
+    {
+        return objects[bodyEntities[body]];
+    }
+
+    /** Where a dynamic body was as of the last sync */
+    float getBodyX (int body) const
+    {
+        return positionsX[bodyEntities[body]];
+    }
+
+    float getBodyY (int body) const
+    {
+        return positionsY[bodyEntities[body]];
+    }
+
+    int getNumEnemies() const
+    {
+        return (int) enemyEntities.size();
+    }
+
+    /** The object of an enemy, by its index in the enemies */
+    EnemyObject * getEnemy (int enemy) const
+    {
+        return static_cast<EnemyObject *> (objects[enemyEntities[enemy]]);
+    }
+
+    EntityHandle getEnemyHandle (int enemy) const
+    {
+        EntityHandle handle;
+        handle.index = enemyEntities[enemy];
+        handle.generation = generations[handle.index];
+        return handle;
+    }
+
+    const std::vector<GoalPointObject *> & getCheckpoints() const
+    {
+        return checkpoints;
+    }
+
+    /** The objects that can animate, whether or not they are animating */
+    const std::vector<GameObject *> & getAnimated() const
+    {
+        return animated;
+    }
+
+    /** The number of objects that are drawn, see getRenderable() */
+    int getNumRenderables() const
+    {
+        return (int) renderables.size();
+    }
+
+    /** An object that is drawn, in the order of the level's objects as of
+        the last update
+     */
+    GameObject * getRenderable (int renderable) const
+    {
+        return objects[renderables[renderable]];
+    }
+
+    /** Returns the index in the enemies of the active enemy nearest to a
+        position, or -1 if there is none
+     */
+    int findNearestEnemy (float x, float y) const
+    {
+        int nearest = -1;
+        float nearestDistance = 0.0f;
+
+        const size_t numEnemies = enemyEntities.size();
+
+        for (size_t i = 0; i < numEnemies; i++)
+        {
+            const int index = enemyEntities[i];
+            const float dx = positionsX[index] - x;
+            const float dy = positionsY[index] - y;
+            const float distance = dx * dx + dy * dy;
+
+            // Only active enemies are listed
+            if (nearest < 0 || distance < nearestDistance)
+            {
+                nearest = (int) i;
+                nearestDistance = distance;
+            }
+        }
+
+        return nearest;
+    }
+
+    /** Returns true if findInRadius() and findInBox() can find an entity.
+        Inactive objects and static blocks are left out of the hash.
+     */
+    bool isFindable (EntityHandle handle) const
+    {
+        return getObject (handle) != nullptr && spatialHash.contains (handle.index);
+    }
+
+    /** Finds the entities whose position is within a radius of a point.
+        Writes the handles of up to maxResults of them to results and returns
+        how many there are, which may be more than maxResults.
+     */
+    int findInRadius (float x, float y, float radius, EntityHandle * results, int maxResults)
+    {
+        int numFound = 0;
+        const float radiusSquared = radius * radius;
+
+        spatialHash.forEachInBox (x - radius, y - radius, x + radius, y + radius, [&] (int index)
+        {
+            const float dx = positionsX[index] - x;
+            const float dy = positionsY[index] - y;
+
+            if (dx * dx + dy * dy <= radiusSquared)
+                addResult (index, results, maxResults, numFound);
+        });
+
+        return numFound;
+    }
+
+    /** Finds the entities whose position is inside a box, see findInRadius() */
+    int findInBox (float minX, float minY, float maxX, float maxY, EntityHandle * results, int maxResults)
+    {
+        int numFound = 0;
+
+        spatialHash.forEachInBox (minX, minY, maxX, maxY, [&] (int index)
+        {
+            if (positionsX[index] >= minX && positionsX[index] <= maxX
+                && positionsY[index] >= minY && positionsY[index] <= maxY)
+                addResult (index, results, maxResults, numFound);
+        });
+
+        return numFound;
+    }
+
+    /** Returns the index in the enemies of the enemy of a handle, or -1 if
+        it is not one
+     */
+    int getEnemyIndex (EntityHandle handle) const
+    {
+        if (getObject (handle) == nullptr || handle.index >= (int) enemyIndices.size())
+            return -1;
+
+        return enemyIndices[handle.index];
+    }
+
+    /** Finds the nearest of the players to each of a list of enemies, for
+        the AI. The squared distances from the enemies to each player are
+        worked out for all the listed enemies at a time, with
+        FloatVectorOperations over their transforms.
+
+        @param enemyList    indices in the enemies
+     */
+    void updateEnemyProximity (const Array<PlayerObject *> & players, const int * enemyList, int numListed)
+    {
+        const int numEnemies = (int) enemyEntities.size();
+
+        if ((int) nearestDistances.size() != numEnemies)
+        {
+            nearestDistances.assign (numEnemies, std::numeric_limits<float>::max());
+            nearestPlayerX.assign (numEnemies, 0.0f);
+            nearestPlayers.assign (numEnemies, 0);
+        }
+
+        if (numListed == 0)
+            return;
+
+        enemyX.resize (numListed);
+        enemyY.resize (numListed);
+        offsets.resize (numListed);
+        distances.resize (numListed);
+        listedDistances.assign (numListed, std::numeric_limits<float>::max());
+        listedPlayerX.assign (numListed, 0.0f);
+        listedPlayers.assign (numListed, 0);
+
+        for (int i = 0; i < numListed; i++)
+        {
+            enemyX[i] = positionsX[enemyEntities[enemyList[i]]];
+            enemyY[i] = positionsY[enemyEntities[enemyList[i]]];
+        }
+
+        for (int p = 0; p < players.size(); p++)
+        {
+            PlayerObject * player = players[p];
+            const float playerX = player->getPosition().x;
+            const float playerY = player->getPosition().y;
+
+            FloatVectorOperations::add (offsets.data(), enemyX.data(), -playerX, numListed);
+            FloatVectorOperations::multiply (distances.data(), offsets.data(), offsets.data(), numListed);
+            FloatVectorOperations::add (offsets.data(), enemyY.data(), -playerY, numListed);
+            FloatVectorOperations::addWithMultiply (distances.data(), offsets.data(), offsets.data(), numListed);
+
+            for (int i = 0; i < numListed; i++)
+            {
+                const bool isNearer = distances[i] < listedDistances[i];
+                listedDistances[i] = isNearer ? distances[i] : listedDistances[i];
+                listedPlayerX[i] = isNearer ? playerX : listedPlayerX[i];
+                listedPlayers[i] = isNearer ? p : listedPlayers[i];
+            }
+        }
+
+        for (int i = 0; i < numListed; i++)
+        {
+            nearestDistances[enemyList[i]] = listedDistances[i];
+            nearestPlayerX[enemyList[i]] = listedPlayerX[i];
+            nearestPlayers[enemyList[i]] = listedPlayers[i];
+        }
+    }
+
+    /** The squared distance from an enemy to the nearest player, as of the
+        last updateEnemyProximity() it was listed in
+     */
+    float getEnemyDistance (int enemy) const
+    {
+        return nearestDistances[enemy];
+    }
+
+    /** Where the player nearest to an enemy is across */
+    float getEnemyNearestPlayerX (int enemy) const
+    {
+        return nearestPlayerX[enemy];
+    }
+
+    /** The index of the player nearest to an enemy */
+    int getEnemyNearestPlayer (int enemy) const
+    {
+        return nearestPlayers[enemy];
+    }
+
+    /** Whether the nearest player is within the enemy's detection radius.
+        The radius is read from the enemy, so an edited one takes effect on
+        its next run.
+     */
+    bool isPlayerDetected (int enemy) const
+    {
+        const float radius = getEnemy (enemy)->getDetectionRadius();
+        return nearestDistances[enemy] < radius * radius;
+    }
+
+    /** Changes every time the component arrays are rebuilt, so anything
+        kept per enemy by index knows when to start over
+     */
+    uint32 getRevision() const
+    {
+        return revision;
+    }
+
+    /** The number of pickups that have not been collected */
+    int countActivePickups() const
+    {
+        // Collected pickups are deactivated, which takes them out
+        return (int) pickupEntities.size();
+    }
+
+private:
+    /** Lists an active object in the components and the hash that apply to
+        it, the opposite of removeComponents()
+     */
+    void addComponents (GameObject * object, int index)
+    {
+        PhysicsProperties & physics = object->getPhysicsProperties();
+        listed[index] = 1;
+
+        const bool isBlock = object->getObjType() == Generic || object->getObjType() == Bounds;
+
+        if (!isBlock || !physics.getIsStatic())
+            spatialHash.insert (index, positionsX[index], positionsY[index]);
+
+        if (!physics.getIsStatic())
+        {
+            // The first sync always takes the body's state, as no angle
+            // equals NaN
+            bodyEntities.push_back (index);
+            bodies.push_back (physics.getBody());
+            bodyAngles.push_back (std::numeric_limits<float>::quiet_NaN());
+            bodyVelocitiesX.push_back (0.0f);
+            bodyVelocitiesY.push_back (0.0f);
+        }
+
+        switch (object->getObjType())
+        {
+            case Enemy:
+                enemyIndices[index] = (int) enemyEntities.size();
+                enemyEntities.push_back (index);
+                break;
+            case Collectable:
+                pickupEntities.push_back (index);
+                break;
+            default:
+                break;
+        }
+
+        if (object->getRenderableObject().animationProperties.getCanimate())
+            animated.push_back (object);
+    }
+
+    /** Takes a deactivated object out of the components and the hash. Each
+        component is unordered, so the last entry is moved into the gap.
+     */
+    void removeComponents (GameObject * object, int index)
+    {
+        listed[index] = 0;
+        spatialHash.remove (index);
+
+        for (size_t i = 0; i < bodyEntities.size(); i++)
+        {
+            if (bodyEntities[i] == index)
+            {
+                bodyEntities[i] = bodyEntities.back();
+                bodies[i] = bodies.back();
+                bodyAngles[i] = bodyAngles.back();
+                bodyVelocitiesX[i] = bodyVelocitiesX.back();
+                bodyVelocitiesY[i] = bodyVelocitiesY.back();
+                bodyEntities.pop_back();
+                bodies.pop_back();
+                bodyAngles.pop_back();
+                bodyVelocitiesX.pop_back();
+                bodyVelocitiesY.pop_back();
+                break;
+            }
+        }
+
+        if (object->getObjType() == Enemy && index < (int) enemyIndices.size() && enemyIndices[index] >= 0)
+        {
+            const int enemy = enemyIndices[index];
+            const int last = (int) enemyEntities.size() - 1;
+
+            enemyIndices[enemyEntities[last]] = enemy;
+            enemyEntities[enemy] = enemyEntities[last];
+            enemyEntities.pop_back();
+            enemyIndices[index] = -1;
+        }
+
+        if (object->getObjType() == Collectable)
+            removeFrom (pickupEntities, index);
+
+        removeFrom (animated, object);
+    }
+
+    /** Adds a shown object to the renderables in its place in the draw
+        order, or removes a hidden one. Keeping the order moves the entries
+        after it, but objects are only shown and hidden now and then.
+     */
+    void updateRenderable (bool isRenderable, int index)
+    {
+        auto position = std::lower_bound (renderables.begin(), renderables.end(), index,
+                                          [this] (int entity, int newEntity)
+                                          {
+                                              return drawOrders[entity] < drawOrders[newEntity];
+                                          });
+
+        if (isRenderable)
+            renderables.insert (position, index);
+        else if (position != renderables.end() && *position == index)
+            renderables.erase (position);
+
+        drawn[index] = isRenderable ? 1 : 0;
+    }
+
+    template <typename Type>
+    static void removeFrom (std::vector<Type> & list, Type item)
+    {
+        auto position = std::find (list.begin(), list.end(), item);
+
+        if (position != list.end())
+        {
+            *position = list.back();
+            list.pop_back();
+        }
+    }
+
+    void addResult (int index, EntityHandle * results, int maxResults, int & numFound) const
+    {
+        if (numFound < maxResults)
+        {
+            results[numFound].index = index;
+            results[numFound].generation = generations[index];
+        }
+
+        numFound++;
+    }
+
+    void clearComponents()
+    {
+        bodyEntities.clear();
+        bodies.clear();
+        bodyAngles.clear();
+        bodyVelocitiesX.clear();
+        bodyVelocitiesY.clear();
+        enemyEntities.clear();
+        pickupEntities.clear();
+        checkpoints.clear();
+        animated.clear();
+        renderables.clear();
+    }
+
+    void add (GameObject * object)
+    {
+        int index;
+
+        if (!freeIndices.empty())
+        {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+            objects[index] = object;
+        }
+        else
+        {
+            index = (int) objects.size();
+            objects.push_back (object);
+            generations.push_back (0);
+            positionsX.push_back (0.0f);
+            positionsY.push_back (0.0f);
+            drawOrders.push_back (0);
+        }
+
+        indices[object] = index;
+        object->setActivityListener (this);
+    }
+
+    // Entities, by handle index
+    std::vector<GameObject *> objects;
+    std::vector<uint32> generations;
+    std::vector<int> freeIndices;
+    std::unordered_map<GameObject *, int> indices;
+    bool stale = true;
+    std::atomic<bool> componentsChanged { false };
+    std::vector<uint8> listed;                  // whether in the components
+    std::vector<uint8> drawn;                   // whether in the renderables
+    uint32 revision = 0;
+
+    // Transform, by handle index
+    std::vector<float> positionsX;
+    std::vector<float> positionsY;
+
+    // Body component, the state is as of the last sync
+    std::vector<int> bodyEntities;
+    std::vector<b2Body *> bodies;
+    std::vector<float> bodyAngles;
+    std::vector<float> bodyVelocitiesX, bodyVelocitiesY;
+
+    // AI component
+    std::vector<int> enemyEntities;
+
+    std::vector<int> enemyIndices;              // by handle index, -1 if not an enemy
+
+    // Working space of updateEnemyProximity, by listed enemy
+    std::vector<float> enemyX, enemyY;
+    std::vector<float> offsets, distances;
+    std::vector<float> listedDistances, listedPlayerX;
+    std::vector<int> listedPlayers;
+
+    // Results of updateEnemyProximity, by enemy
+    std::vector<float> nearestDistances, nearestPlayerX;
+    std::vector<int> nearestPlayers;
+
+    // Entities gameplay looks for, by position
+    SpatialHash spatialHash;
+
+    // Objects activated or deactivated since the last applyActivityChanges()
+    CriticalSection activityLock;
+    std::vector<GameObject *> activityChanges;
+    std::vector<GameObject *> appliedChanges;
+
+    // Pickup component
+    std::vector<int> pickupEntities;
+
+    // Checkpoint component
+    std::vector<GoalPointObject *> checkpoints;
+
+    // Animation component
+    std::vector<GameObject *> animated;
+
+    // Render component, by draw order
+    std::vector<int> renderables;
+    std::vector<int> drawOrders;                // by handle index
+
+    JUCE_LEAK_DETECTOR(EntityStore)
+};
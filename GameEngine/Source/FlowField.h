@@ -0,0 +1,309 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "NavGrid.h"
+#include <algorithm>
+#include <vector>
+
+/** The way an enemy should go to follow a FlowField from where it is */
+struct NavStep
+{
+    /** -1 to go left, 1 to go right, 0 when there is no route known */
+    int across = 0;
+
+    /** Whether the route goes up from here, over a block in the way */
+    bool climb = false;
+};
+
+/** The distance, in cells, from every open cell of a NavGrid around a
+    target to the target's cell, going around the blocks. Every enemy
+    chasing the target reads its way from the same field, so the cost of
+    chasing does not grow with the number of chasers.
+
+    The field covers a square window of cells around the target, and is
+    worked out again only when the target moves into another cell. When the
+    level's blocks change it is repaired instead: the distances that went
+    through a cell that became filled are cleared, and the search is run
+    again from the edges of the cleared cells and of the cells that became
+    empty only.
+ */
+class FlowField
+{
+public:
+    FlowField (NavGrid & navGrid)
+        : navGrid (navGrid)
+    {
+        setRadius (32);
+    }
+
+    /** Sets how many cells the field reaches out from the target */
+    void setRadius (int cells)
+    {
+        radius = cells;
+        size = 2 * radius + 1;
+        distances.assign ((size_t) size * size, (int) unreachable);
+        queue.reserve ((size_t) size * size);
+        seeds.reserve ((size_t) size * size);
+        builtRevision = 0;
+        isBuilt = false;
+    }
+
+    /** Moves the target to a position, working out the field again if it
+        is in another cell, or repairing it if the level's blocks have changed
+        since. Returns true if it was worked out or repaired.
+     */
+    bool update (float targetX, float targetY)
+    {
+        const int cellX = navGrid.getCellX (targetX);
+        const int cellY = navGrid.getCellY (targetY);
+        const bool sameCell = isBuilt && cellX == targetCellX && cellY == targetCellY;
+
+        if (sameCell && builtRevision == navGrid.getRevision())
+            return false;
+
+        targetCellX = cellX;
+        targetCellY = cellY;
+
+        if (!sameCell || !repair())
+            build();
+
+        builtRevision = navGrid.getRevision();
+        isBuilt = true;
+        return true;
+    }
+
+    /** Returns the way to go from a position towards the target */
+    NavStep getStep (float x, float y)
+    {
+        NavStep step;
+
+        if (!isBuilt)
+            return step;
+
+        const int cellX = navGrid.getCellX (x);
+        const int cellY = navGrid.getCellY (y);
+        const int here = getDistance (cellX, cellY);
+
+        if (here == unreachable || here == 0)
+            return step;
+
+        const int left = getDistance (cellX - 1, cellY);
+        const int right = getDistance (cellX + 1, cellY);
+        const int up = getDistance (cellX, cellY + 1);
+
+        if (up < here && up < jmin (left, right))
+        {
+            // The way is up, over the block in the way towards the target
+            step.climb = true;
+            step.across = targetCellX < cellX ? -1 : (targetCellX > cellX ? 1 : 0);
+        }
+        else if (left < right)
+        {
+            step.across = -1;
+        }
+        else if (right < left)
+        {
+            step.across = 1;
+        }
+        else if (left != unreachable)
+        {
+            step.across = targetCellX < cellX ? -1 : 1;
+        }
+
+        return step;
+    }
+
+private:
+    static const int unreachable = 0x7fffffff;
+
+    int getDistance (int cellX, int cellY) const
+    {
+        const int x = cellX - targetCellX + radius;
+        const int y = cellY - targetCellY + radius;
+
+        if (x < 0 || y < 0 || x >= size || y >= size)
+            return unreachable;
+
+        return distances[y * size + x];
+    }
+
+    /** A cell of the window with the distance it had when it was listed */
+    struct Seed
+    {
+        int cell;
+        int distance;
+    };
+
+    /** Calls a function with each neighbour of a cell inside the window */
+    template <typename Function>
+    void forEachNeighbour (int cell, Function function) const
+    {
+        const int x = cell % size;
+        const int y = cell / size;
+
+        if (x > 0)        function (cell - 1);
+        if (x < size - 1) function (cell + 1);
+        if (y > 0)        function (cell - size);
+        if (y < size - 1) function (cell + size);
+    }
+
+    bool isBlockedCell (int cell) const
+    {
+        return navGrid.isBlocked (cell % size + targetCellX - radius, cell / size + targetCellY - radius);
+    }
+
+    /** A breadth first search out from the target through the open cells */
+    void build()
+    {
+        std::fill (distances.begin(), distances.end(), (int) unreachable);
+
+        const int start = radius * size + radius;
+        distances[start] = 0;
+
+        seeds.clear();
+        seeds.push_back ({ start, 0 });
+        flood();
+    }
+
+    /** Brings the field up to date with the cells that became filled or
+        empty since it was built. Returns false if it has to be built again
+        instead, when the changes are no longer known or the target's own
+        cell changed.
+     */
+    bool repair()
+    {
+        const int start = radius * size + radius;
+        bool targetChanged = false;
+
+        seeds.clear();
+        queue.clear();
+
+        const bool known = navGrid.forEachChangeSince (builtRevision, [&] (int cellX, int cellY)
+        {
+            const int x = cellX - targetCellX + radius;
+            const int y = cellY - targetCellY + radius;
+
+            if (x < 0 || y < 0 || x >= size || y >= size)
+                return;
+
+            const int cell = y * size + x;
+
+            if (cell == start)
+                targetChanged = true;
+            else if (isBlockedCell (cell))
+                clearDistancesThrough (cell);
+            else
+                queue.push_back (cell);
+        });
+
+        if (!known || targetChanged)
+            return false;
+
+        // The search starts again from the edges of the cleared and the
+        // emptied cells, nearest first
+        for (int cell : queue)
+        {
+            forEachNeighbour (cell, [this] (int neighbour)
+            {
+                if (distances[neighbour] != unreachable)
+                    seeds.push_back ({ neighbour, distances[neighbour] });
+            });
+        }
+
+        std::sort (seeds.begin(), seeds.end(), [] (const Seed & a, const Seed & b)
+        {
+            return a.distance < b.distance;
+        });
+
+        flood();
+        return true;
+    }
+
+    /** Clears the distance of a cell that became filled and of every cell
+        whose route to the target could have gone through it, listing the
+        cleared cells in the queue
+     */
+    void clearDistancesThrough (int blockedCell)
+    {
+        if (distances[blockedCell] == unreachable)
+            return;
+
+        cleared.clear();
+        cleared.push_back ({ blockedCell, distances[blockedCell] });
+        distances[blockedCell] = unreachable;
+
+        for (size_t next = 0; next < cleared.size(); next++)
+        {
+            const Seed current = cleared[next];
+            queue.push_back (current.cell);
+
+            forEachNeighbour (current.cell, [this, current] (int neighbour)
+            {
+                if (distances[neighbour] == current.distance + 1)
+                {
+                    cleared.push_back ({ neighbour, distances[neighbour] });
+                    distances[neighbour] = unreachable;
+                }
+            });
+        }
+    }
+
+    /** The breadth first search through the open cells from the seeds,
+        which are in order of distance. Cells are taken from the seeds and
+        from the cells reached so far, whichever is nearer, so that every
+        cell is reached first along its shortest route.
+     */
+    void flood()
+    {
+        queue.clear();
+        size_t nextSeed = 0;
+        size_t next = 0;
+
+        while (nextSeed < seeds.size() || next < queue.size())
+        {
+            int cell;
+
+            if (next < queue.size() && (nextSeed == seeds.size() || distances[queue[next]] <= seeds[nextSeed].distance))
+            {
+                cell = queue[next++];
+            }
+            else
+            {
+                const Seed & seed = seeds[nextSeed++];
+
+                // Reached by a shorter route since it was listed
+                if (distances[seed.cell] != seed.distance)
+                    continue;
+
+                cell = seed.cell;
+            }
+
+            const int distance = distances[cell] + 1;
+
+            forEachNeighbour (cell, [this, distance] (int neighbour)
+            {
+                if (distances[neighbour] <= distance || isBlockedCell (neighbour))
+                    return;
+
+                distances[neighbour] = distance;
+                queue.push_back (neighbour);
+            });
+        }
+    }
+
+    NavGrid & navGrid;
+
+    int radius;
+    int size;
+    std::vector<int> distances;     // row by row, the target in the middle
+    std::vector<int> queue;
+    std::vector<Seed> seeds;
+    std::vector<Seed> cleared;
+
+    int targetCellX = 0;
+    int targetCellY = 0;
+    uint32 builtRevision;
+    bool isBuilt;
+
+    JUCE_LEAK_DETECTOR(FlowField)
+};
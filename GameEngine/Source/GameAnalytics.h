@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameEvents.h"
+
+/** Tallies the GameEvents of a play session on its own thread, and reports
+    the session when it ends, with the player dying or winning. Each report
+    is a line appended to the report file, see setReportFile().
+ */
+class GameAnalytics : public Thread
+{
+public:
+    GameAnalytics() : Thread ("GameAnalytics")
+    {
+        for (int i = 0; i < GameEvent::numTypes; i++)
+            counts[i] = 0;
+    }
+
+    ~GameAnalytics()
+    {
+        stopThread (500);
+    }
+
+    /** Sets the file the sessions are reported to, must be called before
+        the thread is started. Nothing is written without one.
+     */
+    void setReportFile (const File & file)
+    {
+        reportFile = file;
+    }
+
+    /** The queue to subscribe to the GameLogic's GameEventBus */
+    GameEventQueue & getEvents()
+    {
+        return events;
+    }
+
+    /** Events of a type in the session so far */
+    int getCount (GameEvent::Type type) const
+    {
+        return counts[type].get();
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            events.drain ([this] (const GameEvent & event)
+            {
+                if (!inSession)
+                {
+                    inSession = true;
+                    firstTick = event.tick;
+                }
+
+                ++counts[event.type];
+
+                if (event.type == GameEvent::playerDied
+                    || (event.type == GameEvent::checkpointReached && event.level < 0))
+                    endSession (event);
+            });
+
+            wait (100);
+        }
+    }
+
+private:
+    void endSession (const GameEvent & lastEvent)
+    {
+        const String report = Time::getCurrentTime().toISO8601 (true)
+            + " session of " + String ((int) (lastEvent.tick - firstTick)) + " ticks "
+            + (lastEvent.type == GameEvent::playerDied ? "lost" : "won")
+            + ": " + String (counts[GameEvent::coinCollected].get()) + " coins, "
+            + String (counts[GameEvent::enemyStomped].get()) + " enemies stomped, "
+            + String (counts[GameEvent::playerDamaged].get()) + " lives lost, "
+            + String (counts[GameEvent::checkpointReached].get()) + " checkpoints, "
+            + String (events.getNumDropped()) + " events dropped";
+
+        DBG (report);
+
+        if (reportFile != File())
+            reportFile.appendText (report + "\n");
+
+        for (int i = 0; i < GameEvent::numTypes; i++)
+            counts[i] = 0;
+
+        inSession = false;
+    }
+
+    GameEventQueue events;
+    File reportFile;
+
+    Atomic<int> counts[GameEvent::numTypes];
+    bool inSession = false;
+    uint32 firstTick = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GameAnalytics)
+};
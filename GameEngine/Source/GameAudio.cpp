@@ -12,10 +12,15 @@
 GameAudio::GameAudio()
 {
     formatManager.registerBasicFormats();
+    muted = false;
+
+    startTimer (10);
 }
 
 GameAudio::~GameAudio()
 {
+    stopTimer();
+
     // MixerAudioSource shutdown
     this->removeAllInputs();    // Unregister and delete all AudioFormatReaderSources currently connected
     this->releaseResources();
@@ -24,6 +29,9 @@ GameAudio::~GameAudio()
 
 void GameAudio::playAudioFile (File & audioFile, bool looping)
 {
+    if (muted)
+        return;
+
     AudioFormatReader* reader = formatManager.createReaderFor (audioFile);
     
     if (reader != nullptr)
@@ -50,3 +58,15 @@ void GameAudio::playAudioFile (File & audioFile, bool looping)
         new SelfDeletingPositionalAudioSource(newSource, this); // Whoa whoa whoa this is crazy dude, calm the crap down. Who do you think you are?
     }
 }
+
+void GameAudio::timerCallback()
+{
+    events.drain ([this] (const GameEvent & event)
+    {
+        if (event.sound != File())
+        {
+            File audioFile (event.sound);
+            playAudioFile (audioFile, false);
+        }
+    });
+}
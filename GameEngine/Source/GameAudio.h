@@ -10,8 +10,14 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "SelfDeletingPositionalAudioSource.h"
+#include "GameEvents.h"
 
-class GameAudio : public MixerAudioSource
+/** Plays the sounds of the game. It consumes the GameEvents of the
+    GameLogic, and the events are drained and their files opened on the
+    message thread, so gameplay never waits on the disk.
+ */
+class GameAudio : public MixerAudioSource,
+                  private Timer
 {
 public:
     GameAudio();
@@ -26,8 +32,30 @@ public:
      audio file and play it over and over
      */
     void playAudioFile (File & audioFile, bool looping);
+
+    /** While muted, playAudioFile() does nothing. Simulations that run
+        without an audio device are muted so their sounds do not pile up in
+        the mixer.
+     */
+    void setMuted (bool shouldBeMuted)
+    {
+        muted = shouldBeMuted;
+    }
+
+    /** The queue to subscribe to the GameLogic's GameEventBus */
+    GameEventQueue & getEvents()
+    {
+        return events;
+    }
     
 private:
+    /** Plays the sound of every event that has one */
+    void timerCallback() override;
+
     /** Manages the audio formats that can be read */
     AudioFormatManager formatManager;
+
+    bool muted;
+
+    GameEventQueue events;
 };
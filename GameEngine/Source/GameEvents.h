@@ -0,0 +1,265 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <vector>
+
+/** Something that happened in the gameplay of a tick, for the parts of the
+    engine that react to the game without changing it: audio, the HUD and
+    analytics.
+
+    Only the fields of an event's type are filled in. Events hold copies of
+    what their consumers need, never a GameObject, since the object may be
+    deleted by the time another thread reads the event.
+ */
+struct GameEvent
+{
+    enum Type
+    {
+        collision = 0,      // two solid objects hit, sound
+        coinCollected,      // points, sound
+        enemyStomped,       // points, sound
+        playerDamaged,      // lives left, sound
+        playerDied,         // sound
+        checkpointReached,  // level gone to, or -1 for a win, sound
+        playerStatus,       // score and lives of player 1 have changed
+        numTypes
+    };
+
+    Type type = collision;
+
+    /** The tick of the GameLogic the event happened in */
+    uint32 tick = 0;
+
+    /** Where it happened in the world */
+    float x = 0.0f, y = 0.0f;
+
+    int points = 0;
+    int level = 0;
+    int score = 0;
+    int lives = 0;
+
+    /** The audio file to play for the event, if there is one */
+    File sound;
+};
+
+/** A fixed size ring buffer of GameEvents from one thread to another.
+
+    The GameEventBus writes to it from the GameLogic thread and its consumer
+    drains it on its own thread, without locks and without allocating. When
+    the consumer falls so far behind that the buffer is full, new events are
+    dropped and counted rather than blocking the game.
+
+    A playerStatus event is the state of player 1 rather than something that
+    happened, so it does not go through the buffer. The queue keeps only the
+    latest one in a slot of its own, which the next drain hands over after
+    the buffered events. A status is never dropped, and the consumer always
+    ends up with the current one.
+ */
+class GameEventQueue
+{
+public:
+    GameEventQueue (int capacity = 512)
+        : fifo (capacity), events ((size_t) capacity)
+    {
+    }
+
+    /** Adds an event, returns false if the queue was full. Called by the
+        GameEventBus only.
+     */
+    bool push (const GameEvent & event)
+    {
+        if (event.type == GameEvent::playerStatus)
+        {
+            const ScopedLock lock (statusLock);
+            latestStatus = event;
+            hasStatus = true;
+            return true;
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+        {
+            ++numDropped;
+            return false;
+        }
+
+        events[(size_t) (size1 > 0 ? start1 : start2)] = event;
+        fifo.finishedWrite (1);
+        return true;
+    }
+
+    /** Calls consumer (event) for every event written since the last drain,
+        in order, then for the latest playerStatus if one came since, and
+        returns how many there were. Called by the consumer's thread only.
+     */
+    template <typename Consumer>
+    int drain (Consumer && consumer)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; i++)
+            consumer ((const GameEvent &) events[(size_t) (start1 + i)]);
+
+        for (int i = 0; i < size2; i++)
+            consumer ((const GameEvent &) events[(size_t) (start2 + i)]);
+
+        fifo.finishedRead (size1 + size2);
+
+        GameEvent status;
+        bool statusChanged;
+
+        {
+            const ScopedLock lock (statusLock);
+            statusChanged = hasStatus;
+
+            if (statusChanged)
+            {
+                status = latestStatus;
+                hasStatus = false;
+            }
+        }
+
+        if (statusChanged)
+            consumer ((const GameEvent &) status);
+
+        return size1 + size2 + (statusChanged ? 1 : 0);
+    }
+
+    /** Events dropped because the queue was full */
+    int getNumDropped() const
+    {
+        return numDropped.get();
+    }
+
+private:
+    AbstractFifo fifo;
+    std::vector<GameEvent> events;
+    Atomic<int> numDropped;
+
+    /** The latest playerStatus not yet drained */
+    GameEvent latestStatus;
+    bool hasStatus = false;
+    CriticalSection statusLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GameEventQueue)
+};
+
+/** Carries the GameEvents of the GameLogic to the consumers subscribed to
+    it.
+
+    Gameplay posts events while a tick is processed, and they are kept
+    until the tick is published at its end, then written to the queue of
+    every consumer. A consumer sees the events of a tick all at once, and
+    a slow consumer only loses events of its own. After the first ticks
+    nothing is allocated: the tick's events go into storage that is kept,
+    and the queues are fixed in size.
+ */
+class GameEventBus
+{
+public:
+    GameEventBus()
+    {
+        tickEvents.reserve (maxEventsPerTick);
+        tick = 0;
+        numDropped = 0;
+    }
+
+    /** Adds a queue to be written the events of every tick published from
+        now on. The queue must be unsubscribed before it is deleted.
+     */
+    void subscribe (GameEventQueue & queue)
+    {
+        const ScopedLock lock (queuesLock);
+        queues.addIfNotAlreadyThere (&queue);
+    }
+
+    void unsubscribe (GameEventQueue & queue)
+    {
+        const ScopedLock lock (queuesLock);
+        queues.removeFirstMatchingValue (&queue);
+    }
+
+    /** Adds an event to the tick being processed. Called by the GameLogic
+        thread only.
+     */
+    void post (const GameEvent & event)
+    {
+        if ((int) tickEvents.size() >= maxEventsPerTick)
+        {
+            numDropped++;
+            return;
+        }
+
+        tickEvents.push_back (event);
+        tickEvents.back().tick = tick;
+    }
+
+    /** Posts an event of a type that only has a position and a sound */
+    void post (GameEvent::Type type, float x, float y, const File * sound)
+    {
+        GameEvent event;
+        event.type = type;
+        event.x = x;
+        event.y = y;
+
+        if (sound != nullptr)
+            event.sound = *sound;
+
+        post (event);
+    }
+
+    /** Writes the events of the tick to every queue and starts the next
+        tick. Called by the GameLogic thread at the end of every tick.
+     */
+    void publish()
+    {
+        if (!tickEvents.empty())
+        {
+            const ScopedLock lock (queuesLock);
+
+            for (auto queue : queues)
+                for (auto & event : tickEvents)
+                    queue->push (event);
+
+            tickEvents.clear();
+        }
+
+        tick++;
+    }
+
+    /** The events posted in the tick being processed, for the parts of the
+        GameLogic thread that react to them before they are published
+     */
+    const std::vector<GameEvent> & getTickEvents() const
+    {
+        return tickEvents;
+    }
+
+    uint32 getTick() const
+    {
+        return tick;
+    }
+
+    /** Events dropped because more than maxEventsPerTick were posted in a
+        tick
+     */
+    int getNumDropped() const
+    {
+        return numDropped;
+    }
+
+    static const int maxEventsPerTick = 256;
+
+private:
+    std::vector<GameEvent> tickEvents;
+    uint32 tick;
+    int numDropped;
+
+    Array<GameEventQueue *> queues;
+    CriticalSection queuesLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GameEventBus)
+};
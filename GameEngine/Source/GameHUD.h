@@ -12,6 +12,7 @@
 #include "HealthBar.h"
 #include "GameObject.h"
 #include "ScoreHUD.h"
+#include "GameEvents.h"
 
 /** Renders a Heads Up Display with a transparent background.
  */
@@ -25,10 +26,10 @@ public:
         
         addAndMakeVisible(healthBar);
 		addAndMakeVisible(scoreHUD);
-		// Setup frame rate label
-		//addAndMakeVisible(frameRateLabel);
+		// Setup the profiling line, frame rate and physics profile
+		addAndMakeVisible(frameRateLabel);
 
-		frameRateLabel.setJustificationType(Justification::topRight);
+		frameRateLabel.setJustificationType(Justification::bottomLeft);
 		frameRateLabel.setFont(Font(14.0f));
 		frameRateLabel.setText("0 fps", dontSendNotification);
 
@@ -59,7 +60,7 @@ public:
         
         healthBar.setBounds(10, 10, 175, 75);
 		scoreHUD.setBounds(w - 150, 10, 150, 75);
-		frameRateLabel.setBounds(getLocalBounds().reduced(4).removeFromTop(75).translated(0.0, 20.0));
+		frameRateLabel.setBounds(getLocalBounds().reduced(4).removeFromBottom(20));
     }
 
     /** Consider getting rid of this ... 
@@ -72,14 +73,33 @@ public:
     
 	void setFrameRate(int frameRate)
 	{
-		frameRateLabel.setText(String(frameRate) + " fps", dontSendNotification);
+		frameRateLabel.setText(String(frameRate) + " fps | " + physicsProfile, dontSendNotification);
 		repaint();
 	}
 
-	void setAttributes(map<String,var> attrs) {
-		healthBar.setLives(attrs["lives"]);
-		scoreHUD.setScore(attrs["score"]);
-		healthBar.setLifeTexture(File(attrs["playerLifeTexture"].toString()));
+	/** The queue to subscribe to the GameLogic's GameEventBus */
+	GameEventQueue & getEvents() {
+		return events;
+	}
+
+	/** Takes the score and lives of player 1 from the events published
+		since the last frame. Called by the GameView every frame it renders.
+	*/
+	void processEvents() {
+		events.drain([this] (const GameEvent & event) {
+			if (event.type == GameEvent::playerStatus) {
+				healthBar.setLives(event.lives);
+				scoreHUD.setScore(event.score);
+			}
+		});
+	}
+
+	/** Takes what the HUD shows that is not gameplay, from the frame being
+		rendered
+	*/
+	void setFrameState(const File & lifeTexture, const String & physicsProfile) {
+		healthBar.setLifeTexture(lifeTexture);
+		this->physicsProfile = physicsProfile;
 	}
 
     
@@ -88,4 +108,9 @@ private:
 	ScoreHUD scoreHUD;
 
 	Label frameRateLabel;
+
+	/** The level's physics profile, see PhysicsStatistics::getSummary() */
+	String physicsProfile;
+
+	GameEventQueue events;
 };
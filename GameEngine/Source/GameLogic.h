@@ -2,25 +2,44 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
-#include "GameAudio.h"
+#include "GameEvents.h"
 #include "PhysicalAction.h"
 
 #include "InputManager.h"
 #include "RenderSwapFrame.h"
+#include "PhysicsThread.h"
+#include "InputLog.h"
+#include <atomic>
 /** Processes the logic of the game. Started by the Core Engine and manipulates
     the GameDataModel to be rendered for the next frame.
+
+    What happens in the gameplay, such as coins being collected and the
+    player dying, is posted to its GameEventBus and published at the end of
+    every tick, for the audio, the HUD and analytics to react to on their
+    own threads.
  */
 class GameLogic : public Thread
 {
 public:
-	GameLogic(GameAudio & gameAudio, CriticalSection * objectDeletionLock) : Thread("GameLogic"), gameAudio(gameAudio)
+	GameLogic(CriticalSection * objectDeletionLock) : Thread("GameLogic")
     {
         //inputManager = new InputManager();
 		gamePaused = true;
+		pauseRequested = true;
         this->objectDeletionLock = objectDeletionLock;
 
-		currentTime = Time::currentTimeMillis();
+		wallTime = Time::currentTimeMillis();
+		currentTime = 0;
+		deltaTime = 0;
 		checkTime = 0;
+		sessionTimeStep = 0.0f;
+		sessionStartTime = 0;
+		sessionTicks = 0;
+		lastStepMs = 0.0f;
+		aiBudgetMs = 1.0;
+		aiBudgeted = true;
+		postedScore = -1;
+		postedLives = -1;
 
 		currLevel = nullptr;
     }
@@ -47,16 +66,19 @@ public:
 		gameOver->getGameObjects().getLast()->getRenderableObject().animationProperties.setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/gameOver.png"));
 		gameOver->getGameObjects().getLast()->setScale(12, 12);
 	}
-	/** Sets whether or not the game is paused.
+	/** Sets whether or not the game is paused. Safe to call from any
+		thread, the GameLogic thread pauses or resumes at the start of its
+		next tick. The editor may add objects straight away, making a body
+		waits for a step still running, see WorldPhysics::createBody().
 	*/
 	void setPaused(bool paused)
 	{
-		gamePaused = paused;
+		pauseRequested = paused;
 	}
 
-	/* Gets the current pause/play state of the game*/
+	/* Gets the pause/play state the game was last set to*/
 	bool isPaused() {
-		return gamePaused;
+		return pauseRequested;
 	}
 
     /** Sets the GameModel current frame being processed for logic, and the
@@ -67,37 +89,42 @@ public:
 		gameModelCurrentFrame = curentFrame;
 	}
 	void playerRespawn() {
-		int lives = currLevel->getPlayer(0)->getCurrLives() - 1;
+		PlayerObject * player = currLevel->getPlayer(0);
+		GameEvent event;
+		event.type = GameEvent::playerDamaged;
+		event.x = player->getPosition().x;
+		event.y = player->getPosition().y;
+
+		int lives = player->getCurrLives() - 1;
 		currLevel->resetLevel();
-		currLevel->getPlayer(0)->setScore(currLevel->getPlayer(0)->getScore());
-		currLevel->getPlayer(0)->setCurrLives(lives);
-		File * audioFile = gameModelCurrentFrame->getCurrentLevel()->getPlayer(0)->getAudioFileForAction(PhysicalAction::death);
+		player->setScore(player->getScore());
+		player->setCurrLives(lives);
 
-		// If audio file was not in the map, do nothing
-		if (audioFile != nullptr)
-		{
-			gameAudio.playAudioFile(*audioFile, false);
-		}
+		event.lives = lives;
+		if (const File * audioFile = player->getAudioFileForAction(PhysicalAction::death))
+			event.sound = *audioFile;
+		events.post(event);
 	}
 	void playerDied() {
-		gameOver->getPlayer(0)->setScore(currLevel->getPlayer(0)->getScore());
+		PlayerObject * player = currLevel->getPlayer(0);
+		gameOver->getPlayer(0)->setScore(player->getScore());
 		gameOver->getPlayer(0)->setLives(0);
-		File * audioFile = gameModelCurrentFrame->getCurrentLevel()->getPlayer(0)->getAudioFileForAction(PhysicalAction::death);
-
-		// If audio file was not in the map, do nothing
-		if (audioFile != nullptr)
-		{
-			gameAudio.playAudioFile(*audioFile, false);
-		}
+		events.post(GameEvent::playerDied, player->getPosition().x, player->getPosition().y,
+			player->getAudioFileForAction(PhysicalAction::death));
 		currLevel = gameOver;
 	}
+	/** Posts a collision of an object that has collision audio */
+	void postCollision(GameObject * object) {
+		if (object == nullptr)
+			return;
+
+		// Objects without a sound make no event
+		if (const File * audioFile = object->getAudioFileForAction(PhysicalAction::collsion))
+			events.post(GameEvent::collision, object->getPosition().x, object->getPosition().y, audioFile);
+	}
 	bool boundsCollision() {
-		bool dead = false;
-		if((currLevel->getPlayer(0)->getPhysicsProperties().GetPosition() - 
-			currLevel->getFloor()->getPhysicsProperties().GetPosition()).y < 1.5 ) {
-			dead = true;
-		}
-		return dead;
+		// Set by the level's WorldBounds after the last physics step
+		return currLevel->hasPlayerLeftWorldBounds();
 	}
 	/** Sets the Render swap frame that will be processed for logic before it
 	is sent to the GameView to be rendered.
@@ -146,7 +173,285 @@ public:
 		currLevel->resetLevel();
 	}
 
+	/** Starts recording the ticks that are played into an InputLog. The
+		current level is reset first, so the recording starts from the state
+		the game is serialized in. Called while the game is paused. While
+		recording, the game runs on fixed ticks (see advanceSessionTick).
+	*/
+	void startRecording() {
+		Level * level = gameModelCurrentFrame->getCurrentLevel();
+		level->resetLevel();
+		level->resetEnemyAI();
+
+		// A time budget makes the AI depend on how fast the machine is, so
+		// it is lifted while recording for the replay to make the same calls
+		aiBudgeted = false;
+
+		PlayerObject * player = level->getPlayer(0);
+		WorldPhysics & physics = level->getWorldPhysics();
+
+		InputLog * log = new InputLog();
+		log->setGame(gameModelCurrentFrame->serializeToValueTree());
+		log->setTimeStep(physics.getTimeStep(), physics.getVelocityIterations(), physics.getPositionIterations());
+		log->setPlayerState(player->getScore(), player->getCurrScore(), player->getCurrLives());
+
+		const ScopedLock lock(recordingLock);
+		recording = log;
+	}
+
+	/** The events of the gameplay, for consumers to subscribe to */
+	GameEventBus & getEvents() {
+		return events;
+	}
+
+	/** Stops recording and returns the log recorded since startRecording(),
+		or nullptr if nothing was being recorded
+	*/
+	InputLog * stopRecording() {
+		const ScopedLock lock(recordingLock);
+		aiBudgeted = true;
+		return recording.release();
+	}
+
+	/** How long a replayed tick took, and whether it ended in the state
+		that was recorded
+	*/
+	struct TickTiming
+	{
+		double frameMs;
+		float stepMs;
+		bool matches;
+	};
+
+	/** Plays a recorded session back on the calling thread, without input
+		or a view to render to, and fills in how long each tick took. The
+		GameModel must have been built from the log's game and the GameLogic
+		thread must not be running.
+
+		@return true if every tick ended in the state that was recorded
+	*/
+	bool replay(InputLog & log, std::vector<TickTiming> & timings) {
+		Level * level = gameModelCurrentFrame->getCurrentLevel();
+		WorldPhysics & physics = level->getWorldPhysics();
+
+		if (log.getTimeStep() != physics.getTimeStep()
+			|| log.getVelocityIterations() != physics.getVelocityIterations()
+			|| log.getPositionIterations() != physics.getPositionIterations()) {
+			DBG("Replay: the log was recorded with a different physics step");
+			return false;
+		}
+
+		createVictory();
+		createGameOver();
+
+		// Start play the way the editor does
+		level->markStaticGeometryDirty();
+		level->captureResetState();
+
+		PlayerObject * player = level->getPlayer(0);
+		player->setScore(log.getScore());
+		player->addCurrScore(log.getCurrScore() - log.getScore());
+		player->setCurrLives(log.getCurrLives());
+
+		gameModelCurrentFrame->setIsGameOver(false);
+		pauseRequested = false;
+		gamePaused = false;
+		aiBudgeted = false;
+		currentTime = 0;
+		checkTime = 0;
+		beginSession(log.getTimeStep());
+		oldCommands.clear();
+
+		physicsThread.startThread();
+
+		bool allMatch = true;
+		timings.clear();
+		timings.reserve(log.getTicks().size());
+
+		for (auto & tick : log.getTicks()) {
+			advanceSessionTick();
+			checkTime += deltaTime;
+			newCommands = tick.commands;
+
+			const double frameStart = Time::getMillisecondCounterHiRes();
+
+			processFrame();
+
+			TickTiming timing;
+			timing.frameMs = Time::getMillisecondCounterHiRes() - frameStart;
+			timing.stepMs = lastStepMs;
+			timing.matches = getStateChecksum() == tick.checksum;
+
+			timings.push_back(timing);
+			allMatch = allMatch && timing.matches;
+		}
+
+		setPaused(true);
+		applyPause(true);
+		physicsThread.stop();
+		beginSession(0.0f);
+
+		return allMatch;
+	}
+
 private:
+	/** Pauses or resumes the game on the thread running the logic. Pausing
+		collects the step that is still running, so only this thread ever
+		finishes or syncs a step and the editor never changes a world while
+		it is being stepped.
+	*/
+	void applyPause(bool paused)
+	{
+		if (paused == gamePaused)
+			return;
+
+		gamePaused = paused;
+
+		if (paused)
+		{
+			if (Level * steppedLevel = physicsThread.finishStep())
+			{
+				steppedLevel->syncWithWorldPhysics();
+				steppedLevel->getWorldPhysics().clearContactEvents();
+			}
+		}
+	}
+
+	/** Starts running on fixed ticks of a physics timestep, counted from
+		the current game time, or goes back to the wall clock for a timestep
+		of 0
+	*/
+	void beginSession(float32 timeStep)
+	{
+		sessionTimeStep = timeStep;
+		sessionStartTime = currentTime;
+		sessionTicks = 0;
+	}
+
+	/** Moves the game time on by one fixed tick of the session being
+		recorded or replayed. The time of a tick is worked out from the
+		number of ticks since the session started rather than added up from
+		frame times, so a recording and its replay go through the same times
+	*/
+	void advanceSessionTick()
+	{
+		++sessionTicks;
+
+		const int64 tickTime = sessionStartTime + (int64) (sessionTicks * (double) sessionTimeStep * 1000.0 + 0.5);
+		deltaTime = tickTime - currentTime;
+		currentTime = tickTime;
+	}
+
+	/** The timestep of the session being recorded, or 0 if there is none */
+	float32 getRecordingTimeStep() {
+		const ScopedLock lock(recordingLock);
+		return recording != nullptr ? recording->getTimeStep() : 0.0f;
+	}
+
+	/** A trigger sensor of a GameObject entered by another GameObject */
+	struct Trigger
+	{
+		GameObject * sensorObject;
+		GameObject * visitor;
+	};
+
+	/** Handles the player entering the trigger sensor of an enemy,
+		collectable or goal point. Returns true if the level was reset or
+		left, in which case the rest of the frame's triggers are dropped.
+	*/
+	bool processTrigger(const Trigger & trigger) {
+		PlayerObject * player = currLevel->getPlayer(0);
+
+		if (trigger.visitor != player)
+			return false;
+
+		switch (trigger.sensorObject->getObjType()) {
+		case Enemy:
+		{
+			EnemyObject * enemy = static_cast<EnemyObject*>(trigger.sensorObject);
+
+			if (!enemy->getIsActive())
+				break;
+
+			if (!enemy->collision(*player, currLevel->getEnemyPoints())) {
+				GameEvent event;
+				event.type = GameEvent::enemyStomped;
+				event.x = enemy->getPosition().x;
+				event.y = enemy->getPosition().y;
+				event.points = currLevel->getEnemyPoints();
+				if (const File * audioFile = enemy->getAudioFileForAction(PhysicalAction::death))
+					event.sound = *audioFile;
+				events.post(event);
+
+				currLevel->enemyStomped(enemy);
+			}
+			else {
+				if (player->getCurrLives() - 1 == 0) {
+					playerDied();
+					gameModelCurrentFrame->setIsGameOver(true);
+				}
+				else
+				{
+					playerRespawn();
+				}
+				return true;
+			}
+			break;
+		}
+		case Collectable:
+		{
+			CollectableObject * collectable = static_cast<CollectableObject*>(trigger.sensorObject);
+
+			if (collectable->collision(*player)) {
+				player->addCurrScore(currLevel->getCollectablePoints());
+				currLevel->collectablePicked(collectable);
+
+				GameEvent event;
+				event.type = GameEvent::coinCollected;
+				event.x = collectable->getPosition().x;
+				event.y = collectable->getPosition().y;
+				event.points = currLevel->getCollectablePoints();
+				if (const File * audioFile = collectable->getAudioFileForAction(PhysicalAction::death))
+					event.sound = *audioFile;
+				events.post(event);
+			}
+			break;
+		}
+		case Checkpoint:
+		{
+			GoalPointObject * chkPoint = static_cast<GoalPointObject*>(trigger.sensorObject);
+			bool levelLeft = false;
+
+			GameEvent event;
+			event.type = GameEvent::checkpointReached;
+			event.x = chkPoint->getPosition().x;
+			event.y = chkPoint->getPosition().y;
+			event.level = chkPoint->getToWin() ? -1 : chkPoint->getLevelToGoTo() - 1;
+			if (const File * audioFile = chkPoint->getAudioFileForAction(PhysicalAction::death))
+				event.sound = *audioFile;
+			events.post(event);
+
+			if (chkPoint->getToWin()) {
+				copyPlayerAttributes(currLevel, victory);
+				gameModelCurrentFrame->setIsGameOver(true);
+				currLevel = victory;
+				levelLeft = true;
+			}
+			else if (chkPoint->getLevelToGoTo() - 1 != gameModelCurrentFrame->getCurrentLevelIndex())
+			{
+				copyPlayerAttributes(currLevel, &gameModelCurrentFrame->getLevel(chkPoint->getLevelToGoTo() - 1));
+				gameModelCurrentFrame->setCurrentLevel(chkPoint->getLevelToGoTo() - 1);
+				currLevel->getPlayer(0)->getPhysicsProperties().setLinearVelocity(0, 0);
+				levelLeft = true;
+			}
+			return levelLeft;
+		}
+		default:
+			break;
+		}
+
+		return false;
+	}
 
 	void run()
     {
@@ -155,280 +460,367 @@ private:
 
 		createVictory();
 		createGameOver();
+
+		physicsThread.startThread();
+
 		// Main Logic loop
 		while (!threadShouldExit())
         {
 			// Wait for CoreEngine to signal() this loop
 			logicWaitable->wait();
-            
-            // Grab current level
-			if (!gameModelCurrentFrame->getIsGameOver()) {
-				currLevel = gameModelCurrentFrame->getCurrentLevel();
-			}
-
 
-			// Calculate time
 			newTime = Time::currentTimeMillis();
-			deltaTime = newTime - currentTime;
-			currentTime = newTime;
-			checkTime += deltaTime;
+			const int64 wallDelta = newTime - wallTime;
+			wallTime = newTime;
+			checkTime += wallDelta;
+
+			applyPause(pauseRequested);
 
-			if (gamePaused || gameModelCurrentFrame->getIsGameOver()) {
-				currentTime = Time::currentTimeMillis();
-				
+			// Calculate time, in fixed ticks while a session is recorded and
+			// from the wall clock otherwise
+			const float32 recordingTimeStep = gamePaused ? 0.0f : getRecordingTimeStep();
+
+			if (recordingTimeStep != sessionTimeStep)
+				beginSession(recordingTimeStep);
+
+			if (sessionTimeStep > 0.0f)
+			{
+				advanceSessionTick();
 			}
 			else
 			{
-				//	process each object (I'm sure if we looked more into contact listeners or bit masking we could've figured this out
-				//	however this is the quickest solution i could think of)
-				//	ai motions
-				if (boundsCollision()) {
-					if (gameModelCurrentFrame->getCurrentLevel()->getPlayer(0)->getCurrLives() - 1 == 0) {
-						playerDied();
-						gameModelCurrentFrame->setIsGameOver(true);
-					}
-					else
-					{
-						playerRespawn();
+				deltaTime = wallDelta;
+				currentTime += deltaTime;
+			}
 
-					}
-				}
-					for (GameObject* obj : gameModelCurrentFrame->getCurrentLevel()->getGameObjects()) {
-						switch (obj->getObjType()) {
-						case Enemy:
-							((EnemyObject*)(obj))->decision(*gameModelCurrentFrame->getCurrentLevel()->getPlayer(0), deltaTime / 1000);
-
-							if (((EnemyObject*)(obj))->getIsActive() &&
-								((EnemyObject*)(obj))->collision(*gameModelCurrentFrame->getCurrentLevel()->getPlayer(0), gameAudio,currLevel->getEnemyPoints())) {
-								if (gameModelCurrentFrame->getCurrentLevel()->getPlayer(0)->getCurrLives() - 1 == 0) {
-									playerDied();
-									gameModelCurrentFrame->setIsGameOver(true);
-								}
-								else
-								{
-									playerRespawn();
-
-								}
-
-							}
-							break;
-						case Collectable:
-							if (((CollectableObject*)(obj))->collision(*gameModelCurrentFrame->getCurrentLevel()->getPlayer(0), gameAudio)) {
-								gameModelCurrentFrame->getCurrentLevel()->getPlayer(0)->addCurrScore(gameModelCurrentFrame->getCurrentLevel()->getCollectablePoints());
-							}
-							break;
-						case Checkpoint:
-							GoalPointObject * chkPoint = (GoalPointObject*)obj;
-							if (chkPoint->collision(*gameModelCurrentFrame->getCurrentLevel()->getPlayer(0)))
-							{
-								if (chkPoint->getToWin()) {
-									copyPlayerAttributes(currLevel, victory);
-									gameModelCurrentFrame->setIsGameOver(true);
-									currLevel = victory;
-								}
-								else if(chkPoint->getLevelToGoTo()-1 != gameModelCurrentFrame->getCurrentLevelIndex())
-								{
-									copyPlayerAttributes(currLevel, &gameModelCurrentFrame->getLevel(chkPoint->getLevelToGoTo() - 1));
-									gameModelCurrentFrame->setCurrentLevel(chkPoint->getLevelToGoTo() - 1);
-									currLevel->getPlayer(0)->getPhysicsProperties().setLinearVelocity(0, 0);
-								}
-								File * audioFile = chkPoint->getAudioFileForAction(PhysicalAction::death);
-
-								// If audio file was not in the map, do nothing
-								if (audioFile != nullptr)
-								{
-									gameAudio.playAudioFile(*audioFile, false);
-								}
-							}
-							break;
-						}
-					}
-				}
-		
 			//locks in the commands for this iteration
 			inputManager->getCommands(newCommands);
 
-			for (auto & command : newCommands)
+			processFrame();
+
+			// Keep the tick for replay. Paused frames do not change the game,
+			// so only the fixed ticks that were played are recorded
+			if (sessionTimeStep > 0.0f)
+				recordTick();
+
+			// Notify CoreEngine logic is done
+			coreEngineWaitable->signal();
+		}
+
+		physicsThread.stop();
+	}
+
+	/** Processes one tick of the game for the current deltaTime and
+		newCommands: collects the last physics step and starts the next,
+		runs the gameplay and input, and fills the render swap frame. Play
+		and replay both go through here, so a replay runs the same logic.
+	*/
+	void processFrame()
+	{
+		applyPause(pauseRequested);
+
+        // Grab current level
+		if (!gameModelCurrentFrame->getIsGameOver()) {
+			currLevel = gameModelCurrentFrame->getCurrentLevel();
+		}
+
+		// Collect the physics step that ran alongside the last frame. This
+		// applies the body commands gameplay queued while it ran, and
+		// moves the objects to the results of the step
+		triggers.clear();
+
+		if (Level * steppedLevel = physicsThread.finishStep())
+		{
+			steppedLevel->syncWithWorldPhysics();
+			lastStepMs = steppedLevel->getWorldPhysics().getStatistics().getTiming(PhysicsStatistics::step).getLast();
+
+			// Summarise the rolling physics profile of the level for the HUD
+			// once a second
+			if (checkTime >= 1000)
 			{
-				switch (command)
-				{
-				
-					case GameCommand::Player1MoveUp:
-						if (!isPaused()) {
-							if (!oldCommands.contains(GameCommand::Player1MoveUp)) {
-								currLevel->getPlayer(0)->moveUp();
-							}
-							
-						}
+				checkTime = 0;
+				physicsProfile = steppedLevel->getName() + " built in " + String(steppedLevel->getBuildMs(), 1) + " ms | "
+					+ steppedLevel->getWorldPhysics().getStatistics().getSummary();
+			}
 
-						break;
-					case GameCommand::Player1MoveDown:
-						if (!isPaused()) {
-							currLevel->getPlayer(0)->moveDown();
-						}
+			// Post the collisions of both objects of every contact that
+			// began since the last frame, for their audio. Sensors that
+			// were entered are kept as triggers for the gameplay below
+			if (!gamePaused && steppedLevel == currLevel)
+			{
+				for (auto & event : steppedLevel->getWorldPhysics().getContactEvents())
+				{
+					if (event.type != ContactEvent::begin)
+						continue;
 
-						break;
-					case GameCommand::Player1MoveLeft:
-						if (!isPaused()) {
-							currLevel->getPlayer(0)->moveLeft();
-							if (!currLevel->getPlayer(0)->getRenderableObject().animationProperties.getIsAnimating()) {
-								currLevel->getPlayer(0)->getRenderableObject().animationProperties.setAnimationStartTime(currentTime);
-								currLevel->getPlayer(0)->getRenderableObject().animationProperties.setLeftAnimation(true);
-								currLevel->getPlayer(0)->getRenderableObject().animationProperties.setIsAnimating(true);
-							}
-						}
+					if (event.isSensor())
+					{
+						Trigger trigger;
+						trigger.sensorObject = event.getSensorObject();
+						trigger.visitor = event.getOther(trigger.sensorObject);
 
-						break;
-					case GameCommand::Player1MoveRight:
-						if (!isPaused()) {
-							currLevel->getPlayer(0)->moveRight();
-
-							if (!currLevel->getPlayer(0)->getRenderableObject().animationProperties.getIsAnimating()) {
-								currLevel->getPlayer(0)->getRenderableObject().animationProperties.setAnimationStartTime(currentTime);
-								currLevel->getPlayer(0)->getRenderableObject().animationProperties.setLeftAnimation(false);
-								currLevel->getPlayer(0)->getRenderableObject().animationProperties.setIsAnimating(true);
-							}
-						}
-							
-							
-						break;
-					//Player 2 commands
-					case GameCommand::Player2MoveUp:
-						if (!isPaused()) {
-							currLevel->getPlayer(1)->moveUp();
-						}
-						break;
-					case GameCommand::Player2MoveDown:
-						if (!isPaused()) {
-							currLevel->getPlayer(1)->moveDown();
-						}
-						break;
-					case GameCommand::Player2MoveLeft:
-						if (!isPaused()) {
-							currLevel->getPlayer(1)->moveLeft();
-						}
-						break;
-					case GameCommand::Player2MoveRight:
-						if (!isPaused()) {
-							currLevel->getPlayer(1)->moveRight();
-						}
-						break;
+						if (trigger.sensorObject != nullptr && trigger.visitor != nullptr)
+							triggers.push_back(trigger);
+					}
+					else
+					{
+						postCollision(event.objectA);
+						postCollision(event.objectB);
+					}
 				}
 			}
 
-            // Determine if player is not moving, if so, it should not be animating
-			if ((oldCommands.contains(GameCommand::Player1MoveRight) && !newCommands.contains(GameCommand::Player1MoveRight)) ||
-				(oldCommands.contains(GameCommand::Player1MoveLeft) && !newCommands.contains(GameCommand::Player1MoveLeft)) ||
-				(newCommands.contains(GameCommand::Player1MoveLeft) && newCommands.contains(GameCommand::Player1MoveRight))) {
+			steppedLevel->getWorldPhysics().clearContactEvents();
+		}
+
+		if (!gamePaused) {
+			// Process Physics - start the next step, it runs on the
+			// physics thread while the rest of this frame is processed.
+			// A fixed tick is exactly one step of the level's world
+			const float32 frameTime = sessionTimeStep > 0.0f ? currLevel->getWorldPhysics().getTimeStep()
+															 : deltaTime / 1000.0f;
+			physicsThread.startStep(*currLevel, frameTime);
+		}
 
-				if ((!newCommands.contains(GameCommand::Player1MoveLeft) && !newCommands.contains(GameCommand::Player1MoveRight)) ||
-					(newCommands.contains(GameCommand::Player1MoveLeft) && newCommands.contains(GameCommand::Player1MoveRight))) {
-                    
-					currLevel->getPlayer(0)->getRenderableObject().animationProperties.setIsAnimating(false);
+		if (!gamePaused && !gameModelCurrentFrame->getIsGameOver())
+		{
+			//	ai motions
+			if (boundsCollision()) {
+				if (gameModelCurrentFrame->getCurrentLevel()->getPlayer(0)->getCurrLives() - 1 == 0) {
+					playerDied();
+					gameModelCurrentFrame->setIsGameOver(true);
+				}
+				else
+				{
+					playerRespawn();
 
 				}
 			}
+				gameModelCurrentFrame->getCurrentLevel()->updateEnemyAI(deltaTime / 1000.0, aiBudgeted ? aiBudgetMs : 0.0);
+				gameModelCurrentFrame->getCurrentLevel()->updateBehaviours(deltaTime / 1000.0);
 
-			oldCommands = newCommands;
-            
-            
-            // Update gameplay data ============================================
-        
-            // Grab the camera for the level
-            Camera & levelCamera = currLevel->getCamera();
+				// Pickups, stomps and level transitions, from the trigger
+				// sensors the player entered during the last step
+				for (auto & trigger : triggers) {
+					if (processTrigger(trigger))
+						break;
+				}
+			}
+	
+		for (auto & command : newCommands)
+		{
+			switch (command)
+			{
 			
-            // Only do these things while the game is playing
-			if (!gamePaused) {                
-				// Process Physics - processes physics and updates objects positions
-				currLevel->processWorldPhysics(deltaTime);
-
-				// Play Audio
-				// If any new collisions occur, play the specified collision audio
-				for (auto & object : currLevel->getGameObjects())
-				{
-					if (object->getRenderableObject().animationProperties.getCanimate()) {
-						if (object->getRenderableObject().animationProperties.getIsAnimating()) {
-							object->getRenderableObject().animationProperties.updateAnimationCurrentTime(currentTime);
+				case GameCommand::Player1MoveUp:
+					if (!gamePaused) {
+						if (!oldCommands.contains(GameCommand::Player1MoveUp)) {
+							currLevel->getPlayer(0)->moveUp();
 						}
+						
 					}
 
-					if (object->getPhysicsProperties().hasNewCollisions())
-					{
-                        File * audioFile = object->getAudioFileForAction(PhysicalAction::collsion);
-                     
-                        // If audio file was not in the map, do nothing
-                        if (audioFile != nullptr)
-                        {
-                            gameAudio.playAudioFile(*audioFile, false);
-                        }
+					break;
+				case GameCommand::Player1MoveDown:
+					if (!gamePaused) {
+						currLevel->getPlayer(0)->moveDown();
 					}
-				}
+
+					break;
+				case GameCommand::Player1MoveLeft:
+					if (!gamePaused) {
+						currLevel->getPlayer(0)->moveLeft();
+						if (!currLevel->getPlayer(0)->getRenderableObject().animationProperties.getIsAnimating()) {
+							currLevel->getPlayer(0)->getRenderableObject().animationProperties.setAnimationStartTime(currentTime);
+							currLevel->getPlayer(0)->getRenderableObject().animationProperties.setLeftAnimation(true);
+							currLevel->getPlayer(0)->getRenderableObject().animationProperties.setIsAnimating(true);
+						}
+					}
+
+					break;
+				case GameCommand::Player1MoveRight:
+					if (!gamePaused) {
+						currLevel->getPlayer(0)->moveRight();
+
+						if (!currLevel->getPlayer(0)->getRenderableObject().animationProperties.getIsAnimating()) {
+							currLevel->getPlayer(0)->getRenderableObject().animationProperties.setAnimationStartTime(currentTime);
+							currLevel->getPlayer(0)->getRenderableObject().animationProperties.setLeftAnimation(false);
+							currLevel->getPlayer(0)->getRenderableObject().animationProperties.setIsAnimating(true);
+						}
+					}
+						
+						
+					break;
+				//Player 2 commands
+				case GameCommand::Player2MoveUp:
+					if (!gamePaused) {
+						currLevel->getPlayer(1)->moveUp();
+					}
+					break;
+				case GameCommand::Player2MoveDown:
+					if (!gamePaused) {
+						currLevel->getPlayer(1)->moveDown();
+					}
+					break;
+				case GameCommand::Player2MoveLeft:
+					if (!gamePaused) {
+						currLevel->getPlayer(1)->moveLeft();
+					}
+					break;
+				case GameCommand::Player2MoveRight:
+					if (!gamePaused) {
+						currLevel->getPlayer(1)->moveRight();
+					}
+					break;
+			}
+		}
+
+        // Determine if player is not moving, if so, it should not be animating
+		if ((oldCommands.contains(GameCommand::Player1MoveRight) && !newCommands.contains(GameCommand::Player1MoveRight)) ||
+			(oldCommands.contains(GameCommand::Player1MoveLeft) && !newCommands.contains(GameCommand::Player1MoveLeft)) ||
+			(newCommands.contains(GameCommand::Player1MoveLeft) && newCommands.contains(GameCommand::Player1MoveRight))) {
+
+			if ((!newCommands.contains(GameCommand::Player1MoveLeft) && !newCommands.contains(GameCommand::Player1MoveRight)) ||
+				(newCommands.contains(GameCommand::Player1MoveLeft) && newCommands.contains(GameCommand::Player1MoveRight))) {
                 
-                // Update camera position based on the position of player 1
-                // The player1 object will be unmoving, while the world moves around it
-                //levelCamera.setXPosition(-currLevel->getPlayer(0)->getRenderableObject().position.x);
-                levelCamera.setPositionXY(-currLevel->getPlayer(0)->getRenderableObject().position.x, 0.0f);
+				currLevel->getPlayer(0)->getRenderableObject().animationProperties.setIsAnimating(false);
+
+			}
+		}
+
+		oldCommands = newCommands;
+        
+        
+        // Update gameplay data ============================================
+    
+        // Grab the camera for the level
+        Camera & levelCamera = currLevel->getCamera();
+		
+        // Only do these things while the game is playing
+		if (!gamePaused) {                
+			for (auto object : currLevel->getEntities().getAnimated())
+			{
+				if (object->getRenderableObject().animationProperties.getIsAnimating()) {
+					object->getRenderableObject().animationProperties.updateAnimationCurrentTime(currentTime);
+				}
 			}
             
-            
-            // Update render data ==============================================
-            /** Always render, regardless of pause/play */
-            
-            // Set camera view matrix
-            renderSwapFrame->setViewMatrix(levelCamera.getViewMatrix());
-            
+            // Update camera position based on the position of player 1
+            // The player1 object will be unmoving, while the world moves around it
+            //levelCamera.setXPosition(-currLevel->getPlayer(0)->getRenderableObject().position.x);
+            levelCamera.setPositionXY(-currLevel->getPlayer(0)->getRenderableObject().position.x, 0.0f);
+		}
         
+        
+        // Update render data ==============================================
+        /** Always render, regardless of pause/play */
+        
+        // Set camera view matrix
+        renderSwapFrame->setViewMatrix(levelCamera.getViewMatrix());
+        
+    
+        /** FUTURE EFFICIENCY FEATURE:
+            Add in some pre-render visiblity checking. If an object is
+            obviously going to be out of view, do not put it in a render
+            frame.
+         */
+
+        
+        // GameObject deletion is a race condition, because a deleted object
+        // could have a function called on it such as: getRenderableObject()
+        // Therefore, we must lock here
+        objectDeletionLock->enter();
+        
+            // Create array of potentially renderable objects in view
             /** FUTURE EFFICIENCY FEATURE:
                 Add in some pre-render visiblity checking. If an object is
                 obviously going to be out of view, do not put it in a render
                 frame.
              */
 
-            
-            // GameObject deletion is a race condition, because a deleted object
-            // could have a function called on it such as: getRenderableObject()
-            // Therefore, we must lock here
-            objectDeletionLock->enter();
-            
-                // Create array of potentially renderable objects in view
-                /** FUTURE EFFICIENCY FEATURE:
-                    Add in some pre-render visiblity checking. If an object is
-                    obviously going to be out of view, do not put it in a render
-                    frame.
-                 */
-
-                vector<RenderableObject> renderableObjects;
-                for (auto gameObject : currLevel->getGameObjects())
+            // Only the objects that are drawn, hidden and pooled ones are
+            // left out
+            EntityStore & entities = currLevel->getEntities();
+
+            vector<RenderableObject> renderableObjects;
+            renderableObjects.reserve(entities.getNumRenderables());
+
+            for (int i = 0; i < entities.getNumRenderables(); i++)
+            {
+                renderableObjects.push_back(entities.getRenderable(i)->getRenderableObject());
+                
+                // If the game is playing, make sure no object is selected
+                if (!gamePaused)
                 {
-                    if (gameObject->isRenderable())
-                    {
-                        renderableObjects.push_back(gameObject->getRenderableObject());
-                        
-                        // If the game is playing, make sure no object is selected
-                        if (!isPaused())
-                        {
-                            renderableObjects.back().isSelected = false;
-                        }
-                    }
+                    renderableObjects.back().isSelected = false;
                 }
-            
-            objectDeletionLock->exit();
-            
-            // Add the renderables to the swap frame to send to GameView
-            renderSwapFrame->setRenderableObjects(renderableObjects);
+            }
+        
+        objectDeletionLock->exit();
+        
+        // Add the renderables to the swap frame to send to GameView
+        renderSwapFrame->setRenderableObjects(renderableObjects);
  
-			//Add player attributes we want to the render swap frame
-			renderSwapFrame->setAttribute("score", currLevel->getPlayer(0)->getCurrScore());
-			renderSwapFrame->setAttribute("lives", currLevel->getPlayer(0)->getCurrLives());
-			renderSwapFrame->setAttribute("playerLifeTexture", currLevel->getPlayer(0)->getIdleTexture().getFullPathName());
+		renderSwapFrame->setPlayerLifeTexture(currLevel->getPlayer(0)->getIdleTexture());
+		renderSwapFrame->setPhysicsProfile(physicsProfile);
+
+		// The HUD follows the score and lives of player 1 through events,
+		// posted whenever they change, however they were changed
+		PlayerObject * player = currLevel->getPlayer(0);
+
+		if (player->getCurrScore() != postedScore || player->getCurrLives() != postedLives) {
+			postedScore = player->getCurrScore();
+			postedLives = player->getCurrLives();
+
+			GameEvent event;
+			event.type = GameEvent::playerStatus;
+			event.x = player->getPosition().x;
+			event.y = player->getPosition().y;
+			event.score = postedScore;
+			event.lives = postedLives;
+			events.post(event);
+		}
 
+		// Behaviours waiting for these events run on the next tick
+		currLevel->getBehaviours().handleEvents(events.getTickEvents());
+		events.publish();
+	}
 
-			// Notify CoreEngine logic is done
-			coreEngineWaitable->signal();
-		}
+	/** Adds the tick just processed to the recording, if there is one */
+	void recordTick() {
+		const ScopedLock lock(recordingLock);
+
+		if (recording != nullptr)
+			recording->addTick(newCommands, getStateChecksum());
+	}
+
+	/** A checksum of the state of player 1 and the game after a tick,
+		compared between a recording and its replay
+	*/
+	uint32 getStateChecksum() {
+		PlayerObject * player = currLevel->getPlayer(0);
+		b2Vec2 position = player->getPhysicsProperties().GetPosition();
+		b2Vec2 velocity = player->getPhysicsProperties().getLinearVel();
+
+		const float32 values[] = { position.x, position.y, velocity.x, velocity.y };
+		const int32 counts[] = { player->getCurrScore(), player->getCurrLives(),
+								 gameModelCurrentFrame->getCurrentLevelIndex(), gameModelCurrentFrame->getIsGameOver() };
+
+		// FNV-1a over the bits of the values, so any difference shows
+		uint32 checksum = 2166136261u;
+		const uint8 * bytes = reinterpret_cast<const uint8 *>(values);
+
+		for (size_t i = 0; i < sizeof(values); i++)
+			checksum = (checksum ^ bytes[i]) * 16777619u;
+
+		bytes = reinterpret_cast<const uint8 *>(counts);
+
+		for (size_t i = 0; i < sizeof(counts); i++)
+			checksum = (checksum ^ bytes[i]) * 16777619u;
+
+		return checksum;
 	}
 
-    GameAudio & gameAudio;
 	GameModel* gameModelCurrentFrame;
 	RenderSwapFrame* renderSwapFrame;
 	WaitableEvent* logicWaitable;
@@ -440,15 +832,58 @@ private:
 	Array<GameCommand> oldCommands;
 
 
+	/** Wall clock time of the last tick */
+	int64 wallTime;
 	int64 newTime;
+
+	/** Game time of the tick being processed and how far it moved on */
 	int64 currentTime;
 	int64 deltaTime;
 	int64 gameLoopTime;
 
+	/** The fixed tick length of the session being recorded or replayed,
+		0 while running on the wall clock, the game time the session
+		started at and the number of ticks since */
+	float32 sessionTimeStep;
+	int64 sessionStartTime;
+	int64 sessionTicks;
+
 	//Physics World
 	WorldPhysics world;
 
-	bool gamePaused;
+	/** Steps the current level's world alongside the game logic */
+	PhysicsThread physicsThread;
+
+	/** Sensors entered during the last step, handled by the gameplay */
+	std::vector<Trigger> triggers;
+
+	/** Gameplay events, published at the end of every tick */
+	GameEventBus events;
+
+	/** Score and lives of player 1 last posted to the HUD */
+	int postedScore;
+	int postedLives;
+
+	/** One line summary of the physics profile for the HUD, the statistics
+		are only read while no step is running */
+	String physicsProfile;
+
+	/** Time of the last collected step, reported per tick by a replay */
+	float lastStepMs;
+
+	/** Time the enemies further from the players may take each tick, and
+		whether it applies, it does not while recording or replaying */
+	double aiBudgetMs;
+	bool aiBudgeted;
+
+	/** The session being recorded, or nullptr */
+	ScopedPointer<InputLog> recording;
+	CriticalSection recordingLock;
+
+	/** The pause state the logic is running in, and the one last asked for
+		by setPaused(), which the logic thread applies at its next tick */
+	std::atomic<bool> gamePaused;
+	std::atomic<bool> pauseRequested;
 	int64 checkTime;
 
 	//end game Screens
@@ -37,6 +37,12 @@ public:
 		isGameOver = false;
 	}
 
+	/** Builds a game from its serialization, see serializeToValueTree() */
+	GameModel(ValueTree gameModelValueTree) {
+
+		parseFrom(gameModelValueTree);
+	}
+
 	~GameModel(){}
 
 
@@ -88,7 +94,10 @@ public:
 
 	void parseGameModelXml(XmlElement* rootElement) {
 
-		ValueTree gameModelValueTree = ValueTree::fromXml(*rootElement);
+		parseFrom(ValueTree::fromXml(*rootElement));
+	}
+
+	void parseFrom(ValueTree gameModelValueTree) {
 
 		name = gameModelValueTree.getProperty(Identifier("name"));
 
@@ -18,17 +18,38 @@
 #include "Model.h"
 #include "RenderableObject.h"
 #include <algorithm>
+#include <atomic>
 #include "GameObjectType.h"
 #include "GameAudio.h"
+#include "Archetype.h"
 /** Represents an Object that holds vertices that can be rendered by OpenGL.
  */
-class GameObject
+class GameObject : private PhysicsProperties::TypeListener
 {
 public:
+    /** Receives a call whenever a GameObject is activated or deactivated,
+        or shown or hidden, so the level's EntityStore can keep inactive and
+        hidden objects out of the lists the gameplay and the rendering go
+        through, and whenever its type changes or
+        its body is switched between static and dynamic, which moves it
+        between those lists.
+     */
+    class ActivityListener
+    {
+    public:
+        virtual ~ActivityListener() {}
+
+        virtual void objectActivityChanged (GameObject * object) = 0;
+        virtual void objectComponentsChanged (GameObject * object) = 0;
+    };
+
     /** Constructs a GameObject and attatches it to the world's physics.
      */
-    GameObject(WorldPhysics & worldPhysics, Model* model) : physicsProperties (worldPhysics.getWorld())
+    GameObject(WorldPhysics & worldPhysics, Model* model) : physicsProperties (worldPhysics)
     {
+        // Lets contact events find the GameObject of a body
+        physicsProperties.getBody()->SetUserData (this);
+        physicsProperties.setTypeListener (this);
 
         // Come up with better default naming
 		name = "Block";
@@ -37,7 +58,7 @@ public:
 		setRenderable(false);
 		setModel(model);
 
-		objType = GameObjectType::Generic;
+		setObjType(GameObjectType::Generic);
 
 		setScore(0);
 		setLives(1);
@@ -55,15 +76,21 @@ public:
     /** Copy Constructor - Used to easily make a copy of an existing GameObject
         (this is directly used by the WorldNavigator when alt-dragging)
      */
-    GameObject (GameObject & objectToCopy, WorldPhysics & worldPhysics) : physicsProperties (worldPhysics.getWorld())
+    GameObject (GameObject & objectToCopy, WorldPhysics & worldPhysics) : physicsProperties (worldPhysics)
     {
+        physicsProperties.getBody()->SetUserData (this);
+        physicsProperties.setTypeListener (this);
         this->name = objectToCopy.name;
         this->renderable = objectToCopy.renderable;
         this->renderableObject = objectToCopy.renderableObject;
 		setMoveSpeed(objectToCopy.getMoveSpeed());
 		setJumpSpeed(objectToCopy.getJumpSpeed());
-        this->actionToAudio = objectToCopy.actionToAudio;
+        this->sounds = objectToCopy.sounds;
+        this->archetype = objectToCopy.archetype;
+        this->behaviourName = objectToCopy.behaviourName;
 		this->objType = objectToCopy.objType;
+        this->physicsProperties.setCollisionFilter (objectToCopy.getPhysicsProperties().getCategoryBits(),
+                                                    objectToCopy.getPhysicsProperties().getMaskBits());
         this->physicsProperties.setIsStatic((objectToCopy.getPhysicsProperties().getIsStatic()));
         
         // This seems odd? We want to set origin to wherever an object is placed
@@ -71,8 +98,10 @@ public:
         updateOrigin();
     }
 
-	GameObject(WorldPhysics & worldPhysics, Model* model, ValueTree gameObjectValueTree) : physicsProperties(worldPhysics.getWorld())
+	GameObject(WorldPhysics & worldPhysics, Model* model, ValueTree gameObjectValueTree) : physicsProperties(worldPhysics)
 	{
+		physicsProperties.getBody()->SetUserData(this);
+		physicsProperties.setTypeListener(this);
 
 		setModel(model);
 		cappedMoveSpeed = 6;
@@ -97,7 +126,12 @@ public:
     
     // Rendering Data ==========================================================
 	void setRenderable(bool canRender) {
+		const bool changed = canRender != renderable;
+
 		renderable = canRender;
+
+		if (changed && activityListener != nullptr)
+			activityListener->objectActivityChanged(this);
 	}
     bool isRenderable()
     {
@@ -128,6 +162,7 @@ public:
     {
         this->renderableObject.model = model;
         renderable = true;
+        boundsChanged();
     }
 
     /** Sets the 2D position of a GameObject in world coordinates, not worrying
@@ -143,6 +178,7 @@ public:
         renderableObject.modelMatrix[3][0] = x;
         renderableObject.modelMatrix[3][1] = y;
         
+        boundsChanged();
     }
     
     /** Sets the 2D position of a GameObject in world coordinates and in the
@@ -161,6 +197,7 @@ public:
         // Update physical object position
         physicsProperties.setPosition (x, y);
         updateOrigin();
+        boundsChanged();
     }
     
     /** Offsets the 2D position of a GameObject in world coordinates and in the
@@ -179,6 +216,7 @@ public:
         // Update physical object position
         physicsProperties.offsetPosition (xOffset, yOffset);
         updateOrigin();
+        boundsChanged();
 
     }
     
@@ -197,6 +235,25 @@ public:
         
         // Update physics so it knows about the visual change in vertices
         physicsProperties.updateModelScale(renderableObject.model, x, y);
+        boundsChanged();
+    }
+
+    /** Returns whether the position, scale or Model has changed since this
+        was last called, for the level's ObjectBoundsTree to refit only the
+        objects that changed
+     */
+    bool takeBoundsChange()
+    {
+        return boundsDirty.load (std::memory_order_relaxed)
+            && boundsDirty.exchange (false, std::memory_order_relaxed);
+    }
+
+    /** Sets the listener told when the object is activated or deactivated,
+        there is at most one (the level's EntityStore)
+     */
+    void setActivityListener (ActivityListener * listener)
+    {
+        activityListener = listener;
     }
 
 	glm::vec2 getScale() 
@@ -275,18 +332,80 @@ public:
      */
     void mapAudioFileToPhysicalAction (File audioFile, PhysicalAction action)
     {
-        actionToAudio[action] = audioFile;
+        SoundSet::Map newSounds;
+
+        if (sounds != nullptr)
+            newSounds = sounds->getMap();
+
+        newSounds[action] = audioFile;
+        sounds = ArchetypeLibrary::getInstance().getSounds (newSounds);
     }
 
     /** Gets the audio to play when a specific PhysicalAction occurs in the game.
      */
-	File * getAudioFileForAction(PhysicalAction action)
+	const File * getAudioFileForAction(PhysicalAction action)
 	{
-		auto mapIterator = actionToAudio.find(action);
-		if (mapIterator != actionToAudio.end())
-			return &(actionToAudio.find(action)->second);
-		else
-			return nullptr;
+		return sounds != nullptr ? sounds->find(action) : nullptr;
+	}
+
+	// Archetype ===============================================================
+	/** Makes the object one of an Archetype: its name, textures, sounds,
+		speeds, score and physics material are those of the archetype, with
+		the textures and sounds shared rather than copied. Anything changed
+		afterwards only changes this object.
+	*/
+	void applyArchetype(Archetype & archetypeToApply)
+	{
+		archetype = &archetypeToApply;
+
+		const Archetype::Definition & definition = archetypeToApply.getDefinition();
+
+		name = definition.name;
+		setObjType(definition.type);
+
+		AnimationProperties & animation = renderableObject.animationProperties;
+		animation.setIdleTexture(definition.idleTexture, archetypeToApply.getIdleTextureId());
+		animation.setAnimationClip(archetypeToApply.getClip());
+		animation.setCanimate(definition.canimate);
+		animation.setAnimationSpeed(definition.animationSpeed);
+
+		sounds = archetypeToApply.getSounds();
+
+		setMoveSpeed(definition.moveSpeed);
+		setJumpSpeed(definition.jumpSpeed);
+		setScore(definition.score);
+
+		// Setting the material resets the mass and wakes the body, so only
+		// change what differs from the defaults
+		if (physicsProperties.getFriction() != definition.friction)
+			physicsProperties.setFriction(definition.friction);
+		if (physicsProperties.getRestitution() != definition.restitution)
+			physicsProperties.setRestitution(definition.restitution);
+		if (physicsProperties.getDensity() != definition.density)
+			physicsProperties.setDensity(definition.density);
+	}
+
+	/** The Archetype the object was made from, nullptr if it was not made
+		from one. It is saved by name, so a loaded object keeps it as long
+		as the library has an archetype of that name.
+	*/
+	Archetype * getArchetype()
+	{
+		return archetype;
+	}
+
+	// Behaviour ===============================================================
+	/** The name of the built-in Behaviour the level starts on the object
+		when it is loaded, see Behaviour::createBuiltIn(). Empty for none.
+	*/
+	const String & getBehaviourName()
+	{
+		return behaviourName;
+	}
+
+	void setBehaviourName(const String & newBehaviourName)
+	{
+		behaviourName = newBehaviourName;
 	}
 
 	//Numerical speeds for the object
@@ -339,9 +458,27 @@ public:
 	{
 		return objType;
 	}
+	/** Sets the type of the object, which also resets its collision filter
+		to the default of the type
+	*/
 	void setObjType(GameObjectType type)
 	{
+		const bool changed = type != objType;
+
 		objType = type;
+		applyDefaultCollisionFilter();
+
+		if (changed && activityListener != nullptr)
+			activityListener->objectComponentsChanged(this);
+	}
+
+	/** Gives the collision box the default filter of the object's type, see
+		CollisionFiltering
+	*/
+	void applyDefaultCollisionFilter()
+	{
+		CollisionFilter filter = getDefaultCollisionFilter(objType);
+		physicsProperties.setCollisionFilter(filter.categoryBits, filter.maskBits);
 	}
 	// Player Lives 
 	int getLives()
@@ -385,8 +522,13 @@ public:
 		return isActive;
 	}
 	void setActive(bool active) {
+		const bool changed = active != isActive;
+
 		isActive = active;
 		physicsProperties.setActiveStatus(active);
+
+		if (changed && activityListener != nullptr)
+			activityListener->objectActivityChanged(this);
 	}
 
 	// Animation speed
@@ -400,6 +542,8 @@ public:
 	void parseFrom(ValueTree valueTree) {
 
 		name = valueTree.getProperty(Identifier("name"));
+		behaviourName = valueTree.getProperty(Identifier("behaviour")).toString();
+		archetype = ArchetypeLibrary::getInstance().get(valueTree.getProperty(Identifier("archetype")).toString());
 		int objectTypeInt = valueTree.getProperty(Identifier("type"));
 		
 		switch (objectTypeInt) {
@@ -424,6 +568,9 @@ public:
 			break;
 		}
 
+		// Levels saved before filtering keep the defaults of the type
+		applyDefaultCollisionFilter();
+
 		ValueTree moveSpeedTree = valueTree.getChildWithName(Identifier("MoveSpeed"));
 		int moveSpeedInt = moveSpeedTree.getProperty(Identifier("value"));
 
@@ -485,7 +632,7 @@ public:
 		setScale(scale.x, scale.y);
 
 		ValueTree audioActionsValueTree = valueTree.getChildWithName(Identifier("ActionToAudio"));
-
+		SoundSet::Map actionToAudio;
 
 		for (ValueTree audioActionTree : audioActionsValueTree) {
 			int physicalActionInt = audioActionTree.getProperty(Identifier("action"));
@@ -505,6 +652,9 @@ public:
 			}
 			
 		}
+
+		// Objects with the same sounds share them
+		sounds = ArchetypeLibrary::getInstance().getSounds(actionToAudio);
 	}
 
 	ValueTree serializeToValueTree() {
@@ -538,6 +688,12 @@ public:
 
 		gameObjectSerialization.setProperty(Identifier("type"), var(objectTypeInt), nullptr);
 
+		if (behaviourName.isNotEmpty())
+			gameObjectSerialization.setProperty(Identifier("behaviour"), var(behaviourName), nullptr);
+
+		if (archetype != nullptr)
+			gameObjectSerialization.setProperty(Identifier("archetype"), var(archetype->getDefinition().name), nullptr);
+
 		//Serialize Renderable bool
 		ValueTree isRenderableValueTree("Renderable");
 
@@ -609,7 +765,9 @@ public:
 		ValueTree actionToAudioTree = ValueTree("ActionToAudio");
 
 
-		for (std::map<PhysicalAction,File>::iterator it = actionToAudio.begin(); it != actionToAudio.end(); ++it)
+		const SoundSet::Map actionToAudio = sounds != nullptr ? sounds->getMap() : SoundSet::Map();
+
+		for (SoundSet::Map::const_iterator it = actionToAudio.begin(); it != actionToAudio.end(); ++it)
 		{
 			ValueTree audioActionTree = ValueTree("AudioAction");
 			audioActionTree.setProperty(Identifier("file"), var(it->second.getRelativePathFrom(File::getCurrentWorkingDirectory())), nullptr);
@@ -646,9 +804,29 @@ public:
 	}
 
 protected:
-	GameObjectType objType;
+	GameObjectType objType = Generic;
 	float cappedMoveSpeed, cappedJumpSpeed;
 private:
+    void bodyTypeChanged() override
+    {
+        if (activityListener != nullptr)
+            activityListener->objectComponentsChanged (this);
+    }
+
+    /** Only sets a flag, so moving an object (as every physics sync does)
+        never waits on the editor's ObjectBoundsTree
+     */
+    void boundsChanged()
+    {
+        boundsDirty.store (true, std::memory_order_relaxed);
+    }
+
+    /** Set when the position, scale or Model changes, see takeBoundsChange() */
+    std::atomic<bool> boundsDirty { true };
+
+    /** Told when the object is activated, deactivated, shown, hidden or
+        changes type */
+    ActivityListener * activityListener = nullptr;
 	
     /** Name of object */
     String name;
@@ -656,7 +834,7 @@ private:
 	int currLives, currScore;
 	glm::vec2 origin;
     /** Specifies wether or not the object will be rendered visually to the screen */
-    bool renderable, isActive;
+    bool renderable = false, isActive = true;
     /** 
 		Renderable representation of this object.
      */
@@ -668,8 +846,16 @@ private:
 	float xVel, yVel;
 	// Speed of object jump/run
 	Speed moveSpeed, jumpSpeed;
-    /** Map of in-game physics-based actions to specific audio files */
-    std::map<PhysicalAction, File> actionToAudio;
+    /** In-game physics-based actions mapped to specific audio files, shared
+        with every object with the same ones
+     */
+    SoundSet::Ptr sounds;
+
+    /** What the object was made from, see applyArchetype() */
+    Archetype::Ptr archetype;
+
+    /** The built-in Behaviour started on the object, see getBehaviourName() */
+    String behaviourName;
 
 	JUCE_LEAK_DETECTOR(GameObject)
 };
@@ -132,7 +132,8 @@ public:
 		avgMilliseconds += ((deltaTime / 1000.0) - avgMilliseconds) * 0.03;
 		currentTime = Time::currentTimeMillis();
 
-		gameHUD.setAttributes(renderSwapFrame->getAttributes());
+		gameHUD.processEvents();
+		gameHUD.setFrameState(renderSwapFrame->getPlayerLifeTexture(), renderSwapFrame->getPhysicsProfile());
 		// For every second, update the calculated frame rate
 		if (checkTime > 1000) {
 			checkTime = 0;
@@ -194,7 +195,7 @@ public:
             uniforms->isSelectedObject->set(renderableObject.isSelected);
             
             // Set Texture
-			OpenGLTexture* tex = texResourceManager.loadTexture(renderableObject.animationProperties.getTexture());
+			OpenGLTexture* tex = texResourceManager.loadTexture(renderableObject.animationProperties.getTextureId());
 			
 			if (tex != nullptr) {	
 				tex->bind();
@@ -289,6 +290,12 @@ public:
     {
         this->camera = nullptr;
     }
+
+    /** The queue of the HUD, to subscribe to the GameLogic's GameEventBus */
+    GameEventQueue & getHUDEvents()
+    {
+        return gameHUD.getEvents();
+    }
     
 private:
     
@@ -9,17 +9,19 @@ public:
 	{
 		setName("Goal");
 		radius = 1.5;
-		objType = GameObjectType::Checkpoint;
+		setObjType(GameObjectType::Checkpoint);
         getPhysicsProperties().setIsStatic(true);
 
 		levelToGoTo = 1;
 		goToWin = false;
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 
 	GoalPointObject(WorldPhysics & worldPhysics, Model* model, ValueTree valueTree) : GameObject(worldPhysics, model, valueTree)
 	{
 		parseFrom(valueTree);
 		radius = 1.5;
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 
 	/** Copy Constructor - Used to easily make a copy of an existing GameObject
@@ -29,18 +31,10 @@ public:
 	{
 		radius = objectToCopy.radius;
 		levelToGoTo = objectToCopy.levelToGoTo;
+		getPhysicsProperties().setSensorRadius(radius);
 	}
 
-	bool collision(PlayerObject& player) {
-		bool triggered = false;
-			b2Vec2 dist = (player.getPosition() - getPhysicsProperties().GetPosition());
-			float leng = sqrt(dist.x * dist.x + dist.y*dist.y);
-			if (leng < radius) {
-				triggered = true;
-			}
-		
-		return triggered;
-	}
+	// The player reaching the goal is reported by its trigger sensor, see GameLogic
 	
 	// Destination level
 	int getLevelToGoTo() {
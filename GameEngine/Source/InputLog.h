@@ -0,0 +1,232 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameCommand.h"
+#include <vector>
+
+/** A recording of a play session: the game as it was when play started and
+    the commands of every logic tick played since, stored in a compact
+    binary file.
+
+    A recorded session runs on fixed ticks, each one physics timestep long,
+    so a tick needs no frame time. GameLogic::replay() rebuilds the game
+    from the recorded state and feeds it the recorded ticks through the same
+    frame code as play, at the same ticks, so the session plays out again
+    without a window or keyboard. Each tick also keeps a checksum of player 1's state after it
+    was processed, which a replay compares against to find the first tick
+    it no longer matches the recording at.
+
+    There is no random number generator in the engine, so there are no
+    seeds to record, the game, the timestep and the ticks are all a session
+    depends on.
+ */
+class InputLog
+{
+public:
+    /** A logic tick: the commands held down, in the order they were
+        pressed, and the checksum of the state after it
+     */
+    struct Tick
+    {
+        Array<GameCommand> commands;
+        uint32 checksum;
+    };
+
+    InputLog()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        game = ValueTree();
+        timeStep = 0.0f;
+        velocityIterations = 0;
+        positionIterations = 0;
+        score = 0;
+        currScore = 0;
+        currLives = 0;
+        ticks.clear();
+    }
+
+    /** Records the serialized game play starts from */
+    void setGame (ValueTree gameValueTree)
+    {
+        game = gameValueTree;
+    }
+
+    ValueTree getGame()
+    {
+        return game;
+    }
+
+    /** Records the fixed step the physics ran at, which is also the length
+        of every tick
+     */
+    void setTimeStep (float32 step, int32 velocity, int32 position)
+    {
+        timeStep = step;
+        velocityIterations = velocity;
+        positionIterations = position;
+    }
+
+    float32 getTimeStep()
+    {
+        return timeStep;
+    }
+
+    int32 getVelocityIterations()
+    {
+        return velocityIterations;
+    }
+
+    int32 getPositionIterations()
+    {
+        return positionIterations;
+    }
+
+    /** Records the score and lives of player 1, which are not part of the
+        serialized game once play has started
+     */
+    void setPlayerState (int newScore, int newCurrScore, int newCurrLives)
+    {
+        score = newScore;
+        currScore = newCurrScore;
+        currLives = newCurrLives;
+    }
+
+    int getScore()
+    {
+        return score;
+    }
+
+    int getCurrScore()
+    {
+        return currScore;
+    }
+
+    int getCurrLives()
+    {
+        return currLives;
+    }
+
+    void addTick (const Array<GameCommand> & commands, uint32 checksum)
+    {
+        Tick tick;
+        tick.commands = commands;
+        tick.checksum = checksum;
+
+        ticks.push_back (tick);
+    }
+
+    const std::vector<Tick> & getTicks() const
+    {
+        return ticks;
+    }
+
+    int getNumTicks() const
+    {
+        return (int) ticks.size();
+    }
+
+    /** Writes the log to a file, replacing it if it exists */
+    bool saveToFile (const File & file)
+    {
+        file.deleteFile();
+
+        FileOutputStream stream (file);
+
+        if (!stream.openedOk())
+            return false;
+
+        stream.writeInt (magic);
+        stream.writeInt (version);
+
+        stream.writeFloat (timeStep);
+        stream.writeCompressedInt (velocityIterations);
+        stream.writeCompressedInt (positionIterations);
+
+        stream.writeCompressedInt (score);
+        stream.writeCompressedInt (currScore);
+        stream.writeCompressedInt (currLives);
+
+        game.writeToStream (stream);
+
+        // A tick is a few bytes: the command count, a byte per command and
+        // the checksum
+        stream.writeCompressedInt ((int) ticks.size());
+
+        for (auto & tick : ticks)
+        {
+            stream.writeByte ((char) tick.commands.size());
+
+            for (auto command : tick.commands)
+                stream.writeByte ((char) command);
+
+            stream.writeInt ((int) tick.checksum);
+        }
+
+        stream.flush();
+        return true;
+    }
+
+    /** Reads a log written by saveToFile(), returns false if the file is
+        not one
+     */
+    bool loadFromFile (const File & file)
+    {
+        clear();
+
+        FileInputStream stream (file);
+
+        if (!stream.openedOk() || stream.readInt() != magic || stream.readInt() != version)
+            return false;
+
+        timeStep = stream.readFloat();
+        velocityIterations = stream.readCompressedInt();
+        positionIterations = stream.readCompressedInt();
+
+        score = stream.readCompressedInt();
+        currScore = stream.readCompressedInt();
+        currLives = stream.readCompressedInt();
+
+        game = ValueTree::readFromStream (stream);
+
+        const int numTicks = stream.readCompressedInt();
+
+        if (!game.isValid() || numTicks < 0)
+            return false;
+
+        ticks.resize (numTicks);
+
+        for (auto & tick : ticks)
+        {
+            const int numCommands = stream.readByte();
+
+            for (int i = 0; i < numCommands; i++)
+                tick.commands.add ((GameCommand) stream.readByte());
+
+            tick.checksum = (uint32) stream.readInt();
+        }
+
+        return true;
+    }
+
+private:
+    static const int magic = 0x474c4f47;    // "GLOG"
+    static const int version = 2;
+
+    ValueTree game;
+
+    float32 timeStep;
+    int32 velocityIterations;
+    int32 positionIterations;
+
+    int score;
+    int currScore;
+    int currLives;
+
+    std::vector<Tick> ticks;
+
+    JUCE_LEAK_DETECTOR(InputLog)
+};
@@ -7,39 +7,61 @@
 #include "GameObject.h"
 #include "CollectableObject.h"
 #include "Camera.h"
+#include "StaticGeometry.h"
+#include "WorldBounds.h"
+#include "ObjectBoundsTree.h"
+#include "LevelSnapshot.h"
+#include "EntityStore.h"
+#include "AIScheduler.h"
+#include "NavGrid.h"
+#include "FlowField.h"
+#include "ObjectPool.h"
+#include "BehaviourScheduler.h"
+#include "Archetype.h"
+#include <map>
 class Level {
 public:
-	Level(String levelName) {
+	Level(String levelName) : staticGeometry(worldPhysics.getWorld()) {
         
         // Add a default model
         modelsForRendering.add(new Model());
 		this->levelName = levelName;
 
-		PlayerObject* player = new PlayerObject(worldPhysics, modelsForRendering[0]);
-
-		player->getRenderableObject().animationProperties.setAnimationTextures(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/alien/walk/"));
-		
-
-		player->getRenderableObject().animationProperties.setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/alien/p1_stand.png"));
-
-
-		player->getRenderableObject().animationProperties.setCanimate(true);
+		GameObject* player = addObject(*ArchetypeLibrary::getInstance().getBuiltIn(ArchetypeLibrary::player));
 
 		player->setPosition(player->getPosition().x, player->getPosition().y+2);
-		gameObjects.add(player);
-		players.add(player);
 		enemyPoints = 15;
 		collectablePoints = 5;
+		setupWorldBounds();
 		addBoundFloor();
 	}
 
-	Level(ValueTree levelValueTree) {
+	Level(ValueTree levelValueTree) : staticGeometry(worldPhysics.getWorld()) {
+
+		double buildStartMs = Time::getMillisecondCounterHiRes();
 
 		modelsForRendering.add(new Model());
 		enemyPoints = 15;
 		collectablePoints = 5;
+		setupWorldBounds();
+
+		// Build every body out of the world first, merge the static blocks,
+		// then put the remaining bodies into the broadphase and build its
+		// tree in one pass
+		worldPhysics.beginBatchBuild();
 		addBoundFloor();
 		parseFrom(levelValueTree);
+		setKillPlane(worldBounds.getKillPlane());
+		worldPhysics.endBatchBuild();
+
+		worldPhysics.beginProxyBatch();
+		rebuildStaticGeometry();
+
+		for (auto obj : gameObjects)
+			obj->getPhysicsProperties().finishDeferredActivation();
+		worldPhysics.endProxyBatch();
+
+		buildMs = Time::getMillisecondCounterHiRes() - buildStartMs;
 	}
 
     
@@ -48,6 +70,17 @@ public:
         
     }
 
+	String getName() {
+		return levelName;
+	}
+
+	/** How long building the level from its ValueTree took, for the
+		profiling line of the HUD. 0 for a level made in the editor.
+	*/
+	double getBuildMs() {
+		return buildMs;
+	}
+
 	int getNumGameObjects() {
 		return gameObjects.size();
 	}
@@ -57,20 +90,56 @@ public:
 	}
 
 	void addNewObject() {
-		gameObjects.add(new GameObject(worldPhysics, modelsForRendering[0]));
+		addGameObject(new GameObject(worldPhysics, modelsForRendering[0]));
+		markStaticGeometryDirty();
 		//gameObjects.getLast()->setPosition(players[0]->getPhysicsProperties().GetPosition().x, players[0]->getPhysicsProperties().GetPosition().y + 5);
 	}
 
 	void addNewBlock() {
-        GameObject * gameObj = new GameObject(worldPhysics, modelsForRendering[0]);
-
-		gameObj->getRenderableObject().animationProperties.setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/brick.png"));
-        gameObj->setModel(modelsForRendering[0]);
-		gameObj->setScore(10);
-        gameObj->setScale(1.0f, 1.0f);
-		gameObjects.add(gameObj);
-		//gameObjects.getLast()->setPosition(players[0]->getPhysicsProperties().GetPosition().x, players[0]->getPhysicsProperties().GetPosition().y + 5);
+		addObject(*ArchetypeLibrary::getInstance().getBuiltIn(ArchetypeLibrary::block));
 	}
+
+    /** Adds a new object made from an Archetype, of the class of the
+        archetype's type. The object shares the archetype's textures and
+        sounds rather than copying them, so nothing is loaded or scanned.
+     */
+    GameObject * addObject (Archetype & archetype)
+    {
+        GameObject * object = nullptr;
+
+        switch (archetype.getDefinition().type)
+        {
+            case Player:
+            {
+                PlayerObject * player = new PlayerObject (worldPhysics, modelsForRendering[0]);
+                players.add (player);
+                object = player;
+                break;
+            }
+            case Enemy:
+                object = new EnemyObject (worldPhysics, modelsForRendering[0]);
+                break;
+            case Collectable:
+                object = new CollectableObject (worldPhysics, modelsForRendering[0]);
+                break;
+            case Checkpoint:
+                checkpoint = new GoalPointObject (worldPhysics, modelsForRendering[0]);
+                object = checkpoint;
+                break;
+            default:
+                object = new GameObject (worldPhysics, modelsForRendering[0]);
+                break;
+        }
+
+        object->applyArchetype (archetype);
+        object->setScale (1.0f, 1.0f);
+        addGameObject (object);
+
+        if (object->getObjType() == Generic || object->getObjType() == Bounds)
+            markStaticGeometryDirty();
+
+        return object;
+    }
     
     GameObject * copyObject(GameObject * objectToCopy) {
 
@@ -78,7 +147,8 @@ public:
 
 		case Generic: {
 			GameObject* genericObj = new GameObject(*objectToCopy, worldPhysics);
-			gameObjects.add(genericObj);
+			addGameObject(genericObj);
+			markStaticGeometryDirty();
 			return genericObj;
 		}
 				break;
@@ -88,19 +158,19 @@ public:
 			break;
 		case Enemy: {
 			EnemyObject* enm = new EnemyObject(*((EnemyObject*)objectToCopy), worldPhysics);
-			gameObjects.add(enm);
+			addGameObject(enm);
 			return enm;
 		}
 				break;
 		case Collectable: {
 			CollectableObject* collectable = new CollectableObject(*((CollectableObject*)objectToCopy), worldPhysics);
-			gameObjects.add(collectable);
+			addGameObject(collectable);
 			return collectable;
 		}
 				break;
 		case Checkpoint: {
 			GoalPointObject* goalPoint = new GoalPointObject(*((GoalPointObject*)objectToCopy), worldPhysics);
-			gameObjects.add(goalPoint);
+			addGameObject(goalPoint);
 			return goalPoint;
 		}
 				break;
@@ -111,58 +181,27 @@ public:
     }
     
 	void addNewEnemy() {
-		EnemyObject* enm = new EnemyObject(worldPhysics, modelsForRendering[0]);
-		enm->getRenderableObject().animationProperties.setAnimationTextures(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/blue_alien/walk/"));
-
-		enm->getRenderableObject().animationProperties.setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/blue_alien/p2_stand.png"));
-
-
-		enm->getRenderableObject().animationProperties.setCanimate(true);
-		enm->setScale(1.0f, 1.0f);
-		gameObjects.add(enm);
-		//gameObjects.getLast()->setPosition(players[0]->getPhysicsProperties().GetPosition().x, players[0]->getPhysicsProperties().GetPosition().y + 5);
+		addObject(*ArchetypeLibrary::getInstance().getBuiltIn(ArchetypeLibrary::enemy));
 	}
     
 	void addNewCollectable()
     {
-		CollectableObject* collectable = new CollectableObject(worldPhysics, modelsForRendering[0]);
-
-		collectable->getRenderableObject().animationProperties.setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/coin.png"));
-		collectable->setScore(5);
-		collectable->setScale(1.0f, 1.0f);
-		gameObjects.add(collectable);
-		//gameObjects.getLast()->setPosition(players[0]->getPhysicsProperties().GetPosition().x, players[0]->getPhysicsProperties().GetPosition().y + 5);
+		addObject(*ArchetypeLibrary::getInstance().getBuiltIn(ArchetypeLibrary::collectable));
 	}
     
 	void addNewCheckpoint()
     {
-		checkpoint = new GoalPointObject(worldPhysics, modelsForRendering[0]);
-
-		checkpoint->getRenderableObject().animationProperties.setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/checkpoint.png"));
-		checkpoint->setScale(1.0f, 1.0f);
-		gameObjects.add(checkpoint);
+		addObject(*ArchetypeLibrary::getInstance().getBuiltIn(ArchetypeLibrary::checkpoint));
 	}
 
-	void removeCheckpoint()
-    {
-		int i = 0;
-		for (auto obj : gameObjects) {
-			
-			if (obj->getObjType() == Checkpoint) {
-				gameObjects.remove(i, true);
-			}
-			i++;
-		}
-	}
+	/** Adds the marker drawn below the kill plane. It is only drawn, falling
+		out of the level is detected by the WorldBounds.
+	*/
 	void addBoundFloor() {
-			addNewBlock();
-			GameObject* obj = getGameObjects().getLast();
-			obj->setPositionWithPhysics(obj->getOrigin().x, -9);
+			GameObject* obj = addObject(*ArchetypeLibrary::getInstance().getBuiltIn(ArchetypeLibrary::killingFloor));
+			obj->getPhysicsProperties().setCollidable(false);
+			obj->setPositionWithPhysics(obj->getOrigin().x, worldBounds.getKillPlane() - 1.5f);
 			obj->getPhysicsProperties().setLinearVelocity(0, 0);
-			obj->getPhysicsProperties().setFriction(0.0);
-			obj->setObjType(Bounds);
-			obj->setName("Killing Floor");
-			obj->getRenderableObject().animationProperties.setIdleTexture(File(File::getCurrentWorkingDirectory().getFullPathName() + "/textures/death.png"));
 			obj->setActive(true);
 			obj->setScale(10000000, 1);
 			obj->setRenderable(true);
@@ -190,30 +229,208 @@ public:
 	*/
 	void processWorldPhysics(int64 timeStep)
 	{
-		if ((float32)timeStep < getWorldPhysics().getTimeStep()) {
-			getWorldPhysics().Step((float32)timeStep);
+		prepareWorldPhysics();
+		stepWorldPhysics(timeStep / 1000.0f);
+		syncWithWorldPhysics();
+	}
+
+	/** Brings the world up to date with the level before a step, must be
+		called while no step is running
+	*/
+	void prepareWorldPhysics()
+	{
+		if (staticGeometryDirty)
+			rebuildStaticGeometry();
+	}
+
+	/** Steps the world only, this is the part of processWorldPhysics that
+		the PhysicsThread runs alongside the game logic. A frame shorter than
+		the world's timestep takes a shorter step, the frame time is in
+		seconds like the timestep
+	*/
+	void stepWorldPhysics(float32 frameTime)
+	{
+		if (frameTime < getWorldPhysics().getTimeStep()) {
+			getWorldPhysics().Step(frameTime);
 		}
 		else
 		{
 			getWorldPhysics().Step();
 		}
-        
+	}
+
+	/** Takes the results of the last step: moves the objects to their
+		bodies and checks them against the world bounds
+	*/
+	void syncWithWorldPhysics()
+	{
         updateObjectsPositionsFromPhysics();
+
+		worldBounds.check(getEntities());
+	}
+
+	/** Returns true if a player has left the world bounds since the level
+		was last reset
+	*/
+	bool hasPlayerLeftWorldBounds()
+	{
+		return playerLeftWorldBounds;
+	}
+
+	WorldBounds & getWorldBounds()
+	{
+		return worldBounds;
+	}
+
+	/** Moves the kill plane of the level, along with the marker drawn below it */
+	void setKillPlane(float y)
+	{
+		worldBounds.setKillPlane(y);
+		floor->setPositionWithPhysics(floor->getOrigin().x, y - 1.5f);
 	}
     
+	/** Records the state the level is reset to, called when play starts */
+	void captureResetState()
+	{
+		resetState.capture(gameObjects, pool);
+	}
+
 	//reset the current level to an original state
 	void resetLevel() {
-		for (auto  obj : gameObjects) {
-			obj->setPositionWithPhysics(obj->getOrigin().x, obj->getOrigin().y);
-			obj->getPhysicsProperties().setLinearVelocity(0, 0);
-			obj->setActive(true);
-			obj->setRenderable(true);
-		}
+		// Objects added in the editor since the state was recorded
+		if (resetState.getNumObjects() != gameObjects.size())
+			resetState.capture(gameObjects, pool);
+
+		despawnAll();
+		resetState.restore(worldPhysics);
+		getEntities().updateTransforms();
+		behaviours.restart();
+		playerLeftWorldBounds = false;
 		players[0]->setScore(players[0]->getScore());
 		players[0]->setLives(players[0]->getLives());
 
 	}
     
+	/** Merges the level's static blocks into compound static bodies, see
+		StaticGeometry, and updates the cells of the NavGrid they changed.
+		Called when the level is loaded and before the next physics step
+		after the level has been edited.
+	*/
+	void rebuildStaticGeometry()
+	{
+		staticGeometry.rebuild(gameObjects);
+		navGrid.update(gameObjects);
+		staticGeometryDirty = false;
+	}
+
+	/** Flags the merged static geometry as out of date so it is rebuilt
+		before the next physics step
+	*/
+	void markStaticGeometryDirty()
+	{
+		staticGeometryDirty = true;
+		entitiesDirty = true;
+	}
+
+	/** Runs the AI of the level's enemies that are due for a tick, see
+		AIScheduler. elapsed is in seconds, budgetMs of 0 runs every enemy
+		that is due.
+	*/
+	void updateEnemyAI(double elapsed, double budgetMs = 0.0)
+	{
+		// A flow field to each player, shared by the enemies chasing them
+		while (flowFields.size() < players.size())
+			flowFields.add(new FlowField(navGrid));
+
+		for (int i = 0; i < players.size(); i++)
+			flowFields[i]->update(players[i]->getPosition().x, players[i]->getPosition().y);
+
+		// The velocities the AI sets go to the physics as one command
+		worldPhysics.beginVelocityBatch();
+		aiScheduler.update(getEntities(), players, flowFields, elapsed, budgetMs);
+		worldPhysics.endVelocityBatch();
+	}
+
+	/** Puts the enemies' patrols and AI timing back to where they start */
+	void resetEnemyAI()
+	{
+		EntityStore & entities = getEntities();
+
+		for (int i = 0; i < entities.getNumEnemies(); i++)
+			entities.getEnemy(i)->resetPatrol();
+
+		aiScheduler.reset();
+	}
+
+	AIScheduler & getAIScheduler()
+	{
+		return aiScheduler;
+	}
+
+	/** Starts a Behaviour on an object of the level. It runs while the
+		game is playing and starts over when the level is reset. The
+		behaviour must outlive the level, or be stopped first.
+	*/
+	BehaviourHandle startBehaviour(GameObject * object, const Behaviour & behaviour)
+	{
+		return behaviours.start(*object, behaviour);
+	}
+
+	/** Starts the built-in Behaviour an object names, see
+		GameObject::getBehaviourName(). Done for every object as the level
+		is loaded, and does nothing for an object that names none.
+	*/
+	void startNamedBehaviour(GameObject * object)
+	{
+		const String & name = object->getBehaviourName();
+
+		if (name.isEmpty())
+			return;
+
+		auto named = namedBehaviours.find(name);
+
+		if (named == namedBehaviours.end())
+			named = namedBehaviours.insert(std::make_pair(name, Behaviour::createBuiltIn(name))).first;
+
+		if (named->second.getNumSteps() > 0)
+			startBehaviour(object, named->second);
+	}
+
+	/** Runs the behaviours that wake in a tick, elapsed is the time in
+		seconds since the last one
+	*/
+	void updateBehaviours(double elapsed)
+	{
+		behaviours.update(getEntities(), players, elapsed);
+	}
+
+	BehaviourScheduler & getBehaviours()
+	{
+		return behaviours;
+	}
+
+	/** The struct-of-arrays view of the level's objects the gameplay
+		systems iterate, brought up to date with the objects first if they
+		have been added, removed or edited since it was last used
+	*/
+	EntityStore & getEntities()
+	{
+		if (entitiesDirty || entities.needsUpdate(gameObjects.size()))
+		{
+			entities.update(gameObjects);
+			entitiesDirty = false;
+		}
+
+		entities.applyActivityChanges();
+
+		return entities;
+	}
+
+	StaticGeometry & getStaticGeometry()
+	{
+		return staticGeometry;
+	}
+
 	//Return the WorldPhysics for this level
 	WorldPhysics & getWorldPhysics()
     {
@@ -234,14 +451,11 @@ public:
      */
     GameObject * getObjectAtPosition(glm::vec2 position)
     {
-        // Iterate through GameObjects and find one that fits posiion
-        for (GameObject * gameObject : gameObjects)
-        {
-            if (gameObject->isAtPosition(position))
-                return gameObject;
-        }
-        
-        return nullptr;
+        // Only the objects whose cached bounds are under the position are
+        // tested, see ObjectBoundsTree
+        // Pooled objects are not in it, they are not part of the level
+        // being edited
+        return objectBounds.getObjectAtPosition(gameObjects, position);
     }
     
     /** Gets the game objects in the specified 2D range in world space.
@@ -277,16 +491,121 @@ public:
             yMax = coord1.y;
         }
         
-        Array<GameObject *> objectsInRange;
-        
-        // For all game objects, if they are in range, add them
-        for (GameObject * gameObject : gameObjects)
+        return objectBounds.getObjectsInRange (xMin, xMax, yMin, yMax);
+    }
+
+    /** Makes objects of a type ahead of time for spawn(), with their bodies
+        made but inactive and hidden. Generic objects are made dynamic, for
+        projectiles. Enemies, collectables and Generic objects can be pooled.
+        Bodies are made straight away, so this must be called while no step
+        is running, such as before play starts.
+     */
+    void reservePooled (GameObjectType type, int count)
+    {
+        for (int i = 0; i < count; i++)
         {
-            if (gameObject->isInRange (xMin, xMax, yMin, yMax))
-                objectsInRange.add (gameObject);
+            GameObject * object = nullptr;
+
+            switch (type)
+            {
+                case Generic:
+                    addNewBlock();
+                    object = gameObjects.getLast();
+                    object->getPhysicsProperties().setIsStatic(false);
+                    break;
+                case Enemy:
+                    addNewEnemy();
+                    object = gameObjects.getLast();
+                    break;
+                case Collectable:
+                    addNewCollectable();
+                    object = gameObjects.getLast();
+                    break;
+                default:
+                    return;
+            }
+
+            object->setActive(false);
+            object->setRenderable(false);
+            pool.add(object);
+
+            // Pooled objects are not part of the level being edited
+            objectBounds.objectRemoved(object);
         }
-        
-        return objectsInRange;
+    }
+
+    /** Puts an object of a type into play at a position, taken from the
+        pool. Nothing is made, so it can be called during play, and returns
+        nullptr once every pooled object of the type is out.
+     */
+    GameObject * spawn (GameObjectType type, float x, float y)
+    {
+        GameObject * object = pool.take(type);
+
+        if (object == nullptr)
+            return nullptr;
+
+        object->setPositionWithPhysics(x, y);
+        object->getPhysicsProperties().setLinearVelocity(0, 0);
+
+        if (type == Enemy)
+            static_cast<EnemyObject *>(object)->resetPatrol();
+
+        object->setRenderable(true);
+        object->setActive(true);
+
+        return object;
+    }
+
+    /** Takes a spawned object out of play and gives it back to the pool.
+        Returns false if it was not spawned.
+     */
+    bool despawn (GameObject * object)
+    {
+        if (!pool.release(object))
+            return false;
+
+        object->setActive(false);
+        object->setRenderable(false);
+        return true;
+    }
+
+    /** Despawns every spawned object, done when the level is reset. The
+        pool spawns them again in the same order afterwards, see ObjectPool.
+     */
+    void despawnAll()
+    {
+        pool.releaseAll([] (GameObject * object)
+        {
+            object->setActive(false);
+            object->setRenderable(false);
+        });
+    }
+
+    /** Returns true if an object belongs to the pool, and so is left out of
+        the saved level and the editor
+     */
+    bool isPooled (GameObject * object)
+    {
+        return pool.contains(object);
+    }
+
+    /** Called when a player stomps an enemy. Drops a coin where the enemy
+        was if the level pools collectables, see reservePooled(), and gives
+        the enemy back to the pool if it was spawned.
+     */
+    void enemyStomped (GameObject * enemy)
+    {
+        despawn(enemy);
+        spawn(Collectable, enemy->getPosition().x, enemy->getPosition().y);
+    }
+
+    /** Called when a player picks up a collectable, gives it back to the
+        pool if it was spawned, such as a coin an enemy dropped
+     */
+    void collectablePicked (GameObject * collectable)
+    {
+        despawn(collectable);
     }
 
 	int getEnemyPoints() {
@@ -314,6 +633,13 @@ public:
         if (indexOfObject != -1)
         {
             // Remove the object from the physics world
+            staticGeometry.objectRemoved (gameObjectToDelete);
+            objectBounds.objectRemoved (gameObjectToDelete);
+            entities.objectRemoved (gameObjectToDelete);
+            pool.objectRemoved (gameObjectToDelete);
+            behaviours.objectRemoved (gameObjectToDelete);
+            resetState.clear();
+            markStaticGeometryDirty();
             worldPhysics.removeObject (gameObjectToDelete->getPhysicsProperties().getBody());
             
             // Remove the object from the level
@@ -352,10 +678,13 @@ public:
 		//Serialize world physics
 		levelSerialization.addChild(worldPhysics.serializeToValueTree(), -1, nullptr);
 
+		//Serialize world bounds
+		levelSerialization.addChild(worldBounds.serializeToValueTree(), -1, nullptr);
+
 		//Serialize models
 		//Just kidding. we only have one default model, no need to serialize
 
-		//Get the player index in the game model while we are serializing game objects
+		//Get the player index in the saved objects while we are serializing game objects
 		ValueTree playerValueTree = ValueTree("Player");
 
 		ValueTree gameObjectsValueTree = ValueTree("GameObjects");
@@ -363,9 +692,15 @@ public:
 		//For each level, serialize and add to Levels child element
 		for (GameObject* gameObject : gameObjects) {
 
+			// Pooled objects are made while playing
+			if (pool.contains(gameObject)) {
+				continue;
+			}
+
 			//If this is the player, set the player index to be this index
 			if (gameObject == players[0]) {
-				playerValueTree.setProperty(Identifier("index"), var(gameObjects.indexOf(gameObject)), nullptr);
+				// Pooled and bounds objects are left out, so count what is saved
+				playerValueTree.setProperty(Identifier("index"), var(gameObjectsValueTree.getNumChildren()), nullptr);
 				gameObjectsValueTree.addChild(((PlayerObject*)gameObject)->serializeToValueTree(), -1, nullptr);
 			}
 			else if (gameObject->getObjType() == Enemy) {
@@ -389,11 +724,29 @@ public:
 
 		levelSerialization.addChild(playerValueTree, -1, nullptr);
 
+		//Serialize how many objects of each type are pooled, they are made again on load
+		ValueTree poolsValueTree = ValueTree("Pools");
+
+		for (GameObjectType type : { Generic, Enemy, Collectable }) {
+			const int numPooled = pool.getNumPooled(type);
+
+			if (numPooled > 0) {
+				ValueTree poolValueTree = ValueTree("Pool");
+				poolValueTree.setProperty(Identifier("type"), var((int) type), nullptr);
+				poolValueTree.setProperty(Identifier("count"), var(numPooled), nullptr);
+				poolsValueTree.addChild(poolValueTree, -1, nullptr);
+			}
+		}
+
+		levelSerialization.addChild(poolsValueTree, -1, nullptr);
+
 		return levelSerialization;
 	}
 
 	void parseFrom(ValueTree levelTree) {
 
+		levelName = levelTree.getProperty(Identifier("name"));
+
 		camera.parseCameraFrom(levelTree.getChildWithName(Identifier("Camera")));
 
 		ValueTree gameObjectsValueTree = levelTree.getChildWithName(Identifier("GameObjects"));
@@ -402,6 +755,8 @@ public:
 
 		worldPhysics.parseWorldPhysics(worldPhysicsValueTree);
 
+		worldBounds.parseFrom(levelTree.getChildWithName(Identifier("WorldBounds")));
+
 		for (ValueTree gameObjectValueTree : gameObjectsValueTree) {
 
 			int objTypeInt = gameObjectValueTree.getProperty(Identifier("type"));
@@ -410,54 +765,97 @@ public:
 
 			case 0: {
 				GameObject* genericObj = new GameObject(worldPhysics, modelsForRendering[0], gameObjectValueTree);
-				gameObjects.add(genericObj);
+				addGameObject(genericObj);
 			}
 					break;
 			case 1: {
 				PlayerObject* player = new PlayerObject(worldPhysics, modelsForRendering[0], gameObjectValueTree);
-				gameObjects.add(player);
+				addGameObject(player);
 				players.add(player);
 
 			}
 					break;
 			case 2: {
 				EnemyObject* enm = new EnemyObject(worldPhysics, modelsForRendering[0], gameObjectValueTree);
-				gameObjects.add(enm);
+				addGameObject(enm);
 			}
 					break;
 			case 3: {
 				CollectableObject* collectable = new CollectableObject(worldPhysics, modelsForRendering[0], gameObjectValueTree);
-				gameObjects.add(collectable);
+				addGameObject(collectable);
 			}
 					break;
 			case 4: {
 				GoalPointObject* goalPoint = new GoalPointObject(worldPhysics, modelsForRendering[0], gameObjectValueTree);
-				gameObjects.add(goalPoint);
+				addGameObject(goalPoint);
 			}
 					break;
 			}
 
 
 		}
+
+		for (GameObject* gameObject : gameObjects)
+			startNamedBehaviour(gameObject);
+
+		for (ValueTree poolValueTree : levelTree.getChildWithName(Identifier("Pools"))) {
+			int objTypeInt = poolValueTree.getProperty(Identifier("type"));
+			reservePooled((GameObjectType) objTypeInt, poolValueTree.getProperty(Identifier("count")));
+		}
 	}
 	GameObject* getFloor() {
 		return floor;
 	}
 private:
+
+    /** Registers what happens to each type of object that leaves the world.
+        A player only flags it, GameLogic decides whether to respawn or end
+        the game. Anything else is taken out of play until the level is reset.
+     */
+    void setupWorldBounds()
+    {
+        worldBounds.setCallback (Player, [this] (GameObject &)
+        {
+            playerLeftWorldBounds = true;
+        });
+
+        // Spawned objects go back to the pool, so it can spawn them again
+        WorldBounds::OutOfBoundsCallback removeFromPlay = [this] (GameObject & object)
+        {
+            if (despawn (&object))
+                return;
+
+            object.setActive (false);
+            object.setRenderable (false);
+        };
+
+        worldBounds.setCallback (Generic, removeFromPlay);
+        worldBounds.setCallback (Enemy, removeFromPlay);
+        worldBounds.setCallback (Collectable, removeFromPlay);
+    }
+
+    /** Adds an object to the level's objects and to the indexes that are
+        told about every object added, rather than looking for new ones
+     */
+    template <class ObjectClass>
+    ObjectClass * addGameObject (ObjectClass * object)
+    {
+        gameObjects.add (object);
+        objectBounds.objectAdded (object);
+        return object;
+    }
     
     /** Updates positions from all objects from the Physics updates
      */
     void updateObjectsPositionsFromPhysics()
     {
-        for (auto object : gameObjects)
-        {
-            b2Vec2 box2DPos = object->getPhysicsProperties().GetPosition();
-            object->setPosition(box2DPos.x, box2DPos.y);
-        }
+        // Static bodies never move in a step, only the dynamic ones are synced
+        getEntities().syncBodies();
     }
     
     /** Name of level */
     String levelName;
+	double buildMs = 0.0;
 	GameObject* floor;
 	int enemyPoints, collectablePoints;
 	/** Camera view of the current level */
@@ -466,8 +864,48 @@ private:
     /** Physics for the level */
     WorldPhysics worldPhysics;
 
+    /** Compound static bodies built from the level's static blocks */
+    StaticGeometry staticGeometry;
+
+    /** Set when the level has been edited since the last merge */
+    bool staticGeometryDirty = true;
+
+    /** Kill plane and limits of the level, checked after every step */
+    WorldBounds worldBounds;
+
+    /** Set by the WorldBounds when a player falls out of the level */
+    bool playerLeftWorldBounds = false;
+
     /** GameObjects in the level */
 	OwnedArray<GameObject> gameObjects;
+
+    /** Cached bounds of the GameObjects, for picking them in the editor */
+    ObjectBoundsTree objectBounds;
+
+    /** State the GameObjects are put back into when the level is reset */
+    LevelSnapshot resetState;
+
+    /** Struct-of-arrays view of the GameObjects for the gameplay systems */
+    EntityStore entities;
+    AIScheduler aiScheduler;
+
+    /** Objects made ahead of time for spawn() */
+    ObjectPool pool;
+
+    /** The built-in behaviours the objects name, made the first time one
+        names them, see startNamedBehaviour()
+     */
+    std::map<String, Behaviour> namedBehaviours;
+
+    /** Behaviours started on the objects, see startBehaviour() */
+    BehaviourScheduler behaviours;
+
+    /** The cells the static blocks fill, updated with the StaticGeometry */
+    NavGrid navGrid;
+    OwnedArray<FlowField> flowFields;
+
+    /** Set when objects have been edited since the entities were updated */
+    bool entitiesDirty = true;
     
     /** Set of Models to be used by RenderableObjects inside of GameObjects.
      
@@ -0,0 +1,387 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameCommand.h"
+#include "Level.h"
+#include <vector>
+
+/** Runs many independent copies of a Level side by side, for automated
+    playtesting, difficulty sweeps and training bots.
+
+    Each instance is a Level built from the serialization of the source
+    level, so it has its own b2World and shares nothing with the others.
+    A batch step takes an action for every instance and steps them all on
+    a ThreadPool, a job per group of instances, with the same fixed physics
+    step and the same player, enemy and trigger rules as play. It then
+    fills in flat arrays the caller can read straight away: numObservations
+    floats per instance, a reward per instance, and whether each instance
+    has finished.
+
+    An instance finishes when the player reaches a goal or runs out of
+    lives, and starts over from the start of the level on the next step.
+ */
+class LevelBatch
+{
+public:
+    /** The values observed for each instance, in the order they appear in
+        getObservations()
+     */
+    enum Observation
+    {
+        playerX = 0,
+        playerY,
+        playerVelocityX,
+        playerVelocityY,
+        nearestEnemyX,      // relative to the player, 0 if there is none
+        nearestEnemyY,
+        score,
+        lives,
+        pickupsLeft,
+        numObservations
+    };
+
+    /** Builds numInstances copies of a level. The level must not be being
+        stepped, so call this while the game is paused.
+
+        @param numThreads   threads the instances are stepped on, by default
+                            one per core
+     */
+    LevelBatch (Level & source, int numInstances, int numThreads = SystemStats::getNumCpus())
+        : threadPool (jmax (1, numThreads))
+    {
+        ValueTree levelTree = source.serializeToValueTree();
+
+        for (int i = 0; i < numInstances; i++)
+        {
+            Instance * instance = new Instance();
+            instance->level = new Level (levelTree);
+            instance->level->captureResetState();
+            instances.add (instance);
+
+            resetInstance (*instance);
+        }
+
+        observations.resize (numInstances * numObservations);
+        rewards.resize (numInstances);
+        done.resize (numInstances);
+
+        for (int i = 0; i < numInstances; i++)
+            writeObservation (i);
+
+        // A job per thread, each stepping an equal share of the instances
+        const int numJobs = jmin (jmax (1, numThreads), jmax (1, numInstances));
+
+        for (int job = 0; job < numJobs; job++)
+            jobs.add (new StepJob (*this, numInstances * job / numJobs, numInstances * (job + 1) / numJobs));
+
+        completionReward = 100.0f;
+        lifeLostPenalty = 100.0f;
+
+        totalSteps = 0;
+        totalStepMs = 0.0;
+    }
+
+    ~LevelBatch()
+    {
+        threadPool.removeAllJobs (true, 5000);
+    }
+
+    int getNumInstances()
+    {
+        return instances.size();
+    }
+
+    Level & getInstance (int index)
+    {
+        return *instances[index]->level;
+    }
+
+    /** Sets what finishing an instance is worth. On every step an instance
+        is rewarded the points the player scored, plus the completion reward
+        for reaching a goal, minus the penalty for losing a life.
+     */
+    void setRewards (float newCompletionReward, float newLifeLostPenalty)
+    {
+        completionReward = newCompletionReward;
+        lifeLostPenalty = newLifeLostPenalty;
+    }
+
+    /** Steps every instance once and waits for them all.
+
+        @param actions  an action per instance: the GameCommands player 1
+                        holds down, as a mask of (1 << command)
+     */
+    void step (const uint32 * actions)
+    {
+        const double startMs = Time::getMillisecondCounterHiRes();
+
+        currentActions = actions;
+
+        for (auto job : jobs)
+            threadPool.addJob (job, false);
+
+        for (auto job : jobs)
+            threadPool.waitForJobToFinish (job, -1);
+
+        currentActions = nullptr;
+
+        totalStepMs += Time::getMillisecondCounterHiRes() - startMs;
+        totalSteps += instances.size();
+    }
+
+    /** numObservations values per instance, see Observation */
+    const float * getObservations() const
+    {
+        return observations.data();
+    }
+
+    /** The reward each instance earned on the last step */
+    const float * getRewards() const
+    {
+        return rewards.data();
+    }
+
+    /** Whether each instance finished on the last step, it starts over on
+        the next one
+     */
+    const uint8 * getDone() const
+    {
+        return done.data();
+    }
+
+    /** Puts every instance back at the start of its level */
+    void resetAll()
+    {
+        for (int i = 0; i < instances.size(); i++)
+        {
+            resetInstance (*instances[i]);
+            writeObservation (i);
+        }
+    }
+
+    /** Simulation steps run per second by each thread, over every step so
+        far. A step of one instance counts as one simulation step.
+     */
+    double getStepsPerSecondPerCore()
+    {
+        if (totalStepMs <= 0.0)
+            return 0.0;
+
+        return totalSteps / (totalStepMs / 1000.0) / jobs.size();
+    }
+
+    int64 getTotalSteps()
+    {
+        return totalSteps;
+    }
+
+private:
+    struct Instance
+    {
+        ScopedPointer<Level> level;
+        uint32 lastAction;
+        bool finished;
+    };
+
+    /** Steps a range of the instances on a pool thread */
+    class StepJob : public ThreadPoolJob
+    {
+    public:
+        StepJob (LevelBatch & batch, int begin, int end)
+            : ThreadPoolJob ("LevelBatch"), batch (batch), begin (begin), end (end)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            for (int i = begin; i < end; i++)
+                batch.stepInstance (i, batch.currentActions[i]);
+
+            return jobHasFinished;
+        }
+
+    private:
+        LevelBatch & batch;
+        int begin, end;
+    };
+
+    static bool isHeld (uint32 action, GameCommand command)
+    {
+        return (action & (1u << command)) != 0;
+    }
+
+    /** Runs one tick of an instance: its input, AI, physics step and
+        triggers, following the rules GameLogic plays by
+     */
+    void stepInstance (int index, uint32 action)
+    {
+        Instance & instance = *instances[index];
+        Level & level = *instance.level;
+
+        if (instance.finished)
+            resetInstance (instance);
+
+        PlayerObject * player = level.getPlayer (0);
+        const int scoreBefore = player->getCurrScore();
+
+        // Input, jumping only when the jump is first held
+        if (isHeld (action, Player1MoveUp) && !isHeld (instance.lastAction, Player1MoveUp))
+            player->moveUp();
+        if (isHeld (action, Player1MoveDown))
+            player->moveDown();
+        if (isHeld (action, Player1MoveLeft))
+            player->moveLeft();
+        if (isHeld (action, Player1MoveRight))
+            player->moveRight();
+
+        instance.lastAction = action;
+
+        // Every step is one full fixed step of the level's world, and the
+        // AI and behaviours see the same time passing
+        const float32 timeStep = level.getWorldPhysics().getTimeStep();
+
+        level.updateEnemyAI (timeStep);
+        level.updateBehaviours (timeStep);
+
+        level.prepareWorldPhysics();
+        level.stepWorldPhysics (timeStep);
+        level.syncWithWorldPhysics();
+
+        // Pickups, stomps and goals from the trigger sensors the player
+        // entered during the step
+        bool lifeLost = level.hasPlayerLeftWorldBounds();
+        bool completed = false;
+
+        for (auto & event : level.getWorldPhysics().getContactEvents())
+        {
+            if (event.type != ContactEvent::begin || !event.isSensor())
+                continue;
+
+            GameObject * sensorObject = event.getSensorObject();
+
+            if (sensorObject == nullptr || event.getOther (sensorObject) != player)
+                continue;
+
+            switch (sensorObject->getObjType())
+            {
+                case Enemy:
+                {
+                    EnemyObject * enemy = static_cast<EnemyObject *> (sensorObject);
+
+                    if (!enemy->getIsActive())
+                        break;
+
+                    if (enemy->collision (*player, level.getEnemyPoints()))
+                        lifeLost = true;
+                    else
+                        level.enemyStomped (enemy);
+                    break;
+                }
+                case Collectable:
+                    if (static_cast<CollectableObject *> (sensorObject)->collision (*player))
+                    {
+                        player->addCurrScore (level.getCollectablePoints());
+                        level.collectablePicked (sensorObject);
+                    }
+                    break;
+                case Checkpoint:
+                    completed = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        level.getWorldPhysics().clearContactEvents();
+
+        float reward = (float) (player->getCurrScore() - scoreBefore);
+
+        if (completed)
+        {
+            reward += completionReward;
+            instance.finished = true;
+        }
+        else if (lifeLost)
+        {
+            reward -= lifeLostPenalty;
+
+            // Respawn as GameLogic does, or finish on the last life
+            const int livesLeft = player->getCurrLives() - 1;
+
+            if (livesLeft <= 0)
+            {
+                player->setCurrLives (0);
+                instance.finished = true;
+            }
+            else
+            {
+                level.resetLevel();
+                player->setCurrLives (livesLeft);
+            }
+        }
+
+        rewards[index] = reward;
+        done[index] = instance.finished ? 1 : 0;
+        writeObservation (index);
+    }
+
+    void resetInstance (Instance & instance)
+    {
+        Level & level = *instance.level;
+        level.resetLevel();
+        level.resetEnemyAI();
+
+        instance.lastAction = 0;
+        instance.finished = false;
+    }
+
+    void writeObservation (int index)
+    {
+        Level & level = *instances[index]->level;
+        PlayerObject * player = level.getPlayer (0);
+
+        b2Vec2 position = player->getPhysicsProperties().GetPosition();
+        b2Vec2 velocity = player->getPhysicsProperties().getLinearVel();
+
+        EntityStore & entities = level.getEntities();
+        b2Vec2 nearestEnemy (0.0f, 0.0f);
+
+        const int nearest = entities.findNearestEnemy (position.x, position.y);
+
+        if (nearest >= 0)
+        {
+            EntityHandle enemy = entities.getEnemyHandle (nearest);
+            nearestEnemy.Set (entities.getPositionX (enemy) - position.x, entities.getPositionY (enemy) - position.y);
+        }
+
+        float * observation = observations.data() + index * numObservations;
+        observation[playerX] = position.x;
+        observation[playerY] = position.y;
+        observation[playerVelocityX] = velocity.x;
+        observation[playerVelocityY] = velocity.y;
+        observation[nearestEnemyX] = nearestEnemy.x;
+        observation[nearestEnemyY] = nearestEnemy.y;
+        observation[score] = (float) player->getCurrScore();
+        observation[lives] = (float) player->getCurrLives();
+        observation[pickupsLeft] = (float) entities.countActivePickups();
+    }
+
+    OwnedArray<Instance> instances;
+    OwnedArray<StepJob> jobs;
+    ThreadPool threadPool;
+
+    /** The actions of the step being run, read by the jobs */
+    const uint32 * currentActions = nullptr;
+
+    std::vector<float> observations;
+    std::vector<float> rewards;
+    std::vector<uint8> done;
+
+    float completionReward;
+    float lifeLostPenalty;
+
+    int64 totalSteps;
+    double totalStepMs;
+
+    JUCE_LEAK_DETECTOR(LevelBatch)
+};
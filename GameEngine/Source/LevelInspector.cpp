@@ -96,7 +96,7 @@ void LevelInspector::updateInspector(GameModel & gameModel)
 	for (GameObject * gameObj : selectedLevel->getGameObjects())
 	{
 		// Add to internal array of game objects???
-		if (gameObj->getName() != "Killing Floor") {
+		if (gameObj->getName() != "Killing Floor" && !selectedLevel->isPooled(gameObj)) {
 			gameObjects.addIfNotAlreadyThere(gameObj);
 			SelectObjectButtonPropertyComponent* objectRow =
 				new SelectObjectButtonPropertyComponent(gameObjects.indexOf(gameObj),
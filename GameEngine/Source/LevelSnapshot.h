@@ -0,0 +1,166 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObject.h"
+#include "WorldPhysics.h"
+#include "ObjectPool.h"
+#include <vector>
+
+/** The state every GameObject of a Level starts play in, recorded when play
+    starts so the level can be reset (on respawn, when a checkpoint is left
+    or from the editor) without rebuilding the objects one by one.
+
+    Restoring compares each object with its recorded state and only touches
+    the ones that have left it, which during play are the few objects that
+    move or were picked up, so the cost of a reset follows what happened
+    rather than the size of the level. The bodies that moved are put back
+    with a single b2World::SetTransforms, which places them all before
+    updating the broadphase once, instead of a SetTransform per body.
+ */
+class LevelSnapshot
+{
+public:
+    LevelSnapshot()
+    {
+    }
+
+    /** Records the state each object starts play in: at its origin,
+        unrotated and at rest, and active and drawn as it is now. Pooled
+        objects are left out, the level despawns them instead.
+     */
+    void capture (const OwnedArray<GameObject> & gameObjects, const ObjectPool & pool)
+    {
+        states.clear();
+        numObjects = gameObjects.size();
+
+        for (auto object : gameObjects)
+        {
+            // Static blocks cannot leave that state during play, leaving
+            // them out keeps a restore down to the objects gameplay changes
+            if (object->getObjType() == Generic && object->getPhysicsProperties().getIsStatic())
+                continue;
+
+            if (pool.contains (object))
+                continue;
+
+            ObjectState state;
+            state.object = object;
+            state.position.Set (object->getOrigin().x, object->getOrigin().y);
+            state.angle = 0.0f;
+            state.velocity.SetZero();
+            state.angularVelocity = 0.0f;
+            state.active = object->getIsActive();
+            state.renderable = object->isRenderable();
+
+            states.push_back (state);
+        }
+    }
+
+    /** Forgets the recorded state, must be called when objects are deleted */
+    void clear()
+    {
+        states.clear();
+        numObjects = 0;
+    }
+
+    /** The number of objects the level had when the state was recorded */
+    int getNumObjects()
+    {
+        return numObjects;
+    }
+
+    /** Puts every object that has left its recorded state back into it.
+        While a step is running on the physics thread the bodies are moved
+        once it has finished, the objects report their restored state
+        straight away.
+     */
+    void restore (WorldPhysics & worldPhysics)
+    {
+        std::vector<b2Body *> bodies;
+        std::vector<b2Vec2> positions;
+        std::vector<float32> angles;
+        std::vector<PhysicsProperties *> moved;
+        std::vector<PhysicsProperties *> restored;
+        std::vector<b2Vec2> velocities;
+        std::vector<float32> angularVelocities;
+        std::vector<ObjectState *> reactivated;
+
+        for (auto & state : states)
+        {
+            GameObject & object = *state.object;
+            PhysicsProperties & physics = object.getPhysicsProperties();
+
+            object.setRenderable (state.renderable);
+
+            if (object.getIsActive() != state.active)
+                reactivated.push_back (&state);
+
+            const bool hasMoved = !(physics.GetPosition() == state.position)
+                                  || physics.getRotation() != radiansToDegrees (state.angle);
+            const bool isMoving = !(physics.getLinearVel() == state.velocity)
+                                  || physics.getAngularVel() != state.angularVelocity;
+
+            if (!hasMoved && !isMoving)
+                continue;
+
+            if (hasMoved)
+            {
+                bodies.push_back (physics.getBody());
+                positions.push_back (state.position);
+                angles.push_back (state.angle);
+                moved.push_back (&physics);
+
+                object.setPosition (state.position.x, state.position.y);
+            }
+
+            // Every body put back gets its recorded velocities, a body that
+            // was only moved may still be spinning
+            restored.push_back (&physics);
+            velocities.push_back (state.velocity);
+            angularVelocities.push_back (state.angularVelocity);
+
+            physics.setSnapshot (state.position, state.angle, state.velocity, state.angularVelocity);
+        }
+
+        if (!restored.empty())
+        {
+            b2World * world = &worldPhysics.getWorld();
+
+            worldPhysics.runBetweenSteps (nullptr, [world, bodies, positions, angles, moved, restored, velocities, angularVelocities]
+            {
+                world->SetTransforms (bodies.data(), positions.data(), angles.data(), (int32) bodies.size());
+
+                for (size_t i = 0; i < restored.size(); i++)
+                {
+                    restored[i]->getBody()->SetLinearVelocity (velocities[i]);
+                    restored[i]->getBody()->SetAngularVelocity (angularVelocities[i]);
+                }
+
+                for (auto physics : moved)
+                    physics->wakeUp();
+            });
+        }
+
+        // Activated after the bodies are back in place, so their proxies are
+        // created where they belong
+        for (auto state : reactivated)
+            state->object->setActive (state->active);
+    }
+
+private:
+    struct ObjectState
+    {
+        GameObject * object;
+        b2Vec2 position;
+        float32 angle;
+        b2Vec2 velocity;
+        float32 angularVelocity;
+        bool active;
+        bool renderable;
+    };
+
+    std::vector<ObjectState> states;
+    int numObjects = 0;
+
+    JUCE_LEAK_DETECTOR(LevelSnapshot)
+};
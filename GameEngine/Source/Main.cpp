@@ -10,6 +10,10 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "GameEditor.h"
+#include "GameModel.h"
+#include "GameLogic.h"
+#include "InputLog.h"
+#include "LevelBatch.h"
 
 
 //==============================================================================
@@ -28,6 +32,29 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        // Replay a session recorded with --record, without opening the editor:
+        //   --replay <session.gamelog> [<timings.csv>]
+        StringArray arguments = getCommandLineParameterArray();
+        const int replayIndex = arguments.indexOf ("--replay");
+
+        if (replayIndex >= 0)
+        {
+            setApplicationReturnValue (replaySession (arguments[replayIndex + 1], arguments[replayIndex + 2]));
+            quit();
+            return;
+        }
+
+        // Measure the batch simulation of the saved game's first level:
+        //   --batch <instances> <steps>
+        const int batchIndex = arguments.indexOf ("--batch");
+
+        if (batchIndex >= 0)
+        {
+            setApplicationReturnValue (runBatch (arguments[batchIndex + 1].getIntValue(), arguments[batchIndex + 2].getIntValue()));
+            quit();
+            return;
+        }
+
 		mainWindow = new MainWindow(getApplicationName());
     }
 
@@ -36,6 +63,11 @@ public:
         // Add your application's shutdown code here..
 
         mainWindow = nullptr; // (deletes our window)
+
+        // The shared archetypes and clips outlive the levels, let go of
+        // them before the leak detectors are checked
+        ArchetypeLibrary::getInstance().clear();
+        AnimationClipCache::getInstance().clear();
     }
 
     //==============================================================================
@@ -94,6 +126,95 @@ public:
 
 
 private:
+    /** Replays a recorded session headless and writes the time each tick
+        took to a CSV file, if one is given. Returns 0 if every tick ended in
+        the state that was recorded.
+    */
+    static int replaySession (const String& logPath, const String& timingPath)
+    {
+        InputLog log;
+
+        if (! log.loadFromFile (File::getCurrentWorkingDirectory().getChildFile (logPath)))
+        {
+            Logger::writeToLog ("Could not read the recorded session " + logPath);
+            return 1;
+        }
+
+        GameModel gameModel (log.getGame());
+        CriticalSection objectDeletionLock;
+        RenderSwapFrame renderSwapFrame;
+
+        GameLogic gameLogic (&objectDeletionLock);
+        gameLogic.setGameModel (&gameModel);
+        gameLogic.setRenderSwapFrame (&renderSwapFrame);
+
+        std::vector<GameLogic::TickTiming> timings;
+        const bool matched = gameLogic.replay (log, timings);
+
+        if (timings.empty() && ! matched)
+        {
+            Logger::writeToLog ("The session was recorded with a different physics step");
+            return 1;
+        }
+
+        String csv = "tick,frameMs,stepMs,matches\n";
+        double totalMs = 0.0;
+        int firstMismatch = -1;
+
+        for (size_t i = 0; i < timings.size(); ++i)
+        {
+            csv << (int) i << "," << String (timings[i].frameMs, 4) << "," << String (timings[i].stepMs, 4)
+                << "," << (timings[i].matches ? 1 : 0) << "\n";
+
+            totalMs += timings[i].frameMs;
+
+            if (! timings[i].matches && firstMismatch < 0)
+                firstMismatch = (int) i;
+        }
+
+        if (timingPath.isNotEmpty())
+            File::getCurrentWorkingDirectory().getChildFile (timingPath).replaceWithText (csv);
+
+        Logger::writeToLog ("Replayed " + String ((int) timings.size()) + " ticks, "
+                            + String (timings.empty() ? 0.0 : totalMs / timings.size(), 3) + " ms a tick on average, "
+                            + (matched ? String ("matching the recording")
+                                       : "diverged from the recording at tick " + String (firstMismatch)));
+
+        return matched ? 0 : 1;
+    }
+
+    /** Steps copies of the saved game's first level as a LevelBatch and
+        reports the simulation throughput
+    */
+    static int runBatch (int numInstances, int numSteps)
+    {
+        File saveFile = File (File::getCurrentWorkingDirectory().getFullPathName() + "/SaveGame/savefile.xml");
+        ScopedPointer<GameModel> gameModel = saveFile.exists() ? new GameModel (saveFile) : new GameModel();
+
+        LevelBatch batch (gameModel->getLevel (0), jmax (1, numInstances));
+
+        // Run right, jumping now and then, so the instances do not all rest
+        std::vector<uint32> actions (batch.getNumInstances());
+
+        for (int step = 0; step < numSteps; ++step)
+        {
+            for (size_t i = 0; i < actions.size(); ++i)
+            {
+                actions[i] = 1u << Player1MoveRight;
+
+                if ((step + (int) i) % 30 == 0)
+                    actions[i] |= 1u << Player1MoveUp;
+            }
+
+            batch.step (actions.data());
+        }
+
+        Logger::writeToLog ("Stepped " + String (batch.getNumInstances()) + " instances " + String (numSteps) + " times: "
+                            + String (batch.getStepsPerSecondPerCore(), 1) + " simulation steps per second per core");
+
+        return 0;
+    }
+
 	ScopedPointer<MainWindow> mainWindow;
 };
 
@@ -29,6 +29,7 @@ public:
     {
         meshes.push_back(Mesh());
         registeredWithOpenGLContext = false;
+        calculateSize();
     }
     
     /** Custom constructor that allows you to specify meshes
@@ -37,6 +38,7 @@ public:
     {
         this->meshes = meshes;
         registeredWithOpenGLContext = false;
+        calculateSize();
     }
     
     /** Returns true of the mesh has been registered and flase otherwise
@@ -86,42 +88,42 @@ public:
     /** Gets the height of a Model
      */
 	float getHeight() {
-        
-        float maxY = 0.0f;
-        float minY = 0.0f;
-        
-		for (Mesh &m : meshes)
-        {
-			for (auto v : m.getVertices())
-            {
-				maxY = max(v.position.y, maxY);
-				minY = min(v.position.y, minY);
-			}
-		}
-
-		return maxY - minY;
+		return height;
 	}
 
     /** Gets the width of a Model
      */
 	float getWidth() {
-        
+		return width;
+	}
+
+private:
+    
+    /** Measures the meshes once, they never change after construction */
+    void calculateSize()
+    {
         float maxX = 0.0f;
         float minX = 0.0f;
+        float maxY = 0.0f;
+        float minY = 0.0f;
         
 		for (Mesh &m : meshes)
         {
-			for (auto v : m.getVertices())
+			for (auto & v : m.getVertices())
             {
 				maxX = max(v.position.x, maxX);
 				minX = min(v.position.x, minX);
+				maxY = max(v.position.y, maxY);
+				minY = min(v.position.y, minY);
 			}
 		}
         
-		return maxX - minX;
-	}
-
-private:
+        width = maxX - minX;
+        height = maxY - minY;
+    }
+    
+    /** Size of the meshes, measured on construction */
+    float width, height;
     
     /** Specifies whether or not the Model has been registered with an OpenGLContext */
     bool registeredWithOpenGLContext;
@@ -0,0 +1,276 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObject.h"
+#include "WorldGrid.h"
+#include <unordered_map>
+#include <vector>
+
+/** Which cells of the WorldGrid a level's static blocks fill, for the
+    enemies to find their way around them.
+
+    Each grid unit is a cell, centred on the positions the editor puts blocks
+    on, and keeps a count of the blocks covering it, so overlapping blocks
+    are handled. The grid remembers the cells each block covered, and an
+    update only changes the cells of the blocks that were added, moved,
+    resized or deleted since the last one. It is updated when the level is
+    edited, along with the StaticGeometry, never while playing.
+
+    The cells that became filled or empty are kept for a while, so that a
+    FlowField can repair itself around them rather than start again.
+ */
+class NavGrid
+{
+public:
+    NavGrid()
+    {
+        originX = originY = 0;
+        width = height = 0;
+        revision = 0;
+        updateNumber = 0;
+        firstLoggedRevision = 1;
+    }
+
+    /** Brings the cells up to date with the static blocks of the level.
+        Returns true if any cell became filled or empty.
+     */
+    bool update (const OwnedArray<GameObject> & gameObjects)
+    {
+        updateNumber++;
+        bool changed = false;
+
+        // Forget old changes once there are many, a field that was last built
+        // before them starts again instead
+        if (changes.size() > maxLoggedChanges)
+        {
+            changes.clear();
+            firstLoggedRevision = revision + 1;
+        }
+
+        for (auto object : gameObjects)
+        {
+            if (!isBlock (*object))
+                continue;
+
+            CellRange range = getCells (*object);
+            auto entry = blocks.find (object);
+
+            if (entry == blocks.end())
+            {
+                range.seen = updateNumber;
+                blocks[object] = range;
+                fill (range, 1);
+                changed = true;
+            }
+            else
+            {
+                CellRange & previous = entry->second;
+                previous.seen = updateNumber;
+
+                if (!previous.sameCells (range))
+                {
+                    fill (previous, -1);
+                    fill (range, 1);
+                    range.seen = updateNumber;
+                    previous = range;
+                    changed = true;
+                }
+            }
+        }
+
+        // Blocks not seen have been deleted or stopped being blocks
+        for (auto entry = blocks.begin(); entry != blocks.end();)
+        {
+            if (entry->second.seen != updateNumber)
+            {
+                fill (entry->second, -1);
+                entry = blocks.erase (entry);
+                changed = true;
+            }
+            else
+            {
+                ++entry;
+            }
+        }
+
+        if (changed)
+            revision++;
+
+        return changed;
+    }
+
+    /** Changes every time a cell becomes filled or empty */
+    uint32 getRevision() const
+    {
+        return revision;
+    }
+
+    /** Calls a function with the x and y of every cell that became filled or
+        empty after a revision, possibly more than once for the same cell.
+        Returns false, without calling it, if those changes are no longer kept.
+     */
+    template <typename Function>
+    bool forEachChangeSince (uint32 sinceRevision, Function function) const
+    {
+        if (sinceRevision + 1 < firstLoggedRevision)
+            return false;
+
+        for (size_t i = changes.size(); i-- > 0 && changes[i].revision > sinceRevision;)
+            function (changes[i].cellX, changes[i].cellY);
+
+        return true;
+    }
+
+    bool isBlocked (int cellX, int cellY) const
+    {
+        const int x = cellX - originX;
+        const int y = cellY - originY;
+
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            return false;
+
+        return counts[y * width + x] > 0;
+    }
+
+    int getCellX (float x)
+    {
+        return grid.getClosestGridUnitIndex (x);
+    }
+
+    int getCellY (float y)
+    {
+        return grid.getClosestGridUnitIndex (y);
+    }
+
+private:
+    /** A cell that became filled or empty, and the revision that did it */
+    struct CellChange
+    {
+        int cellX, cellY;
+        uint32 revision;
+    };
+
+    struct CellRange
+    {
+        int minX, minY, maxX, maxY;
+        uint32 seen;
+
+        bool sameCells (const CellRange & other) const
+        {
+            return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+        }
+    };
+
+    /** Blocks are the solid parts of the level that do not move, the same
+        ones StaticGeometry merges
+     */
+    static bool isBlock (GameObject & object)
+    {
+        PhysicsProperties & physics = object.getPhysicsProperties();
+
+        return object.getObjType() == GameObjectType::Generic
+            && object.getIsActive()
+            && physics.getIsStatic()
+            && physics.getCollidable();
+    }
+
+    /** The cells whose centres a block covers, or the cell of its centre if
+        it is smaller than a cell
+     */
+    CellRange getCells (GameObject & object)
+    {
+        b2AABB bounds = object.getPhysicsProperties().getCollisionBounds();
+        const float half = grid.getUnitLength() * 0.5f;
+
+        CellRange range;
+        range.minX = grid.getClosestGridUnitIndex (bounds.lowerBound.x + b2_polygonRadius + half);
+        range.minY = grid.getClosestGridUnitIndex (bounds.lowerBound.y + b2_polygonRadius + half);
+        range.maxX = grid.getClosestGridUnitIndex (bounds.upperBound.x - b2_polygonRadius - half);
+        range.maxY = grid.getClosestGridUnitIndex (bounds.upperBound.y - b2_polygonRadius - half);
+        range.seen = 0;
+
+        if (range.maxX < range.minX)
+            range.minX = range.maxX = getCellX (object.getPosition().x);
+        if (range.maxY < range.minY)
+            range.minY = range.maxY = getCellY (object.getPosition().y);
+
+        return range;
+    }
+
+    void fill (const CellRange & range, int change)
+    {
+        if (change > 0)
+            growToFit (range);
+
+        for (int y = range.minY; y <= range.maxY; y++)
+        {
+            for (int x = range.minX; x <= range.maxX; x++)
+            {
+                uint16 & count = counts[(y - originY) * width + (x - originX)];
+                const bool wasBlocked = count > 0;
+                count += (uint16) change;
+
+                if (wasBlocked != (count > 0))
+                    changes.push_back ({ x, y, revision + 1 });
+            }
+        }
+    }
+
+    /** Grows the stored cells to take in a range, with room to spare so
+        that editing near the edge does not grow them every time
+     */
+    void growToFit (const CellRange & range)
+    {
+        if (width > 0 && range.minX >= originX && range.minY >= originY
+            && range.maxX < originX + width && range.maxY < originY + height)
+            return;
+
+        const int margin = 32;
+        int newMinX = range.minX - margin, newMinY = range.minY - margin;
+        int newMaxX = range.maxX + margin, newMaxY = range.maxY + margin;
+
+        if (width > 0)
+        {
+            newMinX = jmin (newMinX, originX);
+            newMinY = jmin (newMinY, originY);
+            newMaxX = jmax (newMaxX, originX + width - 1);
+            newMaxY = jmax (newMaxY, originY + height - 1);
+        }
+
+        const int newWidth = newMaxX - newMinX + 1;
+        const int newHeight = newMaxY - newMinY + 1;
+        std::vector<uint16> newCounts ((size_t) newWidth * newHeight, 0);
+
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                newCounts[(y + originY - newMinY) * newWidth + (x + originX - newMinX)] = counts[y * width + x];
+
+        counts.swap (newCounts);
+        originX = newMinX;
+        originY = newMinY;
+        width = newWidth;
+        height = newHeight;
+    }
+
+    WorldGrid grid;
+
+    // Blocks covering each cell, row by row from the origin
+    std::vector<uint16> counts;
+    int originX, originY;
+    int width, height;
+
+    /** The cells each block covered at the last update */
+    std::unordered_map<GameObject *, CellRange> blocks;
+
+    uint32 revision;
+    uint32 updateNumber;
+
+    /** The cells that became filled or empty, oldest first, from
+        firstLoggedRevision on
+     */
+    std::vector<CellChange> changes;
+    uint32 firstLoggedRevision;
+    static const size_t maxLoggedChanges = 4096;
+
+    JUCE_LEAK_DETECTOR(NavGrid)
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObject.h"
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+/** A bounding volume tree over the drawn bounds of every GameObject of a
+    Level, used by the editor to pick objects under the mouse and to find
+    the objects inside a lasso.
+
+    The physics broadphase cannot be used for this since it leaves out
+    inactive bodies, the blocks merged into StaticGeometry and anything that
+    is not collidable, all of which can still be selected. Instead the tree
+    keeps its own b2DynamicTree, with the bounds of each object cached.
+    Moving or rescaling an object only sets a flag on it (see
+    GameObject::takeBoundsChange), so gameplay never waits on the tree, and
+    only the flagged objects are refit before the next query.
+
+    The level tells the tree about every object it adds and removes, the
+    tree never looks through the level's objects for changes.
+ */
+class ObjectBoundsTree
+{
+public:
+    ObjectBoundsTree()
+    {
+    }
+
+    ~ObjectBoundsTree()
+    {
+    }
+
+    /** Must be called whenever an object is added to the level */
+    void objectAdded (GameObject * object)
+    {
+        const ScopedLock lock (treeLock);
+
+        if (entries.find (object) != entries.end())
+            return;
+
+        object->takeBoundsChange();
+
+        Entry entry;
+        entry.bounds = computeBounds (*object);
+        entry.proxyId = tree.CreateProxy (entry.bounds, object);
+
+        entries[object] = entry;
+    }
+
+    /** Must be called before an object is deleted from the level */
+    void objectRemoved (GameObject * object)
+    {
+        const ScopedLock lock (treeLock);
+
+        auto entry = entries.find (object);
+
+        if (entry == entries.end())
+            return;
+
+        tree.DestroyProxy (entry->second.proxyId);
+        entries.erase (entry);
+    }
+
+    /** Returns the first object, in the order of the level's objects, whose
+        bounds contain a position, or nullptr if there is none
+     */
+    GameObject * getObjectAtPosition (const OwnedArray<GameObject> & gameObjects, glm::vec2 position)
+    {
+        const ScopedLock lock (treeLock);
+        update();
+
+        b2AABB area;
+        area.lowerBound.Set (position.x, position.y);
+        area.upperBound = area.lowerBound;
+
+        candidates.clear();
+        query (area);
+
+        GameObject * found = nullptr;
+        int foundIndex = gameObjects.size();
+
+        for (auto object : candidates)
+        {
+            if (!contains (entries[object].bounds, position))
+                continue;
+
+            // Overlapping objects are rare, only then is the order looked up
+            if (found == nullptr)
+            {
+                found = object;
+                continue;
+            }
+
+            if (foundIndex == gameObjects.size())
+                foundIndex = gameObjects.indexOf (found);
+
+            const int index = gameObjects.indexOf (object);
+
+            if (index < foundIndex)
+            {
+                found = object;
+                foundIndex = index;
+            }
+        }
+
+        return found;
+    }
+
+    /** Returns the objects whose centre is inside a range */
+    Array<GameObject *> getObjectsInRange (float xMin, float xMax, float yMin, float yMax)
+    {
+        const ScopedLock lock (treeLock);
+        update();
+
+        b2AABB area;
+        area.lowerBound.Set (xMin, yMin);
+        area.upperBound.Set (xMax, yMax);
+
+        candidates.clear();
+        query (area);
+
+        Array<GameObject *> objectsInRange;
+
+        for (auto object : candidates)
+        {
+            if (object->isInRange (xMin, xMax, yMin, yMax))
+                objectsInRange.add (object);
+        }
+
+        return objectsInRange;
+    }
+
+    int getNumObjects()
+    {
+        const ScopedLock lock (treeLock);
+        return (int) entries.size();
+    }
+
+    /** Called by b2DynamicTree::Query for every proxy overlapping the area */
+    bool QueryCallback (int32 proxyId)
+    {
+        candidates.push_back (static_cast<GameObject *> (tree.GetUserData (proxyId)));
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        int proxyId;
+        b2AABB bounds;
+    };
+
+    /** Refits the objects that have changed since the last query. Checking
+        the flag of every object is a load each, done only when the editor
+        queries the tree
+     */
+    void update()
+    {
+        for (auto & entry : entries)
+        {
+            GameObject * object = entry.first;
+
+            if (!object->takeBoundsChange())
+                continue;
+
+            b2AABB bounds = computeBounds (*object);
+
+            tree.MoveProxy (entry.second.proxyId, bounds, bounds.GetCenter() - entry.second.bounds.GetCenter());
+            entry.second.bounds = bounds;
+        }
+    }
+
+    void query (const b2AABB & area)
+    {
+        tree.Query (this, area);
+    }
+
+    /** The drawn bounds of an object: its Model's size, scaled, around its
+        position
+     */
+    static b2AABB computeBounds (GameObject & object)
+    {
+        glm::vec2 position = object.getPosition();
+        glm::vec2 scale = object.getScale();
+        Model * model = object.getRenderableObject().model;
+
+        float halfWidth = 0.0f;
+        float halfHeight = 0.0f;
+
+        if (model != nullptr)
+        {
+            halfWidth = model->getWidth() * std::abs (scale.x) / 2.0f;
+            halfHeight = model->getHeight() * std::abs (scale.y) / 2.0f;
+        }
+
+        b2AABB bounds;
+        bounds.lowerBound.Set (position.x - halfWidth, position.y - halfHeight);
+        bounds.upperBound.Set (position.x + halfWidth, position.y + halfHeight);
+        return bounds;
+    }
+
+    static bool contains (const b2AABB & bounds, glm::vec2 position)
+    {
+        return bounds.lowerBound.x <= position.x && position.x <= bounds.upperBound.x
+            && bounds.lowerBound.y <= position.y && position.y <= bounds.upperBound.y;
+    }
+
+    b2DynamicTree tree;
+
+    std::unordered_map<GameObject *, Entry> entries;
+
+    /** Guards the tree, objects may be added and removed on another thread
+        than the editor's queries */
+    CriticalSection treeLock;
+
+    /** Scratch list filled by each query */
+    std::vector<GameObject *> candidates;
+
+    JUCE_LEAK_DETECTOR(ObjectBoundsTree)
+};
@@ -192,11 +192,39 @@ public:
 			selectedObj->setScale(scale, scale);
 		}
 
+		else if (value.refersToSameSourceAs(filterCategory)) {
+			const int id = (int)filterCategory.getValue();
+
+			if (id > 0) {
+				PhysicsProperties & physics = selectedObj->getPhysicsProperties();
+				physics.setCollisionFilter(getFilterCategoryBits(id - 1), physics.getMaskBits());
+			}
+		}
+
+		else {
+			for (int i = 0; i < numFilterCategories; i++) {
+				if (value.refersToSameSourceAs(filterMask[i])) {
+					PhysicsProperties & physics = selectedObj->getPhysicsProperties();
+					uint16 maskBits = physics.getMaskBits();
+
+					if ((bool)filterMask[i].getValue())
+						maskBits |= getFilterCategoryBits(i);
+					else
+						maskBits &= ~getFilterCategoryBits(i);
+
+					physics.setCollisionFilter(physics.getCategoryBits(), maskBits);
+					break;
+				}
+			}
+		}
+
 	}
 
 	void filenameComponentChanged(FilenameComponent *fileComponentThatHasChanged) {
 		if (fileComponentThatHasChanged->getName() == "Animation Directory") {
-			selectedObj->getRenderableObject().animationProperties.setAnimationTextures(fileComponentThatHasChanged->getCurrentFile());
+			// Scan the directory again in case its files have changed since it was last used
+			File directory = fileComponentThatHasChanged->getCurrentFile();
+			selectedObj->getRenderableObject().animationProperties.setAnimationClip(AnimationClipCache::getInstance().rescan(directory));
 			updateInspectorsChangeBroadcaster->sendSynchronousChangeMessage();
 		}
 
@@ -322,10 +350,54 @@ private:
 		stateComboValue.addListener(this);
 		objPhysicsProperties.add(combo);
 
+		addCollisionFilterProperties();
+
 		//Add HUD properties to panel
 		propertyPanel.addSection("Physical Attributes", objPhysicsProperties);
 	}
 
+	//the category of the collision box and the categories it collides with,
+	//see CollisionFiltering
+	void addCollisionFilterProperties() {
+		PhysicsProperties & physics = selectedObj->getPhysicsProperties();
+		const uint16 categoryBits = physics.getCategoryBits();
+		const uint16 maskBits = physics.getMaskBits();
+
+		// A category that is not one of the listed ones shows as nothing selected
+		int categoryId = 0;
+		for (int i = 0; i < numFilterCategories; i++) {
+			if (categoryBits == getFilterCategoryBits(i))
+				categoryId = i + 1;
+		}
+
+		filterCategory.setValue(var(categoryId));
+		ComboBoxPropertyComponent* combo = new ComboBoxPropertyComponent(filterCategory, "Category:");
+		combo->setTextWhenNothingSelected("Choose Category");
+		for (int i = 0; i < numFilterCategories; i++) {
+			combo->addItem(getFilterCategoryName(i), i + 1);
+		}
+		combo->setSelectedId(categoryId, dontSendNotification);
+		filterCategory.addListener(this);
+		objPhysicsProperties.add(combo);
+
+		for (int i = 0; i < numFilterCategories; i++) {
+			filterMask[i].setValue(var((maskBits & getFilterCategoryBits(i)) != 0));
+			BooleanPropertyComponent* toggle = new BooleanPropertyComponent(filterMask[i], "Hits " + getFilterCategoryName(i) + ":", "Collides");
+			filterMask[i].addListener(this);
+			objPhysicsProperties.add(toggle);
+		}
+	}
+
+	//the CollisionFiltering categories are the first bits, in this order
+	static uint16 getFilterCategoryBits(int index) {
+		return (uint16)(1 << index);
+	}
+
+	static String getFilterCategoryName(int index) {
+		const char* names[numFilterCategories] = { "World", "Player", "AI", "Trigger", "Collectable", "Goal" };
+		return names[index];
+	}
+
 	void addHudProperties()
 	{
 		playerLives.setValue(var(selectedObj->getLives()));
@@ -362,13 +434,13 @@ private:
 	void addAudioProperties()
 	{
 		// Get file already associated with selected object
-		File * collisionAudioFile = selectedObj->getAudioFileForAction(PhysicalAction::collsion);
+		const File * collisionAudioFile = selectedObj->getAudioFileForAction(PhysicalAction::collsion);
 
 		FilenamePropertyComponent* collisionAudio = new FilenamePropertyComponent("Choose Collision Audio", (collisionAudioFile == nullptr) ? File() : *collisionAudioFile, false, false, false, "", "", "Select a file");
 		collisionAudio->addListener(this);
 		objAudioProperties.add(collisionAudio);
 
-		File * deathAudioFile = selectedObj->getAudioFileForAction(PhysicalAction::death);
+		const File * deathAudioFile = selectedObj->getAudioFileForAction(PhysicalAction::death);
 
 		FilenamePropertyComponent* deathAudio = new FilenamePropertyComponent("Choose Death Audio", (deathAudioFile == nullptr) ? File() : *deathAudioFile, false, false, false, "", "", "Select a file");
 		deathAudio->addListener(this);
@@ -429,6 +501,10 @@ private:
 		   objPhysicsDensity, comboValue, stateComboValue, aiState,
 			playerLives, levelGoTo,levelToWin, Scale;
 
+	static const int numFilterCategories = 6;
+	Value filterCategory;
+	Value filterMask[numFilterCategories];
+
 
 	ScopedPointer<FilenameComponent> chooseFile;
 
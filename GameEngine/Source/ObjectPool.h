@@ -0,0 +1,165 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObject.h"
+#include "GameObjectType.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+/** The GameObjects a Level makes ahead of time for gameplay to spawn while
+    playing, such as projectiles and dropped pickups, kept on a free list
+    per type.
+
+    Pooled objects live in the level like any other, with their bodies made,
+    but stay inactive and hidden until they are spawned, so spawning and
+    despawning only switch them on and off. Once the pool holds as many as
+    are ever out at once, play makes no new objects or bodies at all.
+
+    The pool only keeps track of the objects, the Level makes them, turns
+    them on and off and leaves them out of what it saves.
+
+    The objects are kept in the order they were added, and releaseAll()
+    puts the free lists back in that order, so after a reset the same
+    objects are spawned in the same order on every run and a replay
+    steps the same bodies.
+ */
+class ObjectPool
+{
+public:
+    ObjectPool()
+    {
+    }
+
+    /** Adds an object to the pool, free to be spawned */
+    void add (GameObject * object)
+    {
+        Member member;
+        member.object = object;
+        member.taken = false;
+
+        indices[object] = members.size();
+        members.push_back (member);
+        freeObjects[object->getObjType()].push_back (object);
+    }
+
+    /** Takes a free object of a type, or returns nullptr if there is none */
+    GameObject * take (GameObjectType type)
+    {
+        std::vector<GameObject *> & free = freeObjects[type];
+
+        if (free.empty())
+            return nullptr;
+
+        GameObject * object = free.back();
+        free.pop_back();
+        members[indices[object]].taken = true;
+
+        return object;
+    }
+
+    /** Gives back an object that was taken. Returns false if it is not from
+        the pool or was not taken.
+     */
+    bool release (GameObject * object)
+    {
+        auto index = indices.find (object);
+
+        if (index == indices.end() || !members[index->second].taken)
+            return false;
+
+        members[index->second].taken = false;
+        freeObjects[object->getObjType()].push_back (object);
+        return true;
+    }
+
+    /** Gives back every object that was taken, calling function (object)
+        for each in the order they were added, and puts the free lists back
+        in that order whatever order they were released in during play
+     */
+    template <typename Function>
+    void releaseAll (Function && function)
+    {
+        for (auto & free : freeObjects)
+            free.clear();
+
+        for (auto & member : members)
+        {
+            if (member.taken)
+            {
+                member.taken = false;
+                function (member.object);
+            }
+        }
+
+        // As they were when the objects were added
+        for (auto & member : members)
+            freeObjects[member.object->getObjType()].push_back (member.object);
+    }
+
+    /** Forgets an object, must be called before it is deleted */
+    void objectRemoved (GameObject * object)
+    {
+        auto index = indices.find (object);
+
+        if (index == indices.end())
+            return;
+
+        if (!members[index->second].taken)
+        {
+            std::vector<GameObject *> & free = freeObjects[object->getObjType()];
+            free.erase (std::remove (free.begin(), free.end(), object), free.end());
+        }
+
+        members.erase (members.begin() + (std::ptrdiff_t) index->second);
+        indices.erase (index);
+
+        for (size_t i = 0; i < members.size(); i++)
+            indices[members[i].object] = i;
+    }
+
+    bool contains (GameObject * object) const
+    {
+        return indices.find (object) != indices.end();
+    }
+
+    /** The number of objects of a type in the pool, taken or not */
+    int getNumPooled (GameObjectType type) const
+    {
+        int numPooled = 0;
+
+        for (auto & member : members)
+        {
+            if (member.object->getObjType() == type)
+                numPooled++;
+        }
+
+        return numPooled;
+    }
+
+    int getNumFree (GameObjectType type) const
+    {
+        return (int) freeObjects[type].size();
+    }
+
+private:
+    static const int numTypes = Bounds + 1;
+
+    struct Member
+    {
+        GameObject * object;
+        bool taken;
+    };
+
+    /** Each pooled object, in the order they were added, and whether it
+        has been taken
+     */
+    std::vector<Member> members;
+
+    /** The index in members of each object */
+    std::unordered_map<GameObject *, size_t> indices;
+
+    std::vector<GameObject *> freeObjects[numTypes];
+
+    JUCE_LEAK_DETECTOR(ObjectPool)
+};
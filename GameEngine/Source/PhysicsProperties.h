@@ -10,6 +10,8 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 
 #include "Model.h"
+#include "WorldPhysics.h"
+#include "CollisionFiltering.h"
 
 /*
 	Holds all the properties that are used for any new
@@ -18,7 +20,18 @@
 class PhysicsProperties
 {
 public:
-	PhysicsProperties(b2World& world) 
+	/** Receives a call whenever the body is switched between static and
+		dynamic, so its GameObject can tell the level's EntityStore
+	*/
+	class TypeListener
+	{
+	public:
+		virtual ~TypeListener() {}
+
+		virtual void bodyTypeChanged() = 0;
+	};
+
+	PhysicsProperties(WorldPhysics& worldPhysics) : worldPhysics(worldPhysics)
 	{
         // FIX
         // Default should be no physics properties, these are added as a Model
@@ -26,11 +39,13 @@ public:
 		
 		//bodies position within the world
 
-		bodyDef.type = b2_dynamicBody;
+		// Create the body with its default (static) type straight away rather
+		// than flipping it afterwards. A deferred body starts inactive, so it
+		// has no broadphase proxies until the level build is finished
+		bodyDef.type = b2_staticBody;
 		bodyDef.position.Set(0.0f, 0.0f);
-
-		//add the body to the world
-		body = world.CreateBody(&bodyDef);
+		bodyDef.active = !worldPhysics.isBuildingBatch();
+		deferredActivation = worldPhysics.isBuildingBatch();
 
 		//create the objects collision box with properties
 		dynamicBox.SetAsBox(0.5f, 0.5f);
@@ -39,8 +54,10 @@ public:
 		fixtureDef.restitution = 0.0f;
 		fixtureDef.density = 1.0f;
 
-		//add fixtures to the body in the world
-		this->myFixture = body->CreateFixture(&fixtureDef);
+		//add the body and its fixture to the world
+		body = worldPhysics.createBody(bodyDef, fixtureDef);
+		this->myFixture = body->GetFixtureList();
+		updateSnapshot();
 		//body->GetContactList()->contact();
 		//b2ContactEdge test;
         
@@ -49,12 +66,12 @@ public:
         setIsStatic(true);
 	}
 	
-	PhysicsProperties(b2World& world, float originx, float originy,float width,float height) 
+	PhysicsProperties(WorldPhysics& worldPhysics, float originx, float originy,float width,float height) : worldPhysics(worldPhysics)
 	{
 		bodyDef.type = b2_dynamicBody;
 		bodyDef.position.Set(originx, originy);
+		isStatic = false;
 
-		body = world.CreateBody(&bodyDef);
 		dynamicBox.SetAsBox(width/2, height/2);
 
 		fixtureDef.shape = &dynamicBox;
@@ -64,7 +81,9 @@ public:
 		fixtureDef.restitution = 0.0f;
 		fixtureDef.density = 1.0f;
 
-		this->myFixture = body->CreateFixture(&fixtureDef);
+		body = worldPhysics.createBody(bodyDef, fixtureDef);
+		this->myFixture = body->GetFixtureList();
+		updateSnapshot();
 	}
 	
 	~PhysicsProperties()
@@ -72,6 +91,13 @@ public:
     
 	}
 	/// body accessors and modifiers
+	///
+	/// Every change to the body, from gameplay (velocities, forces, position,
+	/// active state) or the editor (material, shape, type, filter), goes
+	/// through WorldPhysics::runBetweenSteps, so it is queued while the world
+	/// is stepped on the physics thread and applied before the next step.
+	/// Reads made during a step see the snapshot taken after the last one,
+	/// which is kept up to date with the queued changes
 
 	/**************************************************************************
 	*
@@ -80,7 +106,9 @@ public:
 	**************************************************************************/
 	void setLinearVelocity(GLfloat x, GLfloat y)
 	{
-		body->SetLinearVelocity(b2Vec2(x,y));
+		snapshotVelocity.Set(x, y);
+
+		worldPhysics.setBodyVelocity(body, b2Vec2(x, y));
 	}
 	/**************************************************************************
 	*
@@ -90,7 +118,8 @@ public:
 	**************************************************************************/
 	void setLinearDamping(GLfloat damping)
 	{
-		body->SetLinearDamping(damping);
+		b2Body* body = this->body;
+		worldPhysics.runBetweenSteps(body, [body, damping] { body->SetLinearDamping(damping); });
 	}
 
 	/**************************************************************************
@@ -100,7 +129,10 @@ public:
 	**************************************************************************/
 	void setAngularVelocity(GLfloat angVel)
 	{
-		body->SetAngularVelocity(angVel);
+		snapshotAngularVelocity = angVel;
+
+		b2Body* body = this->body;
+		worldPhysics.runBetweenSteps(body, [body, angVel] { body->SetAngularVelocity(angVel); });
 	}
 	/**************************************************************************
 	*
@@ -109,7 +141,8 @@ public:
 	**************************************************************************/
 	void setAngularDamping(GLfloat damping)
 	{
-		body->SetAngularDamping(damping);
+		b2Body* body = this->body;
+		worldPhysics.runBetweenSteps(body, [body, damping] { body->SetAngularDamping(damping); });
 	}
 
 	/**************************************************************************
@@ -119,7 +152,8 @@ public:
 	**************************************************************************/
 	void setTorque(GLfloat torque)
 	{
-		body->ApplyTorque(torque);
+		b2Body* body = this->body;
+		worldPhysics.runBetweenSteps(body, [body, torque] { body->ApplyTorque(torque); });
 	}
 	/**************************************************************************
 	*
@@ -147,10 +181,17 @@ public:
 	**************************************************************************/
 	void translateBy(GLfloat x, GLfloat y)
 	{
-		b2Vec2 center = body->GetPosition();
-		center.x += x;
-		center.y += y;
-		body->SetTransform(center, 0.0);
+		snapshotPosition += b2Vec2(x, y);
+		snapshotAngle = 0.0f;
+
+		worldPhysics.runBetweenSteps(body, [this, x, y]
+		{
+			b2Vec2 center = body->GetPosition();
+			center.x += x;
+			center.y += y;
+			body->SetTransform(center, 0.0);
+			wakeBodies();
+		});
 	}
     
 	/**************************************************************************
@@ -161,18 +202,32 @@ public:
 	**************************************************************************/
 	void setPosition(GLfloat x, GLfloat y)
 	{
-		body->SetTransform(b2Vec2(x,y), 0.0);
+		snapshotPosition.Set(x, y);
+		snapshotAngle = 0.0f;
+
+		worldPhysics.runBetweenSteps(body, [this, x, y]
+		{
+			body->SetTransform(b2Vec2(x,y), 0.0);
+			wakeBodies();
+		});
 	}
     
     /** Offsets the current physical position
      */
     void offsetPosition (float xOffset, float yOffset)
     {
-        b2Vec2 pos = body->GetPosition();
-        pos.x += xOffset;
-        pos.y += yOffset;
-        
-        body->SetTransform(pos, 0.0);
+        snapshotPosition += b2Vec2 (xOffset, yOffset);
+        snapshotAngle = 0.0f;
+
+        worldPhysics.runBetweenSteps (body, [this, xOffset, yOffset]
+        {
+            b2Vec2 pos = body->GetPosition();
+            pos.x += xOffset;
+            pos.y += yOffset;
+
+            body->SetTransform (pos, 0.0);
+            wakeBodies();
+        });
     }
     
     /** Updates the scaling of the physics body based on the scaling of the
@@ -192,7 +247,13 @@ public:
 	**************************************************************************/
 	void rotate(float deg)
 	{
-		body->SetTransform(body->GetPosition(), (deg * DEGTORAD));
+		snapshotAngle = deg * DEGTORAD;
+
+		worldPhysics.runBetweenSteps(body, [this, deg]
+		{
+			body->SetTransform(body->GetPosition(), (deg * DEGTORAD));
+			wakeBodies();
+		});
 	}
 
 	/**************************************************************************
@@ -202,6 +263,9 @@ public:
 	**************************************************************************/
 	float getRotation()
 	{
+		if (worldPhysics.isStepInFlight())
+			return snapshotAngle * RADTODEG;
+
 		return body->GetAngle() * RADTODEG;
 	}
 
@@ -212,9 +276,41 @@ public:
 	**************************************************************************/
 	b2Vec2 GetPosition()
 	{
+		if (worldPhysics.isStepInFlight())
+			return snapshotPosition;
+
 		return body->GetPosition();
 	}
 
+	/**************************************************************************
+	*
+	*	copy the position, angle and velocity of the body into the snapshot
+	*	read while the next step runs. Called for every body once a step has
+	*	finished (see Level)
+	*
+	**************************************************************************/
+	void updateSnapshot()
+	{
+		snapshotPosition = body->GetPosition();
+		snapshotAngle = body->GetAngle();
+		snapshotVelocity = body->GetLinearVelocity();
+		snapshotAngularVelocity = body->GetAngularVelocity();
+	}
+
+	/**************************************************************************
+	*
+	*	set the snapshot to the state a bulk restore is putting the body
+	*	into (see LevelSnapshot), the restore moves the body itself
+	*
+	**************************************************************************/
+	void setSnapshot(b2Vec2 position, float32 angle, b2Vec2 velocity, float32 angularVelocity)
+	{
+		snapshotPosition = position;
+		snapshotAngle = angle;
+		snapshotVelocity = velocity;
+		snapshotAngularVelocity = angularVelocity;
+	}
+
 	/// FixtureDef Properties
 
 	/**************************************************************************
@@ -224,14 +320,18 @@ public:
 	*
 	**************************************************************************/
 	void setRestitution(float32 rest)
-	{b2Fixture* f = body->GetFixtureList();
-		f->SetRestitution(rest);
-		body->ResetMassData();
+	{
+		worldPhysics.runBetweenSteps(body, [this, rest]
+		{
+			myFixture->SetRestitution(rest);
+			body->ResetMassData();
+			wakeBodies();
+		});
 	}
 
 	float32 getRestitution()
 	{
-		b2Fixture* f = body->GetFixtureList();
+		b2Fixture* f = myFixture;
 		return f->GetRestitution();
 	}
 	/**************************************************************************
@@ -241,13 +341,16 @@ public:
 	**************************************************************************/
 	void setFriction(float32 fric)
 	{
-		b2Fixture* f = body->GetFixtureList();
-		f->SetFriction(fric);
-		body->ResetMassData();
+		worldPhysics.runBetweenSteps(body, [this, fric]
+		{
+			myFixture->SetFriction(fric);
+			body->ResetMassData();
+			wakeBodies();
+		});
 	}
 	float32 getFriction()
 	{
-		b2Fixture* f = body->GetFixtureList();
+		b2Fixture* f = myFixture;
 		return f->GetFriction();
 	}
 
@@ -258,13 +361,16 @@ public:
 	**************************************************************************/
 	void setDensity(float32 dens)
 	{
-		b2Fixture* f = body->GetFixtureList();
-		f->SetDensity(dens);
-		body->ResetMassData();
+		worldPhysics.runBetweenSteps(body, [this, dens]
+		{
+			myFixture->SetDensity(dens);
+			body->ResetMassData();
+			wakeBodies();
+		});
 	}
 	float32 getDensity()
 	{
-		b2Fixture* f = body->GetFixtureList();
+		b2Fixture* f = myFixture;
 		return f->GetDensity();
 	}
 	/**************************************************************************
@@ -275,12 +381,24 @@ public:
 	**************************************************************************/
 	void setForce(GLfloat x, GLfloat y)
 	{
-		body->ApplyForce(b2Vec2(x, y), body->GetWorldCenter());
+		b2Body* body = this->body;
+		worldPhysics.runBetweenSteps(body, [body, x, y] { body->ApplyForce(b2Vec2(x, y), body->GetWorldCenter()); });
 	}
 	b2Vec2 getLinearVel() 
 	{
+		if (worldPhysics.isStepInFlight())
+			return snapshotVelocity;
+
 		return body->GetLinearVelocity();
 	}
+
+	float32 getAngularVel()
+	{
+		if (worldPhysics.isStepInFlight())
+			return snapshotAngularVelocity;
+
+		return body->GetAngularVelocity();
+	}
 	/**************************************************************************
 	*
 	*	set an immediate Force to act on the body with respect to the x, y axis
@@ -289,55 +407,221 @@ public:
 	**************************************************************************/
 	void setImpulse(GLfloat x, GLfloat y)
 	{
-		body->ApplyLinearImpulse(b2Vec2(x, y), body->GetWorldCenter());
+		b2Body* body = this->body;
+		worldPhysics.runBetweenSteps(body, [body, x, y] { body->ApplyLinearImpulse(b2Vec2(x, y), body->GetWorldCenter()); });
 	}
 
-	/// b2Shape properties
+	/**************************************************************************
+	*
+	*	resize the collision box in place. The fixture keeps its contacts
+	*	and proxy, the shape is replaced and the proxy AABB refreshed,
+	*	rather than destroying and recreating the fixture
+	*
+	**************************************************************************/
 	void resizeCollisionBox(GLfloat width, GLfloat height)
 	{
-		dynamicBox.SetAsBox(width/2, height/2);
-		fixtureDef.shape = &dynamicBox;
-		body->DestroyFixture(this->myFixture);
+		worldPhysics.runBetweenSteps(body, [this, width, height]
+		{
+			dynamicBox.SetAsBox(width/2, height/2);
+			fixtureDef.shape = &dynamicBox;
 
-		this->myFixture = body->CreateFixture(&fixtureDef);
+			*((b2PolygonShape*) myFixture->GetShape()) = dynamicBox;
+			body->ResetMassData();
+
+			// SetTransform re-synchronizes the fixture's broadphase proxy with
+			// the new shape, inactive (deferred) bodies have no proxy to update
+			if (body->IsActive())
+				body->SetTransform(body->GetPosition(), body->GetAngle());
+
+			wakeBodies();
+		});
 	}
 
 	/// b2Shape properties
+
+	/**************************************************************************
+	*
+	*	give the body a circular trigger sensor, or resize the one it has.
+	*	The sensor only overlaps the player, and the player entering it is
+	*	reported as a sensor ContactEvent by the broadphase
+	*
+	**************************************************************************/
 	void setSensorRadius(GLfloat radius)
 	{
+		worldPhysics.runBetweenSteps(body, [this, radius]
+		{
+			triggerRangeSphere.m_radius = radius;
+			triggerRangeSphere.m_p.Set(0, 0);
 
-		triggerRangeSphere.m_radius = .9;
-		triggerRangeSphere.m_p.Set(0, 0);
-		triggerFixtureDef.shape = &triggerRangeSphere;
-		triggerFixtureDef.isSensor = true;
+			if (triggerFixture != nullptr)
+			{
+				// resize in place, the same way as the collision box
+				*((b2CircleShape*) triggerFixture->GetShape()) = triggerRangeSphere;
 
-		fixtureDef.shape = &triggerRangeSphere;
-		body->DestroyFixture(this->triggerFixture);
+				if (body->IsActive())
+					body->SetTransform(body->GetPosition(), body->GetAngle());
 
-		this->triggerFixture = body->CreateFixture(&fixtureDef);
+				return;
+			}
+
+			triggerFixtureDef.shape = &triggerRangeSphere;
+			triggerFixtureDef.isSensor = true;
+			triggerFixtureDef.density = 0.0f;
+			triggerFixtureDef.filter.categoryBits = TRIGGER;
+			triggerFixtureDef.filter.maskBits = PLAYER;
+
+			this->triggerFixture = body->CreateFixture(&triggerFixtureDef);
+		});
 	}
-    
-    /** Determines whether or not new Collisions are present in an object.
-        Returns true if new collisions have been added, returns false if not.
-     */
-    bool hasNewCollisions()
-    {
-        bool hasNewCollisions = false;
-        int curNumCollisions = 0;
-        for (b2ContactEdge* edge = body->GetContactList(); edge; edge = edge->next)
-        {
-            curNumCollisions += edge->contact->GetManifold()->pointCount;
-        }
-        
-        if (curNumCollisions > lastNumCollsions)
-            hasNewCollisions = true;
-        
-        lastNumCollsions = curNumCollisions;
-        
-        return hasNewCollisions;
-    }
+
+	b2Fixture* getSensorFixture()
+	{
+		return triggerFixture;
+	}
+
+	/**************************************************************************
+	*
+	*	set the collision filter of the collision box, see CollisionFiltering
+	*
+	**************************************************************************/
+	void setCollisionFilter(uint16 categoryBits, uint16 maskBits)
+	{
+		worldPhysics.runBetweenSteps(body, [this, categoryBits, maskBits]
+		{
+			b2Filter filter = myFixture->GetFilterData();
+			filter.categoryBits = categoryBits;
+			filter.maskBits = maskBits;
+			myFixture->SetFilterData(filter);
+			wakeBodies();
+		});
+	}
+
+	uint16 getCategoryBits()
+	{
+		return myFixture->GetFilterData().categoryBits;
+	}
+
+	uint16 getMaskBits()
+	{
+		return myFixture->GetFilterData().maskBits;
+	}
+
 	void setActiveStatus(bool active) {
-		body->SetActive(active);
+		activeRequested = active;
+
+		worldPhysics.runBetweenSteps(body, [this, active]
+		{
+			wakeBodies();
+			body->SetActive(active && collidable && !mergedIntoStaticGeometry && !deferredActivation);
+			wakeBodies();
+		});
+	}
+
+	/**************************************************************************
+	*
+	*	puts a body that was created with deferred activation into the
+	*	world, giving it broadphase proxies for the first time. Called once
+	*	per body at the end of a batched level build
+	*
+	**************************************************************************/
+	void finishDeferredActivation()
+	{
+		if (!deferredActivation)
+			return;
+
+		deferredActivation = false;
+		body->SetActive(activeRequested && collidable && !mergedIntoStaticGeometry);
+	}
+
+	/**************************************************************************
+	*
+	*	a body that is not collidable is kept out of the world entirely, for
+	*	objects that are only ever drawn (such as the kill plane marker)
+	*
+	**************************************************************************/
+	void setCollidable(bool isCollidable)
+	{
+		if (isCollidable == collidable)
+			return;
+
+		collidable = isCollidable;
+		setActiveStatus(activeRequested);
+	}
+
+	bool getCollidable()
+	{
+		return collidable;
+	}
+
+	/**************************************************************************
+	*
+	*	marks the body as merged into the level's StaticGeometry. A merged
+	*	body is kept out of the world (inactive) since the compound static
+	*	body collides in its place, and comes back when it is unmerged
+	*
+	**************************************************************************/
+	void setMergedIntoStaticGeometry(bool merged)
+	{
+		if (merged == mergedIntoStaticGeometry)
+			return;
+
+		mergedIntoStaticGeometry = merged;
+		setActiveStatus(activeRequested);
+	}
+
+	bool getMergedIntoStaticGeometry()
+	{
+		return mergedIntoStaticGeometry;
+	}
+
+	/**************************************************************************
+	*
+	*	get the world space bounding box of the collision box, this works
+	*	whether or not the body is currently in the world
+	*
+	**************************************************************************/
+	b2AABB getCollisionBounds()
+	{
+		b2AABB bounds;
+		myFixture->GetShape()->ComputeAABB(&bounds, body->GetTransform(), 0);
+		return bounds;
+	}
+
+	/**************************************************************************
+	*
+	*	allow or prevent the body from being put to sleep when it comes to
+	*	rest. Bodies that are driven every frame (the player, AI enemies)
+	*	should not sleep
+	*
+	**************************************************************************/
+	void setSleepingAllowed(bool allowed)
+	{
+		b2Body* body = this->body;
+		worldPhysics.runBetweenSteps(body, [body, allowed] { body->SetSleepingAllowed(allowed); });
+	}
+
+	bool getSleepingAllowed()
+	{
+		return body->IsSleepingAllowed();
+	}
+
+	bool isAwake()
+	{
+		return body->IsAwake();
+	}
+
+	/**************************************************************************
+	*
+	*	wake the body, every body it is in contact with and every body
+	*	overlapping it. A sleeping body only reacts to what happens inside
+	*	a Step, so any change made to a body from outside the step (moving
+	*	it in the editor, resizing it, changing its type) has to call this
+	*	or the bodies around it stay frozen in place
+	*
+	**************************************************************************/
+	void wakeUp()
+	{
+		worldPhysics.runBetweenSteps(body, [this] { wakeBodies(); });
 	}
 	b2Body* getBody() {
 		return body;
@@ -363,6 +647,14 @@ public:
 		typeTree.setProperty(Identifier("value"), var(typeInt), nullptr);
 		physicsTree.addChild(typeTree, -1, nullptr);
 
+		ValueTree categoryTree = ValueTree("CategoryBits");
+		categoryTree.setProperty(Identifier("value"), var((int) getCategoryBits()), nullptr);
+		physicsTree.addChild(categoryTree, -1, nullptr);
+
+		ValueTree maskTree = ValueTree("MaskBits");
+		maskTree.setProperty(Identifier("value"), var((int) getMaskBits()), nullptr);
+		physicsTree.addChild(maskTree, -1, nullptr);
+
 		return physicsTree;
 	}
 
@@ -381,6 +673,18 @@ public:
 			break;
 
 		}
+
+		// levels saved before collision filtering keep the default filter
+		// of the object's type
+		ValueTree categoryTree = valueTree.getChildWithName(Identifier("CategoryBits"));
+		ValueTree maskTree = valueTree.getChildWithName(Identifier("MaskBits"));
+
+		if (categoryTree.isValid() && maskTree.isValid())
+		{
+			int categoryBits = categoryTree.getProperty(Identifier("value"));
+			int maskBits = maskTree.getProperty(Identifier("value"));
+			setCollisionFilter((uint16) categoryBits, (uint16) maskBits);
+		}
 	}
 
     
@@ -395,37 +699,113 @@ public:
         return isStatic;
     }
     
+    /** Sets the listener told when the body is switched between static and
+        dynamic, there is at most one (the body's GameObject)
+     */
+    void setTypeListener (TypeListener * listener)
+    {
+        typeListener = listener;
+    }
+
     /** Sets whether or not the object is static or dynamic.
         True - static
         False - dynamic
      */
     void setIsStatic (bool isStatic)
     {
+        const bool changed = isStatic != this->isStatic;
         this->isStatic = isStatic;
-        
-        if (isStatic)
-        {
-            body->SetType(b2_staticBody);
-        }
-        else
+
+        if (changed && typeListener != nullptr)
+            typeListener->bodyTypeChanged();
+
+        worldPhysics.runBetweenSteps (body, [this, isStatic]
         {
-            body->SetType(b2_dynamicBody);
-        }
+            // changing type drops the body's contacts, wake what was resting on it
+            wakeBodies();
+            body->SetType (isStatic ? b2_staticBody : b2_dynamicBody);
+            wakeBodies();
+        });
     }
     
 private:
+	/** Wakes the body and the bodies around it, see wakeUp(). Only called
+		between steps */
+	void wakeBodies()
+	{
+		if (body->GetType() != b2_staticBody)
+			body->SetAwake(true);
+
+		// bodies it was touching before the change
+		for (b2ContactEdge* edge = body->GetContactList(); edge; edge = edge->next)
+		{
+			edge->other->SetAwake(true);
+		}
+
+		if (!body->IsActive())
+			return;
+
+		// bodies it overlaps after the change
+		b2Fixture* fixture = body->GetFixtureList();
+		if (fixture == nullptr)
+			return;
+
+		b2AABB area = fixture->GetAABB(0);
+		for (fixture = fixture->GetNext(); fixture; fixture = fixture->GetNext())
+		{
+			area.Combine(fixture->GetAABB(0));
+		}
+
+		WakeQueryCallback wakeCallback;
+		body->GetWorld()->QueryAABB(&wakeCallback, area);
+	}
+
+	/** Wakes every non-static body reported by a world AABB query */
+	class WakeQueryCallback : public b2QueryCallback
+	{
+	public:
+		bool ReportFixture(b2Fixture* fixture) override
+		{
+			b2Body* other = fixture->GetBody();
+			if (other->GetType() != b2_staticBody)
+				other->SetAwake(true);
+
+			return true;
+		}
+	};
+
+	/** The world the body belongs to */
+	WorldPhysics& worldPhysics;
+
+	/** State of the body after the last step, read while a step runs */
+	b2Vec2 snapshotPosition;
+	float32 snapshotAngle;
+	b2Vec2 snapshotVelocity;
+	float32 snapshotAngularVelocity;
+
 	const float RADTODEG = 57.29577951308f;
 	const float DEGTORAD = 0.017453292519f;
 	const float PI = 3.14159f;
  
     /** Specifies whether or not the object is affected by physics, or is unmoveable (static) */
-    bool isStatic;
-    
-    /** The number of collisions that were last checked. */
-    int lastNumCollsions = 0;
+    bool isStatic = true;
+
+    /** Told when the body is switched between static and dynamic */
+    TypeListener * typeListener = nullptr;
     
-    /** Any new collisions have been reported. */
-    bool reportedNewCollsions = false;
+    /** The active state that was last asked for, the body itself may be kept
+        inactive while it is merged into the level's StaticGeometry */
+    bool activeRequested = true;
+
+    /** Whether the body takes part in the physics world at all */
+    bool collidable = true;
+
+    /** Whether the fixture has been merged into a compound static body */
+    bool mergedIntoStaticGeometry = false;
+
+    /** Whether the body is being held out of the world until the batched
+        level build it is part of has finished */
+    bool deferredActivation = false;
 
 	//object within the physics world
 	b2Body* body;
@@ -437,7 +817,7 @@ private:
 	b2PolygonShape dynamicBox;
 
 	//Trigger range sensor
-	b2Fixture* triggerFixture;
+	b2Fixture* triggerFixture = nullptr;
 	b2FixtureDef triggerFixtureDef;
 	b2CircleShape triggerRangeSphere;
 };
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/** Keeps a rolling window of samples for a single measurement and reports the
+    minimum, average and maximum over that window.
+ */
+class RollingStatistic
+{
+public:
+    RollingStatistic()
+    {
+        reset();
+    }
+
+    /** Removes every sample from the window */
+    void reset()
+    {
+        numSamples = 0;
+        nextSample = 0;
+        sum = 0.0;
+
+        for (int i = 0; i < WINDOW_SIZE; i++)
+            samples[i] = 0.0f;
+    }
+
+    /** Adds a sample, replacing the oldest sample once the window is full */
+    void addSample (float sample)
+    {
+        if (numSamples == WINDOW_SIZE)
+            sum -= samples[nextSample];
+        else
+            numSamples++;
+
+        samples[nextSample] = sample;
+        sum += sample;
+        nextSample = (nextSample + 1) % WINDOW_SIZE;
+    }
+
+    float getLast() const
+    {
+        if (numSamples == 0)
+            return 0.0f;
+
+        return samples[(nextSample + WINDOW_SIZE - 1) % WINDOW_SIZE];
+    }
+
+    float getMin() const
+    {
+        if (numSamples == 0)
+            return 0.0f;
+
+        float minSample = samples[0];
+        for (int i = 1; i < numSamples; i++)
+            minSample = jmin (minSample, samples[i]);
+
+        return minSample;
+    }
+
+    float getAverage() const
+    {
+        if (numSamples == 0)
+            return 0.0f;
+
+        return (float) (sum / numSamples);
+    }
+
+    float getMax() const
+    {
+        if (numSamples == 0)
+            return 0.0f;
+
+        float maxSample = samples[0];
+        for (int i = 1; i < numSamples; i++)
+            maxSample = jmax (maxSample, samples[i]);
+
+        return maxSample;
+    }
+
+    int getNumSamples() const
+    {
+        return numSamples;
+    }
+
+    /** Formats the statistic as "avg (min - max)" */
+    String toString (int numDecimalPlaces = 3) const
+    {
+        return String (getAverage(), numDecimalPlaces)
+             + " (" + String (getMin(), numDecimalPlaces)
+             + " - " + String (getMax(), numDecimalPlaces) + ")";
+    }
+
+    /** Number of steps the statistics are rolled over (2 seconds at 1/30 s) */
+    static const int WINDOW_SIZE = 60;
+
+private:
+    float samples[WINDOW_SIZE];
+    int numSamples;
+    int nextSample;
+    double sum;
+};
+
+/** Collects the b2Profile timings that b2World fills in on every Step, along
+    with the body, contact and broadphase counts of the world, so the physics
+    cost of a level can be inspected without attaching a profiler.
+
+    The timings are copied every step. The counts walk the bodies and the
+    broadphase tree, so they are only sampled every countInterval steps.
+ */
+class PhysicsStatistics
+{
+public:
+    PhysicsStatistics()
+    {
+        reset();
+    }
+
+    /** The b2Profile timings, all in milliseconds */
+    enum ProfileTiming
+    {
+        step = 0,
+        collide,
+        solve,
+        solveInit,
+        solveVelocity,
+        solvePosition,
+        broadphase,
+        solveTOI,
+        numProfileTimings
+    };
+
+    /** The world counters, sampled every countInterval steps */
+    enum WorldCount
+    {
+        bodies = 0,
+        awakeBodies,
+        contacts,
+        proxies,
+        treeHeight,
+        treeBalance,
+        treeQuality,
+        numWorldCounts
+    };
+
+    void reset()
+    {
+        for (auto & timing : timings)
+            timing.reset();
+
+        for (auto & count : counts)
+            count.reset();
+
+        numSteps = 0;
+    }
+
+    /** Samples the profile, and every countInterval steps the counters, of
+        a world that has just stepped. Called by WorldPhysics after every
+        b2World::Step.
+     */
+    void addStep (b2World & world)
+    {
+        const b2Profile & profile = world.GetProfile();
+
+        timings[step].addSample (profile.step);
+        timings[collide].addSample (profile.collide);
+        timings[solve].addSample (profile.solve);
+        timings[solveInit].addSample (profile.solveInit);
+        timings[solveVelocity].addSample (profile.solveVelocity);
+        timings[solvePosition].addSample (profile.solvePosition);
+        timings[broadphase].addSample (profile.broadphase);
+        timings[solveTOI].addSample (profile.solveTOI);
+
+        if (numSteps++ % countInterval == 0)
+            addCounts (world);
+    }
+
+    const RollingStatistic & getTiming (ProfileTiming timing) const
+    {
+        return timings[timing];
+    }
+
+    const RollingStatistic & getCount (WorldCount count) const
+    {
+        return counts[count];
+    }
+
+    /** Total number of steps sampled since the last reset */
+    int64 getNumSteps() const
+    {
+        return numSteps;
+    }
+
+    /** Builds a one line summary of the average timings and the latest
+        counts, for the profiling line of the HUD
+     */
+    String getSummary() const
+    {
+        return "physics " + String (timings[step].getAverage(), 2) + " ms"
+             + " (collide " + String (timings[collide].getAverage(), 2)
+             + ", solve " + String (timings[solve].getAverage(), 2)
+             + ", broadphase " + String (timings[broadphase].getAverage(), 2)
+             + ", toi " + String (timings[solveTOI].getAverage(), 2) + ") | "
+             + String ((int) counts[bodies].getLast()) + " bodies, "
+             + String ((int) counts[awakeBodies].getLast()) + " awake, "
+             + String ((int) counts[contacts].getLast()) + " contacts, tree height "
+             + String ((int) counts[treeHeight].getLast());
+    }
+
+    /** Steps between samples of the world counts, once a second at 1/30 s */
+    static const int countInterval = 30;
+
+    /** Builds a multi-line summary of the rolling statistics, one line per
+        measurement, for logging.
+     */
+    String toString() const
+    {
+        static const char * const timingNames[numProfileTimings] =
+            { "step", "collide", "solve", "solveInit", "solveVelocity",
+              "solvePosition", "broadphase", "solveTOI" };
+
+        static const char * const countNames[numWorldCounts] =
+            { "bodies", "awakeBodies", "contacts", "proxies",
+              "treeHeight", "treeBalance", "treeQuality" };
+
+        String summary = "Physics over " + String (timings[step].getNumSamples()) + " steps, avg (min - max)\n";
+
+        for (int i = 0; i < numProfileTimings; i++)
+            summary += "  " + String (timingNames[i]) + " ms: " + timings[i].toString() + "\n";
+
+        for (int i = 0; i < numWorldCounts; i++)
+            summary += "  " + String (countNames[i]) + ": " + counts[i].toString (1) + "\n";
+
+        return summary;
+    }
+
+private:
+    void addCounts (b2World & world)
+    {
+        int numAwake = 0;
+        for (b2Body * body = world.GetBodyList(); body; body = body->GetNext())
+        {
+            if (body->GetType() != b2_staticBody && body->IsAwake() && body->IsActive())
+                numAwake++;
+        }
+
+        counts[bodies].addSample ((float) world.GetBodyCount());
+        counts[awakeBodies].addSample ((float) numAwake);
+        counts[contacts].addSample ((float) world.GetContactCount());
+        counts[proxies].addSample ((float) world.GetProxyCount());
+        counts[treeHeight].addSample ((float) world.GetTreeHeight());
+        counts[treeBalance].addSample ((float) world.GetTreeBalance());
+        counts[treeQuality].addSample (world.GetTreeQuality());
+    }
+
+    RollingStatistic timings[numProfileTimings];
+    RollingStatistic counts[numWorldCounts];
+    int64 numSteps;
+
+    JUCE_LEAK_DETECTOR(PhysicsStatistics)
+};
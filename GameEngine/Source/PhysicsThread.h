@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Level.h"
+
+/** Steps the physics world of a Level on its own thread, so the step for the
+    next frame runs while the GameLogic processes the results of the last one.
+
+    The GameLogic collects a step with finishStep(), which applies every body
+    command gameplay queued while it ran, then starts the next step with
+    startStep() and carries on with AI, input and rendering. While a step is
+    running, gameplay reads the PhysicsProperties snapshots and its changes
+    to bodies are recorded in the world's command buffer (see WorldPhysics).
+ */
+class PhysicsThread : public Thread
+{
+public:
+    PhysicsThread() : Thread ("Physics")
+    {
+        steppingLevel = nullptr;
+        stepTime = 0.0f;
+    }
+
+    ~PhysicsThread()
+    {
+        stop();
+    }
+
+    /** Starts stepping the world of a level on the physics thread, for a
+        frame time in seconds. The level's world must not be touched
+        directly until finishStep().
+     */
+    void startStep (Level & level, float32 frameTime)
+    {
+        const ScopedLock lock (stepLock);
+
+        // A step must be collected before the next is started
+        jassert (steppingLevel == nullptr);
+
+        level.prepareWorldPhysics();
+
+        steppingLevel = &level;
+        stepTime = frameTime;
+        level.getWorldPhysics().beginAsyncStep();
+
+        stepWaitable.signal();
+    }
+
+    /** Waits for the running step to finish and applies the commands that
+        were recorded during it.
+
+        @return the level that was stepped, or nullptr if no step was running
+     */
+    Level * finishStep()
+    {
+        const ScopedLock lock (stepLock);
+
+        if (steppingLevel == nullptr)
+            return nullptr;
+
+        stepDoneWaitable.wait();
+
+        Level * steppedLevel = steppingLevel;
+        steppingLevel = nullptr;
+        steppedLevel->getWorldPhysics().endAsyncStep();
+
+        return steppedLevel;
+    }
+
+    /** Collects any running step and stops the thread */
+    void stop()
+    {
+        finishStep();
+
+        signalThreadShouldExit();
+        stepWaitable.signal();
+        stopThread (500);
+    }
+
+private:
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            stepWaitable.wait();
+
+            if (threadShouldExit())
+                break;
+
+            steppingLevel->stepWorldPhysics (stepTime);
+
+            stepDoneWaitable.signal();
+        }
+    }
+
+    /** The level being stepped, nullptr while no step is running */
+    Level * steppingLevel;
+    float32 stepTime;
+
+    /** Signaled by the GameLogic to start a step */
+    WaitableEvent stepWaitable;
+
+    /** Signaled by the physics thread when the step is done */
+    WaitableEvent stepDoneWaitable;
+
+    /** Serializes starting and collecting steps with stop() */
+    CriticalSection stepLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhysicsThread)
+};
@@ -9,10 +9,13 @@ public:
 	PlayerObject(WorldPhysics & worldPhysics, Model* model) : GameObject(worldPhysics, model)
 	{
 		setName("Player");
-		objType = GameObjectType::Player;
+		setObjType(GameObjectType::Player);
 		setMoveSpeed(Speed::SLOW);
 		setJumpSpeed(Speed::SLOW);
         getPhysicsProperties().setIsStatic(false);
+
+        // The player is driven by input every frame and must never be put to sleep
+        getPhysicsProperties().setSleepingAllowed(false);
 	}
 
 	PlayerObject(WorldPhysics & worldPhysics, Model* model, ValueTree valueTree) : GameObject(worldPhysics, model, valueTree)
@@ -25,6 +28,7 @@ public:
 
 		parseFrom(valueTree);
 
+		getPhysicsProperties().setSleepingAllowed(false);
 	}
 
 	~PlayerObject(){}
@@ -2,7 +2,6 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "glm/glm.hpp"
-#include <map>
 
 /** Represents a single renderable frame that is send to GameView to render.
     It includes all data needed to render a frame in OpenGL.
@@ -32,29 +31,32 @@ public:
         return viewMatrix;
     }
 
-	void setAttribute(String key, var value) {
-		attrs[key] = value;
+	/** The score and lives reach the HUD as GameEvents, the frame only
+		carries what the HUD draws that is not gameplay
+	*/
+	void setPlayerLifeTexture(const File & texture) {
+		if (texture != playerLifeTexture)
+			playerLifeTexture = texture;
 	}
 
-	var* getAttribute(String key) {
-		std::map<String, var>::iterator it;
-
-		it = attrs.find(key);
-		if (it != attrs.end()) {
-			return &attrs[key];
-		}
+	const File & getPlayerLifeTexture() {
+		return playerLifeTexture;
+	}
 
-		return nullptr;
+	/** The physics profile line the HUD shows with the frame rate */
+	void setPhysicsProfile(const String & profile) {
+		physicsProfile = profile;
 	}
 
-	map<String, var> getAttributes() {
-		return attrs;
+	const String & getPhysicsProfile() {
+		return physicsProfile;
 	}
 
 private:
     vector<RenderableObject> renderableObjects;
     glm::mat4 viewMatrix;
-	map<String, var> attrs;
+	File playerLifeTexture;
+	String physicsProfile;
     
 	JUCE_LEAK_DETECTOR(RenderSwapFrame)
 };
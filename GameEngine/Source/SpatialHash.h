@@ -0,0 +1,159 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "glm/glm.hpp"
+#include "WorldGrid.h"
+#include <unordered_map>
+#include <vector>
+
+/** A uniform spatial hash of entity positions, for gameplay queries of what
+    is near a point, such as the enemies around a player.
+
+    The space is split into the cells of a WorldGrid several editor units
+    long, and each cell that has entities in it keeps the indices of those
+    entities. Moving an entity only touches the hash when it crosses into
+    another cell, so keeping the moving objects up to date costs a compare
+    per object per step. Cells are kept once used, so after the first few
+    steps inserting, moving and querying do not allocate.
+ */
+class SpatialHash
+{
+public:
+    SpatialHash()
+    {
+        grid.setGridUnitLength (8.0f);
+    }
+
+    /** Sets the length of a cell, which should be about the radius of the
+        usual query. Empties the hash.
+     */
+    void setCellLength (float length)
+    {
+        grid.setGridUnitLength (length);
+        clear();
+    }
+
+    float getCellLength()
+    {
+        return grid.getUnitLength();
+    }
+
+    /** Removes every entity, keeping the cells for reuse */
+    void clear()
+    {
+        for (auto & cell : cells)
+            cell.second.clear();
+
+        entityCells.clear();
+        inHash.clear();
+    }
+
+    /** Adds an entity at a position, or moves it there if it is already in
+        the hash
+     */
+    void insert (int entity, float x, float y)
+    {
+        if (entity >= (int) entityCells.size())
+        {
+            entityCells.resize (entity + 1, 0);
+            inHash.resize (entity + 1, 0);
+        }
+
+        const uint64 key = getKey (grid.getCellIndex (x), grid.getCellIndex (y));
+
+        if (inHash[entity])
+        {
+            if (entityCells[entity] == key)
+                return;
+
+            removeFromCell (entity, entityCells[entity]);
+        }
+
+        cells[key].push_back (entity);
+        entityCells[entity] = key;
+        inHash[entity] = 1;
+    }
+
+    /** Updates the cell of an entity that may have moved, does nothing if it
+        is not in the hash
+     */
+    void move (int entity, float x, float y)
+    {
+        if (contains (entity))
+            insert (entity, x, y);
+    }
+
+    void remove (int entity)
+    {
+        if (!contains (entity))
+            return;
+
+        removeFromCell (entity, entityCells[entity]);
+        inHash[entity] = 0;
+    }
+
+    bool contains (int entity) const
+    {
+        return entity >= 0 && entity < (int) inHash.size() && inHash[entity] != 0;
+    }
+
+    /** Calls visitor (entity) for every entity in the cells that overlap a
+        box. The entities are only as near as their cell, the caller checks
+        their positions.
+     */
+    template <typename Visitor>
+    void forEachInBox (float minX, float minY, float maxX, float maxY, Visitor && visitor)
+    {
+        const int minCellX = grid.getCellIndex (minX);
+        const int minCellY = grid.getCellIndex (minY);
+        const int maxCellX = grid.getCellIndex (maxX);
+        const int maxCellY = grid.getCellIndex (maxY);
+
+        for (int cellX = minCellX; cellX <= maxCellX; cellX++)
+        {
+            for (int cellY = minCellY; cellY <= maxCellY; cellY++)
+            {
+                auto cell = cells.find (getKey (cellX, cellY));
+
+                if (cell == cells.end())
+                    continue;
+
+                for (auto entity : cell->second)
+                    visitor (entity);
+            }
+        }
+    }
+
+private:
+    static uint64 getKey (int cellX, int cellY)
+    {
+        return ((uint64) (uint32) cellX << 32) | (uint64) (uint32) cellY;
+    }
+
+    void removeFromCell (int entity, uint64 key)
+    {
+        std::vector<int> & cell = cells[key];
+
+        for (size_t i = 0; i < cell.size(); i++)
+        {
+            if (cell[i] == entity)
+            {
+                cell[i] = cell.back();
+                cell.pop_back();
+                return;
+            }
+        }
+    }
+
+    WorldGrid grid;
+    std::unordered_map<uint64, std::vector<int>> cells;
+
+    /** The key of the cell each entity is in, by entity index. Every key is
+        a cell, cell (-1, -1) included, so whether an entity is in the hash
+        is kept apart.
+     */
+    std::vector<uint64> entityCells;
+    std::vector<uint8> inHash;
+
+    JUCE_LEAK_DETECTOR(SpatialHash)
+};
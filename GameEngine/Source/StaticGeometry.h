@@ -0,0 +1,278 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObject.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/** Collapses the static blocks of a Level into a single compound static body.
+
+    Every block placed in the editor owns its own b2Body, fixture and
+    broadphase proxy. Once the level is built, neighbouring static boxes are
+    merged into as few large rectangles as possible and attached as fixtures
+    of one static body, while the individual block bodies are taken out of
+    the world. This cuts the proxy count and tree depth of the broadphase,
+    and removes the seams between tiles that a sliding body can catch on.
+
+    Only unrotated, active, collidable, static Generic blocks without
+    collision audio are merged, everything else keeps its own body. Blocks
+    are only joined with blocks of the same surface and collision filter,
+    and each merged rectangle keeps that filter.
+ */
+class StaticGeometry
+{
+public:
+    StaticGeometry (b2World & world) : world (world)
+    {
+        compoundBody = nullptr;
+        numMergedBlocks = 0;
+    }
+
+    ~StaticGeometry()
+    {
+        // The compound body is owned by the b2World, like every other body
+    }
+
+    /** Merges the static blocks of a set of GameObjects, replacing whatever
+        was merged by the last rebuild.
+     */
+    void rebuild (const OwnedArray<GameObject> & gameObjects)
+    {
+        clear();
+
+        std::vector<Box> boxes;
+
+        for (auto object : gameObjects)
+        {
+            PhysicsProperties & physics = object->getPhysicsProperties();
+
+            if (!canMerge (*object))
+                continue;
+
+            b2AABB bounds = physics.getCollisionBounds();
+
+            // Polygon bounds include the skin radius, remove it so the
+            // merged box is the same size as the blocks it replaces
+            Box box;
+            box.left = bounds.lowerBound.x + b2_polygonRadius;
+            box.bottom = bounds.lowerBound.y + b2_polygonRadius;
+            box.right = bounds.upperBound.x - b2_polygonRadius;
+            box.top = bounds.upperBound.y - b2_polygonRadius;
+            box.friction = physics.getFriction();
+            box.restitution = physics.getRestitution();
+            box.categoryBits = physics.getCategoryBits();
+            box.maskBits = physics.getMaskBits();
+            boxes.push_back (box);
+
+            physics.setMergedIntoStaticGeometry (true);
+            mergedObjects.add (object);
+        }
+
+        numMergedBlocks = (int) boxes.size();
+
+        if (boxes.empty())
+            return;
+
+        // Merge runs of boxes along each row, then stack rows of equal width
+        mergeRows (boxes);
+        mergeColumns (boxes);
+
+        b2BodyDef bodyDef;
+        bodyDef.type = b2_staticBody;
+        compoundBody = world.CreateBody (&bodyDef);
+
+        for (auto & box : boxes)
+        {
+            b2PolygonShape shape;
+            shape.SetAsBox ((box.right - box.left) / 2.0f, (box.top - box.bottom) / 2.0f,
+                            b2Vec2 ((box.left + box.right) / 2.0f, (box.bottom + box.top) / 2.0f), 0.0f);
+
+            b2FixtureDef fixtureDef;
+            fixtureDef.shape = &shape;
+            fixtureDef.friction = box.friction;
+            fixtureDef.restitution = box.restitution;
+            fixtureDef.density = 0.0f;
+            fixtureDef.filter.categoryBits = box.categoryBits;
+            fixtureDef.filter.maskBits = box.maskBits;
+
+            compoundBody->CreateFixture (&fixtureDef);
+        }
+
+        // Anything resting on the old block bodies lost its contacts
+        wakeBodiesOnCompound();
+    }
+
+    /** Removes the compound body and puts every merged block back into the
+        world with its own body.
+     */
+    void clear()
+    {
+        if (compoundBody != nullptr)
+        {
+            wakeBodiesOnCompound();
+            world.DestroyBody (compoundBody);
+            compoundBody = nullptr;
+        }
+
+        for (auto object : mergedObjects)
+            object->getPhysicsProperties().setMergedIntoStaticGeometry (false);
+
+        mergedObjects.clear();
+        numMergedBlocks = 0;
+    }
+
+    /** Must be called before a merged GameObject is deleted so the geometry
+        never holds on to a deleted object.
+     */
+    void objectRemoved (GameObject * object)
+    {
+        mergedObjects.removeFirstMatchingValue (object);
+    }
+
+    /** Number of blocks whose bodies were replaced by the compound body */
+    int getNumMergedBlocks()
+    {
+        return numMergedBlocks;
+    }
+
+    /** Number of fixtures (merged rectangles) on the compound body */
+    int getNumFixtures()
+    {
+        int numFixtures = 0;
+
+        if (compoundBody != nullptr)
+        {
+            for (b2Fixture * fixture = compoundBody->GetFixtureList(); fixture; fixture = fixture->GetNext())
+                numFixtures++;
+        }
+
+        return numFixtures;
+    }
+
+private:
+    /** An axis aligned rectangle in world coordinates, with the surface
+        properties and collision filter that must match for two rectangles
+        to be merged.
+     */
+    struct Box
+    {
+        float left, bottom, right, top;
+        float friction, restitution;
+        uint16 categoryBits, maskBits;
+    };
+
+    /** How far apart two edges can be and still count as touching */
+    static constexpr float EDGE_TOLERANCE = 0.001f;
+
+    static bool nearlyEqual (float a, float b)
+    {
+        return std::abs (a - b) <= EDGE_TOLERANCE;
+    }
+
+    static bool sameSurface (const Box & a, const Box & b)
+    {
+        return a.friction == b.friction && a.restitution == b.restitution
+            && a.categoryBits == b.categoryBits && a.maskBits == b.maskBits;
+    }
+
+    bool canMerge (GameObject & object)
+    {
+        PhysicsProperties & physics = object.getPhysicsProperties();
+
+        return object.getObjType() == GameObjectType::Generic
+            && object.getIsActive()
+            && physics.getCollidable()
+            && physics.getIsStatic()
+            && physics.getRotation() == 0.0f
+            && object.getAudioFileForAction (PhysicalAction::collsion) == nullptr;
+    }
+
+    /** Joins boxes that share a bottom and top edge and touch or overlap
+        horizontally.
+     */
+    static void mergeRows (std::vector<Box> & boxes)
+    {
+        std::sort (boxes.begin(), boxes.end(), [] (const Box & a, const Box & b)
+        {
+            if (a.bottom != b.bottom) return a.bottom < b.bottom;
+            if (a.top != b.top)       return a.top < b.top;
+            return a.left < b.left;
+        });
+
+        mergeSorted (boxes, [] (const Box & current, const Box & next)
+        {
+            return nearlyEqual (current.bottom, next.bottom)
+                && nearlyEqual (current.top, next.top)
+                && next.left <= current.right + EDGE_TOLERANCE;
+        });
+    }
+
+    /** Joins boxes that share a left and right edge and touch or overlap
+        vertically.
+     */
+    static void mergeColumns (std::vector<Box> & boxes)
+    {
+        std::sort (boxes.begin(), boxes.end(), [] (const Box & a, const Box & b)
+        {
+            if (a.left != b.left)   return a.left < b.left;
+            if (a.right != b.right) return a.right < b.right;
+            return a.bottom < b.bottom;
+        });
+
+        mergeSorted (boxes, [] (const Box & current, const Box & next)
+        {
+            return nearlyEqual (current.left, next.left)
+                && nearlyEqual (current.right, next.right)
+                && next.bottom <= current.top + EDGE_TOLERANCE;
+        });
+    }
+
+    /** Walks a sorted list, growing the current box over every following box
+        it can be joined with.
+     */
+    template <typename CanJoin>
+    static void mergeSorted (std::vector<Box> & boxes, CanJoin canJoin)
+    {
+        std::vector<Box> merged;
+
+        for (auto & box : boxes)
+        {
+            if (!merged.empty() && sameSurface (merged.back(), box) && canJoin (merged.back(), box))
+            {
+                Box & current = merged.back();
+                current.left = jmin (current.left, box.left);
+                current.bottom = jmin (current.bottom, box.bottom);
+                current.right = jmax (current.right, box.right);
+                current.top = jmax (current.top, box.top);
+            }
+            else
+            {
+                merged.push_back (box);
+            }
+        }
+
+        boxes.swap (merged);
+    }
+
+    void wakeBodiesOnCompound()
+    {
+        if (compoundBody == nullptr)
+            return;
+
+        for (b2ContactEdge * edge = compoundBody->GetContactList(); edge; edge = edge->next)
+            edge->other->SetAwake (true);
+    }
+
+    b2World & world;
+
+    /** Static body holding one fixture per merged rectangle */
+    b2Body * compoundBody;
+
+    /** The GameObjects whose bodies are currently merged */
+    Array<GameObject *> mergedObjects;
+
+    int numMergedBlocks;
+
+    JUCE_LEAK_DETECTOR(StaticGeometry)
+};
@@ -3,6 +3,8 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include <map>
 #include "TextureResource.h"
+#include "AnimationClip.h"
+#include <vector>
 
 class TextureResourceManager {
 
@@ -40,6 +42,25 @@ public:
 		return tex->getTexture();
 	}
 
+	//Loads the texture of a TextureRegistry id. Once loaded it is found by index
+	//rather than by comparing paths, so drawing an object allocates nothing
+	OpenGLTexture* loadTexture(int textureId) {
+
+		if (isPositiveAndBelow(textureId, (int)texturesById.size()) && texturesById[(size_t)textureId] != nullptr) {
+			return texturesById[(size_t)textureId];
+		}
+
+		OpenGLTexture* tex = loadTexture(TextureRegistry::getInstance().getFile(textureId));
+
+		if (textureId >= (int)texturesById.size()) {
+			texturesById.resize((size_t)textureId + 1, nullptr);
+		}
+
+		texturesById[(size_t)textureId] = tex;
+
+		return tex;
+	}
+
 	void releaseTextures() {
 		for (auto iterator = resourceMap.begin(); iterator != resourceMap.end(); ++iterator)
 		{
@@ -51,12 +72,16 @@ public:
         // in these resources and not just textures? We wouldn't want releaseTextures
         // to get rid of audio too.
 		resourceMap.clear();
+		texturesById.clear();
 	}
 
 private:
 
 	std::map<File, Resource*> resourceMap;
 
+	// The textures of resourceMap by TextureRegistry id
+	std::vector<OpenGLTexture*> texturesById;
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TextureResourceManager)
 
 
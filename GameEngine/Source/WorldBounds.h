@@ -0,0 +1,146 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GameObject.h"
+#include "GameObjectType.h"
+#include "EntityStore.h"
+#include <cfloat>
+#include <functional>
+#include <vector>
+
+/** The bounds of a Level's world: a kill plane below which objects are out
+    of the level, and optional limits to the left, right and top.
+
+    The bounds have no physics body. After each physics step the positions of
+    the active dynamic bodies are taken from the level's EntityStore and
+    tested against the bounds in one branch-free loop, then the callback
+    registered for each out of bounds object's GameObjectType is called.
+    Inactive and pooled objects are not in the store's bodies, so they are
+    never visited.
+ */
+class WorldBounds
+{
+public:
+    typedef std::function<void (GameObject &)> OutOfBoundsCallback;
+
+    WorldBounds()
+    {
+        // Matches the old killing floor: a player more than 1.5 units above
+        // a floor at y = -9 was still alive
+        killPlaneY = -7.5f;
+        minX = -FLT_MAX;
+        maxX = FLT_MAX;
+        maxY = FLT_MAX;
+    }
+
+    /** Sets the height below which objects are out of the world */
+    void setKillPlane (float y)
+    {
+        killPlaneY = y;
+    }
+
+    float getKillPlane()
+    {
+        return killPlaneY;
+    }
+
+    /** Sets the horizontal limits of the world, unlimited by default */
+    void setHorizontalLimits (float left, float right)
+    {
+        minX = left;
+        maxX = right;
+    }
+
+    /** Sets the height above which objects are out of the world, unlimited
+        by default
+     */
+    void setCeiling (float y)
+    {
+        maxY = y;
+    }
+
+    /** Sets the function called for an object of a given type that has left
+        the world. Types without a callback are tested but ignored.
+     */
+    void setCallback (GameObjectType type, OutOfBoundsCallback callback)
+    {
+        callbacks[type] = callback;
+    }
+
+    /** Tests every active, dynamic body against the bounds and calls the
+        callback of each object that is out of them. The bodies must have
+        been synced with the last step.
+     */
+    void check (const EntityStore & entities)
+    {
+        const int numCandidates = entities.getNumBodies();
+        xs.resize (numCandidates);
+        ys.resize (numCandidates);
+        outside.resize (numCandidates);
+
+        for (int i = 0; i < numCandidates; i++)
+        {
+            xs[i] = entities.getBodyX (i);
+            ys[i] = entities.getBodyY (i);
+        }
+
+        // Branch-free over flat arrays so the compiler can vectorize it
+        const float * x = xs.data();
+        const float * y = ys.data();
+        unsigned char * out = outside.data();
+
+        for (int i = 0; i < numCandidates; i++)
+            out[i] = (y[i] < killPlaneY) | (y[i] > maxY) | (x[i] < minX) | (x[i] > maxX);
+
+        for (int i = 0; i < numCandidates; i++)
+        {
+            if (out[i] == 0)
+                continue;
+
+            GameObject * object = entities.getBodyObject (i);
+
+            if (object->getObjType() == Bounds)
+                continue;
+
+            OutOfBoundsCallback & callback = callbacks[object->getObjType()];
+
+            if (callback)
+                callback (*object);
+        }
+    }
+
+    ValueTree serializeToValueTree()
+    {
+        ValueTree boundsTree = ValueTree ("WorldBounds");
+
+        ValueTree killPlaneTree = ValueTree ("KillPlane");
+        killPlaneTree.setProperty (Identifier ("value"), var (killPlaneY), nullptr);
+        boundsTree.addChild (killPlaneTree, -1, nullptr);
+
+        return boundsTree;
+    }
+
+    /** Restores the bounds, keeping the defaults for levels saved before
+        the bounds were serialized
+     */
+    void parseFrom (ValueTree boundsTree)
+    {
+        ValueTree killPlaneTree = boundsTree.getChildWithName (Identifier ("KillPlane"));
+
+        if (killPlaneTree.isValid())
+            killPlaneY = killPlaneTree.getProperty (Identifier ("value"));
+    }
+
+private:
+    float killPlaneY;
+    float minX, maxX, maxY;
+
+    /** Callback for each GameObjectType */
+    OutOfBoundsCallback callbacks[Bounds + 1];
+
+    /** Scratch arrays reused by every check */
+    std::vector<float> xs, ys;
+    std::vector<unsigned char> outside;
+
+    JUCE_LEAK_DETECTOR(WorldBounds)
+};
@@ -34,6 +34,22 @@ public:
                          roundToClosestGridUnit(ungriddedPosition.y));
     }
     
+    /** Returns the index of the grid unit closest to a distance along an
+        axis, the one getGriddedPosition() would put it on
+     */
+    int getClosestGridUnitIndex (float distance)
+    {
+        return (int) round(distance / unitLength);
+    }
+    
+    /** Returns the index of the grid cell a distance along an axis falls in,
+        each cell being a unit long with cell 0 starting at the origin
+     */
+    int getCellIndex (float distance)
+    {
+        return (int) floor(distance / unitLength);
+    }
+    
 private:
     
     float roundToClosestGridUnit (float distance)
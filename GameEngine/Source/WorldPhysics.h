@@ -8,6 +8,10 @@
 
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "PhysicsStatistics.h"
+#include "ContactEvents.h"
+#include <functional>
+#include <vector>
 
 class WorldPhysics {
 	
@@ -17,48 +21,18 @@ public:
 		velocityIterations = 2.0f;
 		positionIterations = 6.0f;
 		timeStep = 1.0f / 15.0f;
-        /*
-        create the body first, giving it a position
-        */
-		b2BodyDef bodyDef;
-		bodyDef.position.Set(0.0f, -6.1f);
-        /*
-         body is created in the world
-         */
-        b2Body* groundBody = world.CreateBody(&bodyDef);
-        
-        /*
-         create a shape(box for this instance)
-         */
-		b2PolygonShape groundBox;
-		
-		//b2PolygonShape wallBox;
-		groundBox.SetAsBox(100000000.0f, 0.5f);
-		//wallBox.SetAsBox(0.3f, 100.0f);
-
-		
-        /*
-         assign the box shape and density to the body
-         When you attach a shape to a body using a fixture, the shape's coordinates become local to the body. So
-         when the body moves, so does the shape.
-         */
-        
-		// groundBody->CreateFixture(&groundBox, 0.0f);
-		bodyDef.position.Set(0.0f, 6.1f);
-		//groundBody = world.CreateBody(&bodyDef);
-		//groundBody->CreateFixture(&groundBox, 0.0f);
 
-		
-		bodyDef.position.Set(-8.7f, 0.0f);
-		//groundBody = world.CreateBody(&bodyDef);
-
-		//groundBody->CreateFixture(&wallBox, 0.0f);
+		// There is no ground body, falling out of the level is handled by
+		// the Level's WorldBounds without any physics body
 
-		//bodyDef.position.Set(8.7f, 0.0f);
-		world.SetAllowSleeping(false);
-		//groundBody = world.CreateBody(&bodyDef);
-		//groundBody->CreateFixture(&wallBox, 0.0f);
+		// bodies at rest are put to sleep and skipped by the solver, anything
+		// that changes a body from outside the step wakes it back up
+		world.SetAllowSleeping(true);
 		gravityLev = Normal;
+
+		// record contacts as they begin and end rather than polling bodies
+		world.SetContactListener(&contactEvents);
+		world.SetDestructionListener(&contactEvents);
 	}
 
 	~WorldPhysics()
@@ -79,6 +53,15 @@ public:
 	**************************************************************************/
 	void clearWorld() 
 	{
+		const ScopedLock lock(stepLock);
+		const ScopedLock commandScope(commandLock);
+
+		commandBuffers[0].clear();
+		commandBuffers[1].clear();
+		velocityBatch.clear();
+		queuedVelocities.clear();
+		velocitiesQueued = false;
+
         for (auto bodyObject = world.GetBodyList(); bodyObject; )
         {
             b2Body* oldBody = bodyObject;
@@ -88,11 +71,260 @@ public:
         }
 	}
 
+    /** Makes a body with one fixture. The world is locked while it is
+        stepped on the physics thread, so this waits for a step that is
+        running, as the editor may add objects as soon as the game is paused.
+     */
+    b2Body * createBody (const b2BodyDef & bodyDef, const b2FixtureDef & fixtureDef)
+    {
+        const ScopedLock lock (stepLock);
+
+        b2Body * body = world.CreateBody (&bodyDef);
+        body->CreateFixture (&fixtureDef);
+        return body;
+    }
+
     void removeObject (b2Body * bodyToDestroy)
     {
+        // Never destroy a body in the middle of a step on the physics thread
+        const ScopedLock lock (stepLock);
+        const ScopedLock commandScope (commandLock);
+
+        // Drop any commands still queued for the body
+        for (auto & buffer : commandBuffers)
+        {
+            for (size_t i = buffer.size(); i-- > 0;)
+            {
+                if (buffer[i].body == bodyToDestroy)
+                    buffer.erase (buffer.begin() + i);
+            }
+        }
+
+        for (auto velocities : { &velocityBatch, &queuedVelocities })
+        {
+            for (size_t i = velocities->size(); i-- > 0;)
+            {
+                if ((*velocities)[i].body == bodyToDestroy)
+                    velocities->erase (velocities->begin() + i);
+            }
+        }
+
+        // Destroying a body drops its contacts without waking the bodies that
+        // were resting on it, so wake them or they will float in place
+        for (b2ContactEdge* edge = bodyToDestroy->GetContactList(); edge; edge = edge->next)
+            edge->other->SetAwake (true);
+
         world.DestroyBody (bodyToDestroy);
     }
 
+	/**************************************************************************
+	*
+	*	start or finish a batched build. Bodies created while a batch is
+	*	being built start inactive, so setting their type, shape, scale
+	*	and position never touches the broadphase, and are put into the
+	*	world in a single pass once the whole level has been built
+	*	(see Level)
+	*
+	**************************************************************************/
+	void beginBatchBuild()
+	{
+		buildingBatch = true;
+	}
+
+	void endBatchBuild()
+	{
+		buildingBatch = false;
+	}
+
+	bool isBuildingBatch()
+	{
+		return buildingBatch;
+	}
+
+	/**************************************************************************
+	*
+	*	start or finish putting many bodies into the broadphase at once.
+	*	In between, new and activated bodies get their proxies without
+	*	being inserted into the tree, which is built once at the end. No
+	*	body may be moved, deactivated or destroyed in between
+	*
+	**************************************************************************/
+	void beginProxyBatch()
+	{
+		const ScopedLock lock(stepLock);
+		world.BeginProxyBatch();
+	}
+
+	void endProxyBatch()
+	{
+		const ScopedLock lock(stepLock);
+		world.EndProxyBatch();
+	}
+
+	/**************************************************************************
+	*
+	*	run a command that changes a body (its velocity, position, active
+	*	state...) as soon as no step is running. While the world is being
+	*	stepped on the physics thread the command is queued in the
+	*	recording command buffer, otherwise it is run straight away
+	*
+	**************************************************************************/
+	void runBetweenSteps(b2Body* body, std::function<void()> command)
+	{
+		const ScopedLock lock(commandLock);
+
+		if (stepInFlight.get() != 0)
+		{
+			PhysicsCommand queued;
+			queued.body = body;
+			queued.apply = command;
+			commandBuffers[recordingBuffer].push_back(queued);
+		}
+		else
+		{
+			command();
+		}
+	}
+
+	/**************************************************************************
+	*
+	*	set the linear velocity of a body between steps. Between a call to
+	*	beginVelocityBatch() and endVelocityBatch() the velocities set on
+	*	the thread that began the batch are collected, and go to the world
+	*	as a single command when it ends, instead of a command each. The AI
+	*	of the enemies sets a velocity for every enemy it runs this way
+	*	(see Level). Velocities set on other threads meanwhile are queued
+	*	as usual
+	*
+	**************************************************************************/
+	void setBodyVelocity(b2Body* body, b2Vec2 velocity)
+	{
+		{
+			const ScopedLock lock(commandLock);
+
+			if (velocityBatchThread != nullptr && velocityBatchThread == Thread::getCurrentThreadId())
+			{
+				BodyVelocity entry;
+				entry.body = body;
+				entry.velocity = velocity;
+				velocityBatch.push_back(entry);
+				return;
+			}
+		}
+
+		runBetweenSteps(body, [body, velocity] { body->SetLinearVelocity(velocity); });
+	}
+
+	void beginVelocityBatch()
+	{
+		const ScopedLock lock(commandLock);
+		velocityBatchThread = Thread::getCurrentThreadId();
+	}
+
+	void endVelocityBatch()
+	{
+		const ScopedLock lock(commandLock);
+		velocityBatchThread = nullptr;
+
+		if (velocityBatch.empty())
+			return;
+
+		// Batches ended while the last one is still queued join it
+		queuedVelocities.insert(queuedVelocities.end(), velocityBatch.begin(), velocityBatch.end());
+		velocityBatch.clear();
+
+		if (!velocitiesQueued)
+		{
+			velocitiesQueued = true;
+			runBetweenSteps(nullptr, [this] { applyQueuedVelocities(); });
+		}
+	}
+
+	/**************************************************************************
+	*
+	*	mark the start and end of a step run on the physics thread (see
+	*	PhysicsThread). Ending the step swaps the command buffers and
+	*	applies the one recorded while the step was running, outside the
+	*	command lock, while any command queued meanwhile is recorded into
+	*	the other. Swapping carries on until nothing more was recorded,
+	*	and only then are commands run straight away again
+	*
+	**************************************************************************/
+	void beginAsyncStep()
+	{
+		const ScopedLock lock(commandLock);
+		stepInFlight = 1;
+	}
+
+	void endAsyncStep()
+	{
+		// Bodies are not destroyed while their commands are being applied
+		const ScopedLock stepScope(stepLock);
+
+		for (;;)
+		{
+			std::vector<PhysicsCommand> * recorded;
+			{
+				const ScopedLock lock(commandLock);
+				recorded = &commandBuffers[recordingBuffer];
+
+				if (recorded->empty())
+				{
+					stepInFlight = 0;
+					return;
+				}
+
+				recordingBuffer = 1 - recordingBuffer;
+			}
+
+			for (auto & command : *recorded)
+				command.apply();
+
+			recorded->clear();
+		}
+	}
+
+	/**************************************************************************
+	*
+	*	true while the world is being stepped on the physics thread, body
+	*	state must only be read through the PhysicsProperties snapshots
+	*
+	**************************************************************************/
+	bool isStepInFlight()
+	{
+		return stepInFlight.get() != 0;
+	}
+
+	/**************************************************************************
+	*
+	*	allow or prevent sleeping for the whole world, disallowing it wakes
+	*	every body
+	*
+	**************************************************************************/
+	void setAllowSleeping(bool allowSleeping)
+	{
+		world.SetAllowSleeping(allowSleeping);
+	}
+
+	bool getAllowSleeping()
+	{
+		return world.GetAllowSleeping();
+	}
+
+	/**************************************************************************
+	*
+	*	wake every non-static body in the world
+	*
+	**************************************************************************/
+	void wakeAllBodies()
+	{
+		for (b2Body* body = world.GetBodyList(); body; body = body->GetNext())
+		{
+			if (body->GetType() != b2_staticBody)
+				body->SetAwake(true);
+		}
+	}
+
 	/**************************************************************************
 	*
 	*	Progress through the world using a set amount of time(timestep), and
@@ -101,7 +333,10 @@ public:
 	**************************************************************************/
 	void Step()
 	{
+		const ScopedLock lock(stepLock);
 		world.Step(this->timeStep, this->velocityIterations, this->positionIterations);
+		contactEvents.stepFinished();
+		statistics.addStep(world);
 	}
 
 	/**************************************************************************
@@ -112,7 +347,42 @@ public:
 	**************************************************************************/
 	void Step(float32 timeStep)
 	{
+		const ScopedLock lock(stepLock);
 		world.Step(timeStep, this->velocityIterations, this->positionIterations);
+		contactEvents.stepFinished();
+		statistics.addStep(world);
+	}
+
+	/**************************************************************************
+	*
+	*	return the rolling b2Profile timings and world counts, sampled
+	*	after every Step
+	*
+	**************************************************************************/
+	const PhysicsStatistics & getStatistics()
+	{
+		return statistics;
+	}
+
+	void resetStatistics()
+	{
+		statistics.reset();
+	}
+
+	/**************************************************************************
+	*
+	*	return the contacts that began and ended since the events were
+	*	last cleared. Only read them while no step is running
+	*
+	**************************************************************************/
+	const std::vector<ContactEvent> & getContactEvents()
+	{
+		return contactEvents.getEvents();
+	}
+
+	void clearContactEvents()
+	{
+		contactEvents.clear();
 	}
 	/**************************************************************************
 	*
@@ -132,6 +402,7 @@ public:
 	void setGravity(GLfloat gravx,GLfloat gravy)
 	{
 		world.SetGravity(b2Vec2(gravx,gravy));
+		wakeAllBodies();
 	}
 
 	void setGravity(gravityLevel grav)
@@ -148,6 +419,9 @@ public:
 			world.SetGravity(b2Vec2(0, -18.0));
 			break;
 		}
+
+		// sleeping bodies would otherwise ignore the new gravity
+		wakeAllBodies();
 	}
 
 	gravityLevel getGravityLevel() {
@@ -164,6 +438,19 @@ public:
 	}
 	/**************************************************************************
 	*
+	*	get the solver iterations of a step
+	*
+	**************************************************************************/
+	int32 getVelocityIterations()
+	{
+		return velocityIterations;
+	}
+	int32 getPositionIterations()
+	{
+		return positionIterations;
+	}
+	/**************************************************************************
+	*
 	*	clear all customized forces in the world
 	*
 	**************************************************************************/
@@ -237,5 +524,69 @@ private:
 	juce::int32 positionIterations;
 	float32 timeStep;
 
+	/** Whether new bodies are being held out of the world for a batched build */
+	bool buildingBatch = false;
+
+	/** Rolling profile of the steps taken in this world */
+	PhysicsStatistics statistics;
+
+	/** Contacts begun and ended since the last frame consumed them */
+	ContactEventBuffer contactEvents;
+
+	/** Sets the velocities of the batches ended since the command was
+		queued, see endVelocityBatch() */
+	void applyQueuedVelocities()
+	{
+		{
+			const ScopedLock lock(commandLock);
+			appliedVelocities.swap(queuedVelocities);
+			velocitiesQueued = false;
+		}
+
+		for (auto & entry : appliedVelocities)
+			entry.body->SetLinearVelocity(entry.velocity);
+
+		appliedVelocities.clear();
+	}
+
+	/** A change to a body recorded while the world was being stepped */
+	struct PhysicsCommand
+	{
+		b2Body* body;
+		std::function<void()> apply;
+	};
+
+	/** Commands are recorded into the back buffer while the front one is
+		applied, see endAsyncStep() */
+	std::vector<PhysicsCommand> commandBuffers[2];
+	int recordingBuffer = 0;
+
+	/** A velocity set during a velocity batch */
+	struct BodyVelocity
+	{
+		b2Body* body;
+		b2Vec2 velocity;
+	};
+
+	/** The thread collecting a velocity batch, if one is */
+	Thread::ThreadID velocityBatchThread = nullptr;
+
+	/** The batch being collected, the batches waiting for their command,
+		and the ones the command is applying */
+	std::vector<BodyVelocity> velocityBatch;
+	std::vector<BodyVelocity> queuedVelocities;
+	std::vector<BodyVelocity> appliedVelocities;
+	bool velocitiesQueued = false;
+
+	/** Set while a step is running on the physics thread */
+	Atomic<int> stepInFlight;
+
+	/** Guards the recording buffer index, the recording buffer, the in
+		flight flag and the velocity batches */
+	CriticalSection commandLock;
+
+	/** Held for the whole of a step, bodies are only destroyed outside it */
+	CriticalSection stepLock;
+
 	JUCE_LEAK_DETECTOR(WorldPhysics)
 };